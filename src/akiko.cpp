@@ -306,7 +306,7 @@ static void akiko_c2p_precalculate(void)
 	}
 }
 
-static void akiko_c2p_do(void)
+static void akiko_c2p_generic(const uae_u32 *akiko_buffer, uae_u32 *akiko_result)
 {
 	int i;
 
@@ -346,6 +346,155 @@ static void akiko_c2p_do(void)
 	}
 }
 
+/*
+* Bit matrix transpose C2P. The 32 chunky pixels of the 8 buffer longwords
+* are taken as four 8x8 bit matrices (8 pixels each, one pixel per byte)
+* and each matrix is transposed so that byte n holds bitplane n.
+*
+* input longword j byte k (k = 0 is the least significant byte) is pixel
+* 4 * (7 - j) + k, so matrix g = buffer[7 - 2g] | buffer[6 - 2g] << 32.
+*/
+
+static inline uae_u64 akiko_c2p_transpose8x8(uae_u64 x)
+{
+	uae_u64 t;
+	t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+static void akiko_c2p_swar(const uae_u32 *akiko_buffer, uae_u32 *akiko_result)
+{
+	uae_u64 m[4];
+
+	for (int g = 0; g < 4; g++) {
+		m[g] = akiko_c2p_transpose8x8(akiko_buffer[7 - 2 * g] | ((uae_u64)akiko_buffer[6 - 2 * g] << 32));
+	}
+	for (int i = 0; i < 8; i++) {
+		akiko_result[i] = (uae_u32)((m[0] >> (i * 8)) & 0xff)
+			| ((uae_u32)((m[1] >> (i * 8)) & 0xff) << 8)
+			| ((uae_u32)((m[2] >> (i * 8)) & 0xff) << 16)
+			| ((uae_u32)((m[3] >> (i * 8)) & 0xff) << 24);
+	}
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+/* pixel bytes in order, movemask collects one bitplane per step */
+static void akiko_c2p_sse2(const uae_u32 *akiko_buffer, uae_u32 *akiko_result)
+{
+	__m128i lo = _mm_set_epi32(akiko_buffer[4], akiko_buffer[5], akiko_buffer[6], akiko_buffer[7]);
+	__m128i hi = _mm_set_epi32(akiko_buffer[0], akiko_buffer[1], akiko_buffer[2], akiko_buffer[3]);
+
+	for (int i = 7; i >= 0; i--) {
+		akiko_result[i] = (uae_u32)_mm_movemask_epi8(lo) | ((uae_u32)_mm_movemask_epi8(hi) << 16);
+		lo = _mm_add_epi8(lo, lo);
+		hi = _mm_add_epi8(hi, hi);
+	}
+}
+#endif
+
+#if (defined(CPU_AARCH64) || defined(USE_ARMNEON)) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+/* two 8x8 transposes per vector */
+static void akiko_c2p_neon(const uae_u32 *akiko_buffer, uae_u32 *akiko_result)
+{
+	uint64_t in[4], m[4];
+
+	for (int g = 0; g < 4; g++) {
+		in[g] = akiko_buffer[7 - 2 * g] | ((uae_u64)akiko_buffer[6 - 2 * g] << 32);
+	}
+	uint64x2_t x0 = vld1q_u64(&in[0]);
+	uint64x2_t x1 = vld1q_u64(&in[2]);
+	uint64x2_t t0, t1;
+	uint64x2_t mask;
+
+	mask = vdupq_n_u64(0x00aa00aa00aa00aaULL);
+	t0 = vandq_u64(veorq_u64(x0, vshrq_n_u64(x0, 7)), mask);
+	t1 = vandq_u64(veorq_u64(x1, vshrq_n_u64(x1, 7)), mask);
+	x0 = veorq_u64(x0, veorq_u64(t0, vshlq_n_u64(t0, 7)));
+	x1 = veorq_u64(x1, veorq_u64(t1, vshlq_n_u64(t1, 7)));
+
+	mask = vdupq_n_u64(0x0000cccc0000ccccULL);
+	t0 = vandq_u64(veorq_u64(x0, vshrq_n_u64(x0, 14)), mask);
+	t1 = vandq_u64(veorq_u64(x1, vshrq_n_u64(x1, 14)), mask);
+	x0 = veorq_u64(x0, veorq_u64(t0, vshlq_n_u64(t0, 14)));
+	x1 = veorq_u64(x1, veorq_u64(t1, vshlq_n_u64(t1, 14)));
+
+	mask = vdupq_n_u64(0x00000000f0f0f0f0ULL);
+	t0 = vandq_u64(veorq_u64(x0, vshrq_n_u64(x0, 28)), mask);
+	t1 = vandq_u64(veorq_u64(x1, vshrq_n_u64(x1, 28)), mask);
+	x0 = veorq_u64(x0, veorq_u64(t0, vshlq_n_u64(t0, 28)));
+	x1 = veorq_u64(x1, veorq_u64(t1, vshlq_n_u64(t1, 28)));
+
+	vst1q_u64(&m[0], x0);
+	vst1q_u64(&m[2], x1);
+	for (int i = 0; i < 8; i++) {
+		akiko_result[i] = (uae_u32)((m[0] >> (i * 8)) & 0xff)
+			| ((uae_u32)((m[1] >> (i * 8)) & 0xff) << 8)
+			| ((uae_u32)((m[2] >> (i * 8)) & 0xff) << 16)
+			| ((uae_u32)((m[3] >> (i * 8)) & 0xff) << 24);
+	}
+}
+#endif
+
+typedef void (*akiko_c2p_func)(const uae_u32*, uae_u32*);
+static akiko_c2p_func akiko_c2p = akiko_c2p_generic;
+static bool akiko_c2p_selected;
+
+/*
+* C2P is a pure bit permutation, so checking every single-bit input
+* proves the fast routine identical to the generic one for all inputs.
+*/
+static bool akiko_c2p_verify(akiko_c2p_func f)
+{
+	uae_u32 in[8], ref[8], out[8];
+
+	for (int bit = 0; bit < 8 * 32; bit++) {
+		memset(in, 0, sizeof in);
+		in[bit >> 5] = 1u << (bit & 31);
+		akiko_c2p_generic(in, ref);
+		f(in, out);
+		if (memcmp(ref, out, sizeof ref))
+			return false;
+	}
+	return true;
+}
+
+static void akiko_c2p_select(void)
+{
+	const TCHAR *name;
+
+	if (akiko_c2p_selected)
+		return;
+	akiko_c2p_selected = true;
+#if defined(__SSE2__)
+	akiko_c2p = akiko_c2p_sse2;
+	name = _T("SSE2");
+#elif (defined(CPU_AARCH64) || defined(USE_ARMNEON)) && defined(__ARM_NEON)
+	akiko_c2p = akiko_c2p_neon;
+	name = _T("NEON");
+#else
+	akiko_c2p = akiko_c2p_swar;
+	name = _T("SWAR");
+#endif
+	if (!akiko_c2p_verify(akiko_c2p)) {
+		write_log(_T("AKIKO: %s C2P mismatch, using generic C2P\n"), name);
+		akiko_c2p = akiko_c2p_generic;
+	}
+}
+
+static void akiko_c2p_do(void)
+{
+	akiko_c2p(akiko_buffer, akiko_result);
+}
+
 static void akiko_c2p_write(int offset, uae_u32 v)
 {
 	if (offset == 3)
@@ -2059,6 +2208,7 @@ static void akiko_reset(int hardreset)
 	nvram_read();
 	eeprom_reset(cd32_eeprom);
 	akiko_c2p_precalculate();
+	akiko_c2p_select();
 
 	cdrom_speed = 1;
 	cdrom_current_sector = -1;
@@ -2306,3 +2456,24 @@ void akiko_mute (int muted)
 		}
 	}
 }
+
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+uae_u64 bench_akiko_c2p(bool generic, int iterations)
+{
+	uae_u32 in[8] = { 0 }, out[8];
+	uae_u32 seed = 0x0badf00d;
+
+	akiko_c2p_precalculate();
+	akiko_c2p_select();
+	akiko_c2p_func f = generic ? akiko_c2p_generic : akiko_c2p;
+	for (int i = 0; i < iterations; i++) {
+		seed = seed * 1103515245 + 12345;
+		in[i & 7] = seed;
+		f(in, out);
+		seed ^= out[i & 7];
+	}
+	return (uae_u64)iterations * sizeof in;
+}
+#endif
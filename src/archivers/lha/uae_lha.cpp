@@ -18,7 +18,7 @@ static const char *methods[] =
 	NULL
 };
 
-struct zvolume *archive_directory_lha (struct zfile *zf)
+static struct zvolume *archive_directory_lha_2 (struct zfile *zf)
 {
     struct zvolume *zv;
     struct zarchive_info zai;
@@ -72,7 +72,7 @@ struct zvolume *archive_directory_lha (struct zfile *zf)
     return zv;
 }
 
-struct zfile *archive_access_lha (struct znode *zn)
+static struct zfile *archive_access_lha_2 (struct znode *zn)
 {
     struct zfile *zf = zn->volume->archive;
     struct zfile *out = zfile_fopen_empty (zf, zn->name, zn->size);
@@ -110,3 +110,19 @@ struct zfile *archive_access_lha (struct znode *zn)
     }
     return out;
 }
+
+struct zvolume *archive_directory_lha (struct zfile *zf)
+{
+    archive_decoder_lock ();
+    struct zvolume *zv = archive_directory_lha_2 (zf);
+    archive_decoder_unlock ();
+    return zv;
+}
+
+struct zfile *archive_access_lha (struct znode *zn)
+{
+    archive_decoder_lock ();
+    struct zfile *out = archive_access_lha_2 (zn);
+    archive_decoder_unlock ();
+    return out;
+}
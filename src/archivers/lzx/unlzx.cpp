@@ -646,7 +646,7 @@ static void decrunch(struct lzxdata* d)
 	d->global_shift = shift;
 }
 
-struct zfile* archive_access_lzx(struct znode* zn)
+static struct zfile* archive_access_lzx_2(struct znode* zn)
 {
 	unsigned int startpos;
 	struct znode *znfirst, *znlast;
@@ -755,7 +755,7 @@ end:
 	return newzf;
 }
 
-struct zvolume* archive_directory_lzx(struct zfile* in_file)
+static struct zvolume* archive_directory_lzx_2(struct zfile* in_file)
 {
 	unsigned int temp;
 	unsigned int total_pack = 0;
@@ -906,3 +906,19 @@ struct zvolume* archive_directory_lzx(struct zfile* in_file)
 
 	return zv;
 }
+
+struct zfile* archive_access_lzx(struct znode* zn)
+{
+	archive_decoder_lock();
+	struct zfile* out = archive_access_lzx_2(zn);
+	archive_decoder_unlock();
+	return out;
+}
+
+struct zvolume* archive_directory_lzx(struct zfile* in_file)
+{
+	archive_decoder_lock();
+	struct zvolume* zv = archive_directory_lzx_2(in_file);
+	archive_decoder_unlock();
+	return zv;
+}
@@ -2034,7 +2034,9 @@ void audio_reset (void)
 	free_ahi_v2();
 #endif
 #endif
-	reset_sound ();
+	// a run-ahead rollback keeps the samples already queued for the host
+	if (!savestate_runahead_restoring ())
+		reset_sound ();
 	memset (sound_filter_state, 0, sizeof sound_filter_state);
 	if (!isrestore ()) {
 		for (i = 0; i < AUDIO_CHANNELS_PAULA; i++) {
@@ -3002,3 +3004,33 @@ void audio_cda_new_buffer(struct cd_audio_state *cas, uae_s16 *buffer, int lengt
 	if (cas->cda_streamid > 0)
 		audio_activate();
 }
+
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+/* A500 BLEP synthesis of four busy square-ish channels, two Paula events per output sample */
+uae_u64 bench_audio_sinc(int iterations)
+{
+	int data[AUDIO_CHANNELS_PAULA];
+	uae_u32 seed = 0x2468ace0;
+
+	for (int i = 0; i < AUDIO_CHANNELS_PAULA; i++) {
+		audio_data[i] = &audio_channel[i].data;
+		audio_channel[i].data.mixvol = 1;
+		audio_channel[i].data.adk_mask = 0xffffffff;
+	}
+	sound_use_filter_sinc = FILTER_MODEL_A500;
+	for (int n = 0; n < iterations; n++) {
+		for (int e = 0; e < 2; e++) {
+			for (int i = 0; i < AUDIO_CHANNELS_PAULA; i++) {
+				seed = seed * 1103515245 + 12345;
+				audio_channel[i].data.current_sample = (uae_s8)(seed >> 24) * 64;
+			}
+			sinc_prehandler_paula(40);
+		}
+		samplexx_sinc_handler(data, 0, AUDIO_CHANNELS_PAULA);
+	}
+	sound_use_filter_sinc = 0;
+	return (uae_u64)iterations * AUDIO_CHANNELS_PAULA * sizeof(uae_s16);
+}
+#endif
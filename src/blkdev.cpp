@@ -51,12 +51,16 @@ struct blkdevstate
 	bool mediawaschanged;
 	struct scsi_data_tape *tape;
 	bool showstatusline;
+	struct cd_block_cache *cache;
 };
 
 struct blkdevstate state[MAX_TOTAL_SCSI_DEVICES];
 
 static bool dev_init;
 
+static void cd_cache_flush (int unitnum);
+static void cd_cache_free (int unitnum);
+
 /* convert minutes, seconds and frames -> logical sector number */
 int msf2lsn (int msf)
 {
@@ -309,8 +313,10 @@ static void sys_command_close_internal (int unitnum)
 		if (st->isopen > 0)
 			st->isopen--;
 	}
+	cd_cache_flush (unitnum);
 	freesem (unitnum);
 	if (st->isopen == 0) {
+		cd_cache_free (unitnum);
 		uae_sem_destroy (&st->sema);
 		st->sema = NULL;
 	}
@@ -549,6 +555,7 @@ void device_func_free(void)
 		st->imagechangetime = 0;
 		st->cdimagefileinuse = false;
 		st->newimagefile[0] = 0;
+		cd_cache_free (i);
 	}
 	dev_init = false;
 }
@@ -650,6 +657,7 @@ static void check_changes (int unitnum)
 		st->device_func->info (unitnum, &di, 0, -1);
 		if (st->wasopen >= 0)
 			st->wasopen = di.open ? 1 : 0;
+		cd_cache_flush (unitnum);
 		if (st->wasopen) {
 			st->device_func->closedev (unitnum);
 			st->wasopen = -1;
@@ -686,6 +694,7 @@ static void check_changes (int unitnum)
 	_tcscpy (changed_prefs.cdslots[unitnum].name, st->newimagefile);
 	currprefs.cdslots[unitnum].inuse = changed_prefs.cdslots[unitnum].inuse = st->cdimagefileinuse;
 	st->newimagefile[0] = 0;
+	cd_cache_flush (unitnum);
 	write_log (_T("CD: delayed insert '%s' (open=%d,unit=%d)\n"), currprefs.cdslots[unitnum].name[0] ? currprefs.cdslots[unitnum].name : _T("<EMPTY>"), st->wasopen ? 1 : 0, unitnum);
 	device_func_init (0);
 	if (st->wasopen) {
@@ -929,14 +938,9 @@ int sys_command_cd_toc (int unitnum, struct cd_toc_head *th)
 	return v;
 }
 
-/* read one cd sector */
-int sys_command_cd_read (int unitnum, uae_u8 *data, int block, int size)
+static int cd_read_internal (int unitnum, uae_u8 *data, int block, int size)
 {
 	int v;
-	if (failunit (unitnum))
-		return 0;
-	if (!getsem (unitnum))
-		return 0;
 	if (state[unitnum].device_func->read == NULL) {
 		uae_u8 cmd1[12] = { 0x28, 0, (uae_u8)(block >> 24), (uae_u8)(block >> 16), (uae_u8)(block >> 8), (uae_u8)(block >> 0), 0, (uae_u8)(size >> 8), (uae_u8)(size >> 0), 0, 0, 0 };
 		v = do_scsi (unitnum, cmd1, sizeof cmd1, data, size * 2048);
@@ -949,9 +953,209 @@ int sys_command_cd_read (int unitnum, uae_u8 *data, int block, int size)
 	} else {
 		v = state[unitnum].device_func->read (unitnum, data, block, size);
 	}
+	return v;
+}
+
+/* read one cd sector */
+int sys_command_cd_read (int unitnum, uae_u8 *data, int block, int size)
+{
+	int v;
+	if (failunit (unitnum))
+		return 0;
+	if (!getsem (unitnum))
+		return 0;
+	v = cd_read_internal (unitnum, data, block, size);
 	freesem (unitnum);
 	return v;
 }
+
+/* Hashed LRU cache of 2048 byte data sectors, used by filesystem style
+ * readers (isofs, uaescsi.device). Misses are read as one run and, if the
+ * access is sequential, followed by read-ahead up to the end of the track.
+ * Emulated drives (CDTV, CD32) use the uncached functions because reading
+ * also stops audio playback.
+ */
+
+#define CD_CACHE_BLOCKS 1024
+#define CD_CACHE_HASH 2048
+#define CD_CACHE_MAXRUN 64
+#define CD_CACHE_READAHEAD 32
+
+struct cd_cache_block
+{
+	int block;
+	struct cd_cache_block *hashnext;
+	struct cd_cache_block *prev, *next;
+	uae_u8 data[2048];
+};
+
+struct cd_block_cache
+{
+	struct cd_cache_block *blocks;
+	struct cd_cache_block *hash[CD_CACHE_HASH];
+	struct cd_cache_block lru;
+	struct cd_toc_head toc;
+	int nextblock;
+	uae_u8 *buffer;
+};
+
+static void cd_cache_unlink (struct cd_cache_block *cb)
+{
+	cb->prev->next = cb->next;
+	cb->next->prev = cb->prev;
+}
+
+static void cd_cache_touch (struct cd_block_cache *c, struct cd_cache_block *cb)
+{
+	cd_cache_unlink (cb);
+	cb->next = c->lru.next;
+	cb->prev = &c->lru;
+	c->lru.next->prev = cb;
+	c->lru.next = cb;
+}
+
+static void cd_cache_flush (int unitnum)
+{
+	struct cd_block_cache *c = state[unitnum].cache;
+	if (!c)
+		return;
+	memset (c->hash, 0, sizeof c->hash);
+	c->lru.next = c->lru.prev = &c->lru;
+	for (int i = 0; i < CD_CACHE_BLOCKS; i++) {
+		struct cd_cache_block *cb = &c->blocks[i];
+		cb->block = -1;
+		cb->hashnext = NULL;
+		cb->prev = c->lru.prev;
+		cb->next = &c->lru;
+		c->lru.prev->next = cb;
+		c->lru.prev = cb;
+	}
+	c->toc.lastaddress = 0;
+	c->nextblock = -1;
+}
+
+static void cd_cache_free (int unitnum)
+{
+	struct cd_block_cache *c = state[unitnum].cache;
+	if (!c)
+		return;
+	xfree (c->blocks);
+	xfree (c->buffer);
+	xfree (c);
+	state[unitnum].cache = NULL;
+}
+
+static struct cd_block_cache *cd_cache_get (int unitnum)
+{
+	struct cd_block_cache *c = state[unitnum].cache;
+	if (c)
+		return c;
+	c = xcalloc (struct cd_block_cache, 1);
+	if (!c)
+		return NULL;
+	c->blocks = xcalloc (struct cd_cache_block, CD_CACHE_BLOCKS);
+	c->buffer = xmalloc (uae_u8, (CD_CACHE_MAXRUN + CD_CACHE_READAHEAD) * 2048);
+	if (!c->blocks || !c->buffer) {
+		xfree (c->blocks);
+		xfree (c->buffer);
+		xfree (c);
+		return NULL;
+	}
+	state[unitnum].cache = c;
+	cd_cache_flush (unitnum);
+	return c;
+}
+
+static struct cd_cache_block *cd_cache_find (struct cd_block_cache *c, int block)
+{
+	struct cd_cache_block *cb = c->hash[block & (CD_CACHE_HASH - 1)];
+	while (cb) {
+		if (cb->block == block)
+			return cb;
+		cb = cb->hashnext;
+	}
+	return NULL;
+}
+
+static void cd_cache_insert (struct cd_block_cache *c, int block, const uae_u8 *data)
+{
+	struct cd_cache_block *cb = cd_cache_find (c, block);
+	if (!cb) {
+		/* recycle the least recently used block */
+		cb = c->lru.prev;
+		if (cb->block >= 0) {
+			struct cd_cache_block **pp = &c->hash[cb->block & (CD_CACHE_HASH - 1)];
+			while (*pp != cb)
+				pp = &(*pp)->hashnext;
+			*pp = cb->hashnext;
+		}
+		cb->block = block;
+		cb->hashnext = c->hash[block & (CD_CACHE_HASH - 1)];
+		c->hash[block & (CD_CACHE_HASH - 1)] = cb;
+	}
+	memcpy (cb->data, data, 2048);
+	cd_cache_touch (c, cb);
+}
+
+/* read 2048 byte data sectors through the block cache */
+int sys_command_cd_read_cached (int unitnum, uae_u8 *data, int block, int size)
+{
+	struct cd_block_cache *c;
+	int end = 0x7fffffff;
+	int v = 1;
+
+	if (failunit (unitnum))
+		return 0;
+	if (size <= 0 || size > CD_CACHE_MAXRUN)
+		return sys_command_cd_read (unitnum, data, block, size);
+	c = cd_cache_get (unitnum);
+	if (!c)
+		return sys_command_cd_read (unitnum, data, block, size);
+	/* gettoc() takes the unit semaphore itself */
+	struct cd_toc *t = gettoc (unitnum, &c->toc, block);
+	if (t)
+		end = t[1].paddress;
+	if (!getsem (unitnum))
+		return 0;
+	bool sequential = block == c->nextblock;
+	while (size > 0) {
+		struct cd_cache_block *cb = cd_cache_find (c, block);
+		if (cb) {
+			memcpy (data, cb->data, 2048);
+			cd_cache_touch (c, cb);
+			data += 2048;
+			block++;
+			size--;
+			continue;
+		}
+		int cnt = 1;
+		while (cnt < size && !cd_cache_find (c, block + cnt))
+			cnt++;
+		int total = cnt;
+		if (sequential && cnt == size) {
+			total += CD_CACHE_READAHEAD;
+			if (block + total > end)
+				total = end - block > cnt ? end - block : cnt;
+		}
+		v = cd_read_internal (unitnum, c->buffer, block, total);
+		if (!v && total > cnt) {
+			total = cnt;
+			v = cd_read_internal (unitnum, c->buffer, block, total);
+		}
+		if (!v)
+			break;
+		for (int i = 0; i < total; i++)
+			cd_cache_insert (c, block + i, c->buffer + i * 2048);
+		memcpy (data, c->buffer, cnt * 2048);
+		data += cnt * 2048;
+		block += cnt;
+		size -= cnt;
+	}
+	c->nextblock = block;
+	freesem (unitnum);
+	return v;
+}
+
 int sys_command_cd_rawread (int unitnum, uae_u8 *data, int block, int size, int sectorsize)
 {
 	int v;
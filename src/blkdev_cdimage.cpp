@@ -54,7 +54,6 @@ struct cdtoc
 {
 	struct zfile *handle;
 	uae_s64 offset;
-	uae_u8 *data;
 	struct zfile *subhandle;
 	int suboffset;
 	uae_u8 *subdata;
@@ -71,7 +70,6 @@ struct cdtoc
 	int pregap; // sectors of silence
 	int postgap; // sectors of silence
 	audenc enctype;
-	int writeoffset;
 	int subcode;
 #ifdef WITH_CHD
 	const cdrom_track_info *chdtrack;
@@ -119,6 +117,39 @@ static volatile int cdimage_unpack_thread, cdimage_unpack_active;
 static smp_comm_pipe unpack_pipe;
 static uae_sem_t play_sem;
 
+/*
+* Compressed audio tracks are decoded incrementally by the unpack thread
+* into a ring buffer that runs a few seconds ahead of the play position.
+*/
+#define CDDA_STREAM_AHEAD (4 * 75 * 2352)
+#define CDDA_STREAM_BACK (1 * 75 * 2352)
+#define CDDA_STREAM_CHUNK 32768
+#define CDDA_STREAM_SIZE (CDDA_STREAM_AHEAD + CDDA_STREAM_BACK + 2 * CDDA_STREAM_CHUNK)
+// longest time the play thread waits for the decoder per read
+#define CDDA_STREAM_WAIT_MS 100
+
+struct cdda_stream
+{
+	uae_sem_t lock;
+	uae_sem_t wake;
+	// posted by the unpack thread when buffer state changed
+	uae_sem_t avail;
+	uae_u8 *buffer;
+	// PCM byte range of track currently in buffer
+	struct cdtoc *track;
+	uae_s64 start, end;
+	uae_s64 readpos;
+	bool eof;
+	// pending seek request from play thread
+	struct cdtoc *seektrack;
+	uae_s64 seekpos;
+	// decoder, only accessed by the unpack thread
+	struct cdtoc *dectrack;
+	mp3decoder *mp3dec;
+	FLAC__StreamDecoder *flacdec;
+};
+static struct cdda_stream cdstream;
+
 static struct cdunit *unitisopen (int unitnum)
 {
 	struct cdunit *cdu = &cdunits[unitnum];
@@ -197,7 +228,7 @@ static int do_read (struct cdunit *cdu, struct cdtoc *t, uae_u8 *data, int secto
 static void flac_metadata_callback (const FLAC__StreamDecoder *decoder, const FLAC__StreamMetadata *metadata, void *client_data)
 {
 	struct cdtoc *t = (struct cdtoc*)client_data;
-	if (t->data)
+	if (cdstream.dectrack == t)
 		return;
 	if(metadata->type == FLAC__METADATA_TYPE_STREAMINFO) {
 		t->filesize = metadata->data.stream_info.total_samples * (metadata->data.stream_info.bits_per_sample / 8) * metadata->data.stream_info.channels;
@@ -209,15 +240,24 @@ static void flac_error_callback (const FLAC__StreamDecoder *decoder, FLAC__Strea
 {
 	return;
 }
+static void cdda_stream_append (const uae_u8 *data, int size);
 static FLAC__StreamDecoderWriteStatus flac_write_callback (const FLAC__StreamDecoder *decoder, const FLAC__Frame *frame, const FLAC__int32 * const buffer[], void *client_data)
 {
 	struct cdtoc *t = (struct cdtoc*)client_data;
-	uae_u16 *p = (uae_u16*)(t->data + t->writeoffset);
-	int size = 4;
-	for (int i = 0; i < frame->header.blocksize && t->writeoffset < t->filesize - size; i++, t->writeoffset += size) {
-		*p++ = (FLAC__int16)buffer[0][i];
-		*p++ = (FLAC__int16)buffer[1][i];
+	uae_u16 tmp[1024 * 2];
+	int cnt = 0;
+	if (cdstream.dectrack != t)
+		return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+	for (int i = 0; i < frame->header.blocksize; i++) {
+		tmp[cnt++] = (FLAC__int16)buffer[0][i];
+		tmp[cnt++] = (FLAC__int16)buffer[frame->header.channels > 1 ? 1 : 0][i];
+		if (cnt == sizeof tmp / sizeof(uae_u16)) {
+			cdda_stream_append ((uae_u8*)tmp, cnt * 2);
+			cnt = 0;
+		}
 	}
+	if (cnt)
+		cdda_stream_append ((uae_u8*)tmp, cnt * 2);
 	return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
 static FLAC__StreamDecoderReadStatus file_read_callback (const FLAC__StreamDecoder *decoder, FLAC__byte buffer[], size_t *bytes, void *client_data)
@@ -265,10 +305,8 @@ static void flac_get_size (struct cdtoc *t)
 		FLAC__stream_decoder_delete (decoder);
 	}
 }
-static uae_u8 *flac_get_data (struct cdtoc *t)
+static FLAC__StreamDecoder *flac_open (struct cdtoc *t)
 {
-	write_log (_T("FLAC: unpacking '%s'..\n"), zfile_getname (t->handle));
-	t->writeoffset = 0;
 	FLAC__StreamDecoder *decoder = FLAC__stream_decoder_new ();
 	if (decoder) {
 		FLAC__stream_decoder_set_md5_checking (decoder, false);
@@ -276,11 +314,12 @@ static uae_u8 *flac_get_data (struct cdtoc *t)
 			&file_read_callback, &file_seek_callback, &file_tell_callback,
 			&file_len_callback, &file_eof_callback,
 			&flac_write_callback, &flac_metadata_callback, &flac_error_callback, t);
-		FLAC__stream_decoder_process_until_end_of_stream (decoder);
-		FLAC__stream_decoder_delete (decoder);
-		write_log (_T("FLAC: %s unpacked\n"), zfile_getname (t->handle));
+		if (init_status != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+			FLAC__stream_decoder_delete (decoder);
+			return NULL;
+		}
 	}
-	return t->data;
+	return decoder;
 }
 
 void sub_to_interleaved (const uae_u8 *s, uae_u8 *d)
@@ -392,12 +431,212 @@ static int setstate (struct cdunit *cdu, int state, int playpos)
 	return 0;
 }
 
+// called by the unpack thread with decoded PCM data
+static void cdda_stream_append (const uae_u8 *data, int size)
+{
+	uae_sem_wait (&cdstream.lock);
+	// stale data if seek is pending
+	if (cdstream.seektrack == NULL && cdstream.track == cdstream.dectrack) {
+		while (size > 0) {
+			int pos = (int)(cdstream.end % CDDA_STREAM_SIZE);
+			int len = CDDA_STREAM_SIZE - pos;
+			if (len > size)
+				len = size;
+			memcpy (cdstream.buffer + pos, data, len);
+			cdstream.end += len;
+			data += len;
+			size -= len;
+		}
+		if (cdstream.end - cdstream.start > CDDA_STREAM_SIZE)
+			cdstream.start = cdstream.end - CDDA_STREAM_SIZE;
+	}
+	uae_sem_post (&cdstream.lock);
+	uae_sem_post (&cdstream.avail);
+}
+
+static void cdda_stream_close_decoder (void)
+{
+	if (cdstream.mp3dec)
+		cdstream.mp3dec->close ();
+	if (cdstream.flacdec) {
+		FLAC__stream_decoder_delete (cdstream.flacdec);
+		cdstream.flacdec = NULL;
+	}
+	cdstream.dectrack = NULL;
+}
+
+static bool cdda_stream_open_decoder (struct cdtoc *t)
+{
+	if (cdstream.dectrack == t)
+		return true;
+	cdda_stream_close_decoder ();
+	if (t->enctype == AUDENC_MP3) {
+		if (!cdstream.mp3dec) {
+			try {
+				cdstream.mp3dec = new mp3decoder();
+			} catch (exception) { };
+		}
+		if (!cdstream.mp3dec || !cdstream.mp3dec->open (t->handle))
+			return false;
+	} else if (t->enctype == AUDENC_FLAC) {
+		cdstream.flacdec = flac_open (t);
+		if (!cdstream.flacdec)
+			return false;
+	} else {
+		return false;
+	}
+	cdstream.dectrack = t;
+	return true;
+}
+
+// process pending seek, returns false if nothing to do
+static bool cdda_stream_seek (void)
+{
+	uae_sem_wait (&cdstream.lock);
+	struct cdtoc *t = cdstream.seektrack;
+	uae_s64 pos = cdstream.seekpos & ~3;
+	if (!t) {
+		uae_sem_post (&cdstream.lock);
+		return false;
+	}
+	cdstream.seektrack = NULL;
+	cdstream.track = t;
+	cdstream.start = cdstream.end = cdstream.readpos = pos;
+	cdstream.eof = false;
+	uae_sem_post (&cdstream.lock);
+
+	bool ok = cdda_stream_open_decoder (t);
+	if (ok) {
+		if (t->enctype == AUDENC_MP3) {
+			ok = cdstream.mp3dec->seek (pos);
+		} else {
+			// seeking outputs the frame containing the target sample
+			ok = FLAC__stream_decoder_seek_absolute (cdstream.flacdec, pos / 4) != 0;
+			if (!ok && FLAC__stream_decoder_get_state (cdstream.flacdec) == FLAC__STREAM_DECODER_SEEK_ERROR)
+				FLAC__stream_decoder_flush (cdstream.flacdec);
+		}
+	}
+	if (!ok) {
+		write_log (_T("IMAGE CDDA: '%s' seek to %lld failed\n"), zfile_getname (t->handle), pos);
+		uae_sem_wait (&cdstream.lock);
+		cdstream.eof = true;
+		uae_sem_post (&cdstream.lock);
+		uae_sem_post (&cdstream.avail);
+	}
+	return true;
+}
+
+// decode next block if play position is not far enough behind, returns false if idle
+static bool cdda_stream_fill (void)
+{
+	uae_sem_wait (&cdstream.lock);
+	bool need = cdstream.track && cdstream.track == cdstream.dectrack && !cdstream.eof &&
+		cdstream.end - cdstream.readpos < CDDA_STREAM_AHEAD;
+	uae_sem_post (&cdstream.lock);
+	if (!need)
+		return false;
+
+	bool eof = false;
+	if (cdstream.mp3dec && cdstream.dectrack->enctype == AUDENC_MP3) {
+		uae_u8 tmp[CDDA_STREAM_CHUNK];
+		int len = cdstream.mp3dec->read (tmp, sizeof tmp);
+		if (len > 0)
+			cdda_stream_append (tmp, len);
+		else
+			eof = true;
+	} else if (cdstream.flacdec) {
+		if (!FLAC__stream_decoder_process_single (cdstream.flacdec) ||
+			FLAC__stream_decoder_get_state (cdstream.flacdec) == FLAC__STREAM_DECODER_END_OF_STREAM)
+			eof = true;
+	}
+	if (eof) {
+		uae_sem_wait (&cdstream.lock);
+		cdstream.eof = true;
+		uae_sem_post (&cdstream.lock);
+		uae_sem_post (&cdstream.avail);
+	}
+	return true;
+}
+
+/*
+* Copy decoded audio to dst, waiting a bounded time for the unpack thread if needed.
+* Returns false if data did not become available (dst is left untouched).
+*/
+static bool cdda_stream_read (struct cdtoc *t, uae_s64 pos, uae_u8 *dst, int size)
+{
+	bool ok = false;
+	Uint32 deadline = SDL_GetTicks () + CDDA_STREAM_WAIT_MS;
+
+	uae_sem_wait (&cdstream.lock);
+	if (cdstream.track != t || cdstream.seektrack || pos < cdstream.start || pos > cdstream.end + CDDA_STREAM_AHEAD) {
+		cdstream.seektrack = t;
+		cdstream.seekpos = pos;
+	}
+	cdstream.readpos = pos;
+	for (;;) {
+		if (!cdstream.seektrack && cdstream.track == t) {
+			if (pos >= cdstream.start && pos + size <= cdstream.end) {
+				ok = true;
+				break;
+			}
+			if (cdstream.eof) {
+				// partial block at end of track
+				if (pos >= cdstream.start && pos < cdstream.end) {
+					size = (int)(cdstream.end - pos);
+					ok = true;
+				}
+				break;
+			}
+		}
+		// state was just checked under the lock, older posts are stale
+		while (uae_sem_trywait (&cdstream.avail) == 0);
+		uae_sem_post (&cdstream.lock);
+		uae_sem_post (&cdstream.wake);
+		if (cdimage_unpack_thread <= 0)
+			return false;
+		Sint32 left = (Sint32)(deadline - SDL_GetTicks ());
+		if (left <= 0 || uae_sem_trywait_delay (&cdstream.avail, left) != 0) {
+			write_log (_T("IMAGE CDDA: '%s' decoder timeout at %lld\n"), zfile_getname (t->handle), pos);
+			return false;
+		}
+		uae_sem_wait (&cdstream.lock);
+	}
+	if (ok) {
+		while (size > 0) {
+			int rpos = (int)(pos % CDDA_STREAM_SIZE);
+			int len = CDDA_STREAM_SIZE - rpos;
+			if (len > size)
+				len = size;
+			memcpy (dst, cdstream.buffer + rpos, len);
+			dst += len;
+			pos += len;
+			size -= len;
+		}
+		cdstream.readpos = pos;
+	}
+	uae_sem_post (&cdstream.lock);
+	uae_sem_post (&cdstream.wake);
+	return ok;
+}
+
 static int cdda_unpack_func (void *v)
 {
+	uae_sem_init (&cdstream.lock, 0, 1);
+	uae_sem_init (&cdstream.wake, 0, 0);
+	uae_sem_init (&cdstream.avail, 0, 0);
+	cdstream.buffer = xmalloc (uae_u8, CDDA_STREAM_SIZE);
+	cdstream.track = cdstream.seektrack = NULL;
 	cdimage_unpack_thread = 1;
-	mp3decoder *mp3dec = NULL;
 
 	for (;;) {
+		if (!comm_pipe_has_data (&unpack_pipe)) {
+			if (cdda_stream_seek ())
+				continue;
+			if (cdda_stream_fill ())
+				continue;
+			uae_sem_trywait_delay (&cdstream.wake, 100);
+			continue;
+		}
 		uae_u32 cduidx = read_comm_pipe_u32_blocking (&unpack_pipe);
 		if (cdimage_unpack_thread == 0)
 			break;
@@ -406,32 +645,32 @@ static int cdda_unpack_func (void *v)
 		struct cdtoc *t = &cdu->toc[tocidx];
 		if (t->handle) {
 			// force unpack if handle points to delayed zipped file
+			cdimage_unpack_active = 1;
 			uae_s64 pos = zfile_ftell (t->handle);
 			zfile_fseek (t->handle, -1, SEEK_END);
 			uae_u8 b;
 			zfile_fread (&b, 1, 1, t->handle);
 			zfile_fseek (t->handle, pos, SEEK_SET);
-			if (!t->data && (t->enctype == AUDENC_MP3 || t->enctype == AUDENC_FLAC)) {
-				t->data = xcalloc (uae_u8, (int)t->filesize + 2352);
-				cdimage_unpack_active = 1;
-				if (t->data) {
-					if (t->enctype == AUDENC_MP3) {
-						if (!mp3dec) {
-							try {
-								mp3dec = new mp3decoder();
-							} catch (exception) { };
-						}
-						if (mp3dec)
-							t->data = mp3dec->get (t->handle, t->data, (int)t->filesize);
-					} else if (t->enctype == AUDENC_FLAC) {
-						flac_get_data (t);
-					}
+			if (t->enctype == AUDENC_MP3 || t->enctype == AUDENC_FLAC) {
+				// open decoder and start decoding from track start
+				uae_sem_wait (&cdstream.lock);
+				if (cdstream.track != t && !cdstream.seektrack) {
+					cdstream.seektrack = t;
+					cdstream.seekpos = 0;
 				}
+				uae_sem_post (&cdstream.lock);
 			}
 		}
 		cdimage_unpack_active = 2;
 	}
-	delete mp3dec;
+	cdda_stream_close_decoder ();
+	delete cdstream.mp3dec;
+	cdstream.mp3dec = NULL;
+	xfree (cdstream.buffer);
+	cdstream.buffer = NULL;
+	uae_sem_destroy (&cdstream.wake);
+	uae_sem_destroy (&cdstream.avail);
+	uae_sem_destroy (&cdstream.lock);
 	cdimage_unpack_thread = -1;
 	return 0;
 }
@@ -445,6 +684,7 @@ static void audio_unpack(struct cdunit *cdu, struct cdtoc *t)
 	cdimage_unpack_active = 0;
 	write_comm_pipe_u32(&unpack_pipe, addrdiff(cdu, &cdunits[0]), 0);
 	write_comm_pipe_u32(&unpack_pipe, addrdiff(t, &cdu->toc[0]), 1);
+	uae_sem_post(&cdstream.wake);
 	while (cdimage_unpack_active == 0)
 		sleep_millis(10);
 }
@@ -652,9 +892,11 @@ static bool cdda_play_func2 (struct cdunit *cdu, int *outpos)
 							int totalsize = t->size + t->skipsize;
 							int offset = (int)t->offset;
 							if (offset >= 0) {
-								if ((t->enctype == AUDENC_MP3 || t->enctype == AUDENC_FLAC) && t->data) {
-									if (t->filesize >= sector * totalsize + offset + t->size)
-										memcpy (dst, t->data + sector * totalsize + offset, t->size);
+								if (t->enctype == AUDENC_MP3 || t->enctype == AUDENC_FLAC) {
+									// decoder fell behind: play silence rather than stall the CD
+									if (t->filesize < sector * totalsize + offset + t->size ||
+										!cdda_stream_read (t, (uae_s64)sector * totalsize + offset, dst, t->size))
+										memset (dst, 0, t->size);
 								} else if (t->enctype == AUDENC_PCM) {
 									if (sector * totalsize + offset + totalsize < t->filesize) {
 										zfile_fseek (t->handle, (uae_u64)sector * totalsize + offset, SEEK_SET);
@@ -2236,7 +2478,6 @@ static void unload_image (struct cdunit *cdu)
 		if (t->handle != t->subhandle)
 			zfile_fclose (t->subhandle);
 		xfree (t->fname);
-		xfree (t->data);
 		xfree (t->subdata);
 		xfree (t->extrainfo);
 	}
@@ -1026,34 +1026,69 @@ static uae_u32 REGPARAM2 bsdsocklib_Dup2Socket (TrapContext *ctx)
 #define MSG_EOR		0x08	/* data completes record */
 #define	MSG_TRUNC	0x10	/* data discarded before delivery */
 
+#define MSGHDR_LONGS 7	/* name, namelen, iov, iovlen, control, controllen, flags */
+#define MSG_MAXIOV	1024
+
+/* Fetch the msghdr and its iovec array with two bulk transfers
+ * instead of one trap round trip per field */
+static uae_u32 *bsdsocklib_getmsghdr(TrapContext *ctx, struct socketbase *sb, uaecptr msg, uae_u32 *hdr, int *total)
+{
+	uae_u32 *iov;
+	int iovlen;
+
+	trap_get_longs(ctx, hdr, msg, MSGHDR_LONGS);
+	iovlen = hdr[3];
+	if (iovlen > MSG_MAXIOV) {
+		bsdsocklib_seterrno(ctx, sb, 22); // EINVAL
+		return NULL;
+	}
+	if (iovlen < 0)
+		iovlen = hdr[3] = 0;
+	iov = xmalloc(uae_u32, iovlen * 2 + 1);
+	if (!iov) {
+		bsdsocklib_seterrno(ctx, sb, 55); // ENOBUFS
+		return NULL;
+	}
+	trap_get_longs(ctx, iov, hdr[2], iovlen * 2);
+	*total = 0;
+	for (int i = 0; i < iovlen; i++) {
+		int cnt = iov[i * 2 + 1];
+		if (*total + cnt < *total) {
+			xfree(iov);
+			return NULL;
+		}
+		*total += cnt;
+	}
+	if (*total < 0) {
+		bsdsocklib_seterrno(ctx, sb, 22); // EINVAL
+		xfree(iov);
+		return NULL;
+	}
+	return iov;
+}
+
 static uae_u32 REGPARAM2 bsdsocklib_sendmsg (TrapContext *ctx)
 {
 	struct socketbase *sb = get_socketbase (ctx);
 	uaecptr sd = trap_get_dreg(ctx, 0);
 	uaecptr msg = trap_get_areg(ctx, 0);
 	uae_u32 flags = trap_get_dreg(ctx, 1);
+	uae_u32 hdr[MSGHDR_LONGS];
+	struct trap_batch tb;
+	int total;
 
 	SOCKET s = getsock (ctx, sb, sd + 1);
 	if (s == INVALID_SOCKET)
 		return -1;
 
-	int iovlen = trap_get_long(ctx, msg + 12);
-	int total = 0;
-	uaecptr iovec = trap_get_long(ctx, msg + 8);
-	for (int i = 0; i < iovlen; i++) {
-		uaecptr iovecp = iovec + i * 8;
-		int cnt = trap_get_long(ctx, iovecp + 4);
-		if (total + cnt < total)
-			return -1;
-		total += cnt;
-	}
-	if (total < 0) {
-		bsdsocklib_seterrno(ctx, sb, 22); // EINVAL
+	uae_u32 *iov = bsdsocklib_getmsghdr(ctx, sb, msg, hdr, &total);
+	if (!iov)
 		return -1;
-	}
-	if (trap_get_long(ctx, msg + 16)) { // msg_control
-		if (trap_get_long(ctx, msg + 20) < 10) { // msg_controllen
+	int iovlen = hdr[3];
+	if (hdr[4]) { // msg_control
+		if (hdr[5] < 10) { // msg_controllen
 			bsdsocklib_seterrno(ctx, sb, 22); // EINVAL
+			xfree(iov);
 			return -1;
 		}
 		// control is not supported
@@ -1061,18 +1096,21 @@ static uae_u32 REGPARAM2 bsdsocklib_sendmsg (TrapContext *ctx)
 	uae_u8 *data = xmalloc(uae_u8, total);
 	if (!data) {
 		bsdsocklib_seterrno(ctx, sb, 55); // ENOBUFS
+		xfree(iov);
 		return -1;
 	}
 	uae_u8 *p = data;
+	trap_batch_init(ctx, &tb);
 	for (int i = 0; i < iovlen; i++) {
-		uaecptr iovecp = iovec + i * 8;
-		int cnt = trap_get_long(ctx, iovecp + 4);
-		trap_get_bytes(ctx, p, trap_get_long(ctx, iovecp), cnt);
+		int cnt = iov[i * 2 + 1];
+		trap_batch_get_bytes(&tb, p, iov[i * 2], cnt);
 		p += cnt;
 	}
-	uaecptr to = trap_get_long(ctx, msg + 0);
+	trap_batch_run(&tb);
+	uaecptr to = hdr[0];
 	host_sendto(ctx, sb, sd, 0, data, total, flags, to, msg + 4);
 	xfree(data);
+	xfree(iov);
 	return sb->resultval;
 }
 
@@ -1082,43 +1120,37 @@ static uae_u32 REGPARAM2 bsdsocklib_recvmsg (TrapContext *ctx)
 	uaecptr sd = trap_get_dreg(ctx, 0);
 	uaecptr msg = trap_get_areg(ctx, 0);
 	uae_u32 flags = trap_get_dreg(ctx, 1);
+	uae_u32 hdr[MSGHDR_LONGS];
+	struct trap_batch tb;
+	int total;
 
 	SOCKET s = getsock (ctx, sb, sd + 1);
 	if (s == INVALID_SOCKET)
 		return -1;
 
-	uae_u32 msg_flags = trap_get_long(ctx, msg + 24);
-	int iovlen = trap_get_long(ctx, msg + 12);
-	int total = 0;
-	uaecptr iovec = trap_get_long(ctx, msg + 8);
-	for (int i = 0; i < iovlen; i++) {
-		uaecptr iovecp = iovec + i * 8;
-		int cnt = trap_get_long(ctx, iovecp + 4);
-		if (total + cnt < total)
-			return -1;
-		total += cnt;
-	}
-	if (total < 0) {
-		bsdsocklib_seterrno(ctx, sb, 22); // EINVAL
+	uae_u32 *iov = bsdsocklib_getmsghdr(ctx, sb, msg, hdr, &total);
+	if (!iov)
 		return -1;
-	}
+	uae_u32 msg_flags = hdr[6];
+	int iovlen = hdr[3];
 	uae_u8 *data = xmalloc(uae_u8, total);
 	if (!data) {
 		bsdsocklib_seterrno(ctx, sb, 55); // ENOBUFS
+		xfree(iov);
 		return -1;
 	}
-	uaecptr from = trap_get_long(ctx, msg + 0);
+	uaecptr from = hdr[0];
 	host_recvfrom(ctx, sb, sd, 0, data, total, flags, from, msg + 4);
 	if (sb->resultval > 0) {
 		uae_u8 *p = data;
 		int total2 = 0;
 		total = sb->resultval;
+		trap_batch_init(ctx, &tb);
 		for (int i = 0; i < iovlen && total > 0; i++) {
-			uaecptr iovecp = iovec + i * 8;
-			int cnt = trap_get_long(ctx, iovecp + 4);
+			int cnt = iov[i * 2 + 1];
 			if (cnt > total)
 				cnt = total;
-			trap_put_bytes(ctx, p, trap_get_long(ctx, iovecp), cnt);
+			trap_batch_put_bytes(&tb, p, iov[i * 2], cnt);
 			p += cnt;
 			total -= cnt;
 			total2 += cnt;
@@ -1127,9 +1159,11 @@ static uae_u32 REGPARAM2 bsdsocklib_recvmsg (TrapContext *ctx)
 			msg_flags |= MSG_EOR;
 		if (total > 0 && (sb->ftable[sd - 1] & SF_DGRAM))
 			msg_flags |= MSG_TRUNC;
-		trap_put_long(ctx, msg + 24, msg_flags);
+		trap_batch_put_long(&tb, msg + 24, msg_flags);
+		trap_batch_run(&tb);
 	}
 	xfree(data);
+	xfree(iov);
 	return sb->resultval;
 }
 
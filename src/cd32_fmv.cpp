@@ -802,77 +802,75 @@ static void cl450_write_dram(int addr, uae_u16 w)
 static struct zfile *videodump;
 #endif
 
-static void cl450_parse_frame(void)
+/* MPEG decoding and colour conversion run on a separate thread. A decode
+ * step feeds at most one chunk of bitstream to libmpeg2 and parses until a
+ * picture is complete or the input runs out. Steps are started from the
+ * hsync handler and their results (status, DRAM variables and the decoded
+ * frame) are applied CL450_DECODE_LINES scanlines later, waiting for the
+ * thread if it is not done yet, so what the guest sees only depends on
+ * emulated time.
+ */
+#define CL450_DECODE_LINES 128
+
+struct cl450_decode
+{
+	uae_u8 *buf, *bufend;
+	int pixbytes;
+	int slot;
+	bool needdata;
+	bool sequence;
+	int frame_rate, width, height;
+	bool gop;
+	uae_u16 time_code[2];
+	bool frame;
+};
+static struct cl450_decode cl450_decode_job;
+static uae_sem_t cl450_decode_start, cl450_decode_done;
+static uae_thread_id cl450_decode_tid;
+static volatile bool cl450_decode_quit;
+static bool cl450_decode_busy;
+static bool cl450_decode_needdata = true;
+static int cl450_decode_lines;
+static int cl450_decode_width, cl450_decode_height, cl450_decode_pixbytes;
+
+static void cl450_decode_step(struct cl450_decode *d)
 {
+	d->needdata = d->sequence = d->gop = d->frame = false;
+	if (d->buf)
+		mpeg2_buffer(mpeg_decoder, d->buf, d->bufend);
 	for (;;) {
 		mpeg2_state_t mpeg_state = mpeg2_parse(mpeg_decoder);
 		switch (mpeg_state)
 		{
 			case STATE_BUFFER:
-			{
-				int bufsize = cl450_buffer_offset;
-				if (bufsize == 0)
-					return;
-				while (bufsize > 0 && cl450_newpacket_mode) {
-					struct cl450_newpacket *np = &cl450_newpacket_buffer[cl450_newpacket_offset_read];
-					if (cl450_newpacket_offset_read == cl450_newpacket_offset_write)
-						return;
-					int size = np->length > bufsize ? bufsize : np->length;
-
-					if (np->length == 0) {
-						write_log(_T("CL450 no matching newpacket!?\n"));
-						return;
-					}
-
-					np->length -= size;
-					bufsize -= size;
-					if (np->length > 0)
-						break;
-					//write_log(_T("CL450: NewPacket %d done\n"), cl450_newpacket_offset_read);
-					cl450_newpacket_offset_read++;
-					cl450_newpacket_offset_read &= CL450_NEWPACKET_BUFFER_SIZE - 1;
-				}
-#if DUMP_VIDEO
-				if (!videodump)
-					videodump = zfile_fopen(_T("c:\\temp\\1.mpg"), _T("wb"));
-				zfile_fwrite(&ram[CL450_MPEG_BUFFER], 1, cl450_buffer_offset, videodump);
-#endif
-				memcpy(&fmv_ram_bank.baseaddr[CL450_MPEG_DECODE_BUFFER] + libmpeg_offset, &fmv_ram_bank.baseaddr[CL450_MPEG_BUFFER], cl450_buffer_offset);
-				mpeg2_buffer(mpeg_decoder, &fmv_ram_bank.baseaddr[CL450_MPEG_DECODE_BUFFER] + libmpeg_offset, &fmv_ram_bank.baseaddr[CL450_MPEG_DECODE_BUFFER] + libmpeg_offset + cl450_buffer_offset);
-				libmpeg_offset += cl450_buffer_offset;
-				if (libmpeg_offset >= CL450_MPEG_DECODE_BUFFER_SIZE - CL450_MPEG_BUFFER_SIZE)
-					libmpeg_offset = 0;
-				cl450_buffer_offset = 0;
-			}
-			break;
+				d->needdata = true;
+				return;
 			case STATE_SEQUENCE:
-				cl450_frame_pixbytes = currprefs.color_mode != 5 ? 2 : 4;
-				mpeg2_convert(mpeg_decoder, cl450_frame_pixbytes == 2 ? mpeg2convert_rgb16 : mpeg2convert_rgb32, NULL);
-				cl450_set_status(CL_INT_SEQ_V);
-				cl450_frame_rate = mpeg_info->sequence->frame_period ? 27000000 / mpeg_info->sequence->frame_period : 0;
-				cl450_frame_width = mpeg_info->sequence->width;
-				cl450_frame_height = mpeg_info->sequence->height;
-				cl450_write_dram(CL_DRAM_PICTURE_RATE, cl450_frame_rate);
-				cl450_write_dram(CL_DRAM_H_SIZE, cl450_frame_width);
-				cl450_write_dram(CL_DRAM_V_SIZE, cl450_frame_height);
+				cl450_decode_pixbytes = d->pixbytes;
+				mpeg2_convert(mpeg_decoder, cl450_decode_pixbytes == 2 ? mpeg2convert_rgb16 : mpeg2convert_rgb32, NULL);
+				cl450_decode_width = mpeg_info->sequence->width;
+				cl450_decode_height = mpeg_info->sequence->height;
+				d->sequence = true;
+				d->frame_rate = mpeg_info->sequence->frame_period ? 27000000 / mpeg_info->sequence->frame_period : 0;
+				d->width = cl450_decode_width;
+				d->height = cl450_decode_height;
 				break;
 			case STATE_PICTURE:
 				break;
 			case STATE_GOP:
-				cl450_write_dram(CL_DRAM_TIME_CODE_0, (mpeg_info->gop->hours << 6) | (mpeg_info->gop->minutes));
-				cl450_write_dram(CL_DRAM_TIME_CODE_1, (mpeg_info->gop->seconds << 6) | (mpeg_info->gop->pictures));
+				d->gop = true;
+				d->time_code[0] = (mpeg_info->gop->hours << 6) | (mpeg_info->gop->minutes);
+				d->time_code[1] = (mpeg_info->gop->seconds << 6) | (mpeg_info->gop->pictures);
 				break;
 			case STATE_SLICE:
 			case STATE_END:
 				if (mpeg_info->display_fbuf) {
-					memcpy(videoram[cl450_videoram_write].data, mpeg_info->display_fbuf->buf[0], cl450_frame_width * cl450_frame_height * cl450_frame_pixbytes);
-					videoram[cl450_videoram_write].width = cl450_frame_width;
-					videoram[cl450_videoram_write].height = cl450_frame_height;
-					videoram[cl450_videoram_write].depth = cl450_frame_pixbytes;
-					cl450_videoram_write++;
-					cl450_videoram_write &= CL450_VIDEO_BUFFERS - 1;
-					cl450_videoram_cnt++;
-					//write_log(_T("%d\n"), cl450_videoram_cnt);
+					struct cl450_videoram *v = &videoram[d->slot];
+					memcpy(v->data, mpeg_info->display_fbuf->buf[0], cl450_decode_width * cl450_decode_height * cl450_decode_pixbytes);
+					v->width = cl450_decode_width;
+					v->height = cl450_decode_height;
+					v->depth = cl450_decode_pixbytes;
+					d->frame = true;
 				}
 				return;
 			default:
@@ -881,6 +879,131 @@ static void cl450_parse_frame(void)
 	}
 }
 
+static int cl450_decode_thread(void *v)
+{
+	for (;;) {
+		uae_sem_wait(&cl450_decode_start);
+		if (cl450_decode_quit)
+			break;
+		cl450_decode_step(&cl450_decode_job);
+		uae_sem_post(&cl450_decode_done);
+	}
+	return 0;
+}
+
+static void cl450_decode_wait(void)
+{
+	if (!cl450_decode_busy)
+		return;
+	if (cl450_decode_tid)
+		uae_sem_wait(&cl450_decode_done);
+	cl450_decode_busy = false;
+}
+
+// apply the results of the step in flight
+static void cl450_decode_finish(void)
+{
+	struct cl450_decode *d = &cl450_decode_job;
+
+	cl450_decode_wait();
+	cl450_decode_needdata = d->needdata;
+	if (d->sequence) {
+		cl450_frame_pixbytes = d->pixbytes;
+		cl450_set_status(CL_INT_SEQ_V);
+		cl450_frame_rate = d->frame_rate;
+		cl450_frame_width = d->width;
+		cl450_frame_height = d->height;
+		cl450_write_dram(CL_DRAM_PICTURE_RATE, cl450_frame_rate);
+		cl450_write_dram(CL_DRAM_H_SIZE, cl450_frame_width);
+		cl450_write_dram(CL_DRAM_V_SIZE, cl450_frame_height);
+	}
+	if (d->gop) {
+		cl450_write_dram(CL_DRAM_TIME_CODE_0, d->time_code[0]);
+		cl450_write_dram(CL_DRAM_TIME_CODE_1, d->time_code[1]);
+	}
+	if (d->frame) {
+		cl450_videoram_write++;
+		cl450_videoram_write &= CL450_VIDEO_BUFFERS - 1;
+		cl450_videoram_cnt++;
+		//write_log(_T("%d\n"), cl450_videoram_cnt);
+	}
+}
+
+static void cl450_decode_init(void)
+{
+	if (cl450_decode_tid)
+		return;
+	uae_sem_init(&cl450_decode_start, 0, 0);
+	uae_sem_init(&cl450_decode_done, 0, 0);
+	cl450_decode_quit = false;
+	if (!uae_start_thread(_T("cl450_decode"), cl450_decode_thread, NULL, &cl450_decode_tid))
+		cl450_decode_tid = 0;
+}
+
+static void cl450_decode_free(void)
+{
+	if (!cl450_decode_tid)
+		return;
+	cl450_decode_wait();
+	cl450_decode_quit = true;
+	uae_sem_post(&cl450_decode_start);
+	uae_wait_thread(&cl450_decode_tid);
+	cl450_decode_tid = 0;
+	uae_sem_destroy(&cl450_decode_start);
+	uae_sem_destroy(&cl450_decode_done);
+}
+
+static void cl450_parse_frame(void)
+{
+	struct cl450_decode *d = &cl450_decode_job;
+
+	d->buf = d->bufend = NULL;
+	if (cl450_decode_needdata) {
+		int bufsize = cl450_buffer_offset;
+		if (bufsize == 0)
+			return;
+		while (bufsize > 0 && cl450_newpacket_mode) {
+			struct cl450_newpacket *np = &cl450_newpacket_buffer[cl450_newpacket_offset_read];
+			if (cl450_newpacket_offset_read == cl450_newpacket_offset_write)
+				return;
+			int size = np->length > bufsize ? bufsize : np->length;
+
+			if (np->length == 0) {
+				write_log(_T("CL450 no matching newpacket!?\n"));
+				return;
+			}
+
+			np->length -= size;
+			bufsize -= size;
+			if (np->length > 0)
+				break;
+			//write_log(_T("CL450: NewPacket %d done\n"), cl450_newpacket_offset_read);
+			cl450_newpacket_offset_read++;
+			cl450_newpacket_offset_read &= CL450_NEWPACKET_BUFFER_SIZE - 1;
+		}
+#if DUMP_VIDEO
+		if (!videodump)
+			videodump = zfile_fopen(_T("c:\\temp\\1.mpg"), _T("wb"));
+		zfile_fwrite(&ram[CL450_MPEG_BUFFER], 1, cl450_buffer_offset, videodump);
+#endif
+		memcpy(&fmv_ram_bank.baseaddr[CL450_MPEG_DECODE_BUFFER] + libmpeg_offset, &fmv_ram_bank.baseaddr[CL450_MPEG_BUFFER], cl450_buffer_offset);
+		d->buf = &fmv_ram_bank.baseaddr[CL450_MPEG_DECODE_BUFFER] + libmpeg_offset;
+		d->bufend = d->buf + cl450_buffer_offset;
+		libmpeg_offset += cl450_buffer_offset;
+		if (libmpeg_offset >= CL450_MPEG_DECODE_BUFFER_SIZE - CL450_MPEG_BUFFER_SIZE)
+			libmpeg_offset = 0;
+		cl450_buffer_offset = 0;
+	}
+	d->pixbytes = currprefs.color_mode != 5 ? 2 : 4;
+	d->slot = cl450_videoram_write;
+	cl450_decode_busy = true;
+	cl450_decode_lines = CL450_DECODE_LINES;
+	if (cl450_decode_tid)
+		uae_sem_post(&cl450_decode_start);
+	else
+		cl450_decode_step(d);
+}
+
 static void cl450_reset(void)
 {
 	cl450_play = 0;
@@ -899,6 +1022,9 @@ static void cl450_reset(void)
 	cl450_videoram_read = 0;
 	cl450_videoram_cnt = 0;
 	memset(cl450_regs, 0, sizeof cl450_regs);
+	// drop the results of a step in flight, the decoder is reset
+	cl450_decode_wait();
+	cl450_decode_needdata = true;
 	if (mpeg_decoder)
 		mpeg2_reset(mpeg_decoder, 1);
 	if (fmv_ram_bank.baseaddr) {
@@ -1470,6 +1596,9 @@ static void cd32_fmv_hsync_handler(void)
 	if (cl450_play > 0)
 		cl450_scr += 90000.0f / (hblank_hz / fmv_syncadjust);
 
+	if (cl450_decode_busy && --cl450_decode_lines <= 0)
+		cl450_decode_finish();
+
 	if (cl450_video_hsync_wait > 0)
 		cl450_video_hsync_wait--;
 	if (cl450_video_hsync_wait == 0) {
@@ -1506,7 +1635,7 @@ static void cd32_fmv_hsync_handler(void)
 				cl450_set_status(CL_INT_RDY);
 		}
 
-		if (cl450_buffer_offset >= 512 && cl450_videoram_cnt < CL450_VIDEO_BUFFERS - 1) {
+		if (!cl450_decode_busy && cl450_buffer_offset >= 512 && cl450_videoram_cnt < CL450_VIDEO_BUFFERS - 1) {
 			cl450_parse_frame();
 		}
 	}
@@ -1536,6 +1665,7 @@ static void cd32_fmv_free(void)
 	uae_sem_destroy(&play_sem);
 	xfree(pcmaudio);
 	pcmaudio = NULL;
+	cl450_decode_free();
 	if (mpeg_decoder)
 		mpeg2_close(mpeg_decoder);
 	mpeg_decoder = NULL;
@@ -1582,6 +1712,7 @@ addrbank *cd32_fmv_init (struct autoconfig_info *aci)
 		mpeg_decoder = mpeg2_init();
 		mpeg_info = mpeg2_info(mpeg_decoder);
 	}
+	cl450_decode_init();
 	memset(&cas, 0, sizeof(cas));
 	fmv_bank.mask = fmv_board_size - 1;
 	map_banks(&fmv_rom_bank, (fmv_start + ROM_BASE) >> 16, fmv_rom_size >> 16, 0);
@@ -136,6 +136,14 @@ static bool lof_lace;
 static bool bplcon0_interlace_seen;
 static int scandoubled_line;
 static bool vsync_rendered, frame_rendered, frame_shown;
+#ifdef AMIBERRY
+/* -1 = run-ahead off, 0 = real frame, 1..runahead = frames run ahead */
+static int runahead_frame = -1;
+bool runahead_muted;
+static uae_u32 runahead_hash[2];
+static bool runahead_hashed;
+static int runahead_verified, runahead_mismatches;
+#endif
 static frame_time_t vsynctimeperline;
 static frame_time_t frameskiptime;
 static bool genlockhtoggle;
@@ -6843,12 +6851,102 @@ static int copper_cant_read(int hpos, int alloc)
    it subtly wrong; and it would also be more expensive - we want this code
    to be fast.  */
 
+/* Most programs run the same copper list every frame, so predictions are
+   memoized per list position and line. An entry is only used if all the
+   state the prediction depends on matches and the list words it read from
+   chip RAM are unchanged, so the result is identical to running it again. */
+
+#define COPPER_PREDICT_ENTRIES 1024
+#define COPPER_PREDICT_MAXWORDS 128
+
+struct copper_prediction {
+	bool valid;
+	uaecptr ip, cop1lc, cop2lc;
+	unsigned int i1, saved_i1, saved_i2;
+	enum copper_states state;
+	int hpos, vpos, vcmp, strobe, maxhpos;
+	uae_u32 copcon;
+	int chipset_mask;
+	uaecptr readip;
+	int readwords;
+	uae_u8 words[COPPER_PREDICT_MAXWORDS * 2];
+	unsigned int end_hpos, modified;
+};
+
+static struct copper_prediction copper_predictions[COPPER_PREDICT_ENTRIES];
+
+static struct copper_prediction *copper_prediction_slot(void)
+{
+	uae_u32 h = (cop_state.ip >> 1) ^ (vpos * 0x9e37) ^ (cop_state.hpos << 7) ^ cop_state.state;
+	return &copper_predictions[(h ^ (h >> 10)) & (COPPER_PREDICT_ENTRIES - 1)];
+}
+
+static bool copper_prediction_match(struct copper_prediction *cp)
+{
+	if (!cp->valid || cp->ip != cop_state.ip || cp->hpos != cop_state.hpos || cp->vpos != vpos ||
+		cp->state != cop_state.state || cp->i1 != cop_state.i1 ||
+		cp->saved_i1 != cop_state.saved_i1 || cp->saved_i2 != cop_state.saved_i2 ||
+		cp->vcmp != cop_state.vcmp || cp->strobe != cop_state.strobe ||
+		cp->cop1lc != cop1lc || cp->cop2lc != cop2lc || cp->maxhpos != maxhpos ||
+		cp->copcon != copcon || cp->chipset_mask != currprefs.chipset_mask)
+		return false;
+	if (cp->readwords && (chipmem_wget_indirect != chipmem_agnus_wget ||
+		memcmp(cp->words, chipmem_bank.baseaddr + cp->readip, cp->readwords * 2)))
+		return false;
+	return true;
+}
+
+static void copper_prediction_store(struct copper_prediction *cp)
+{
+	cp->ip = cop_state.ip;
+	cp->hpos = cop_state.hpos;
+	cp->vpos = vpos;
+	cp->state = cop_state.state;
+	cp->i1 = cop_state.i1;
+	cp->saved_i1 = cop_state.saved_i1;
+	cp->saved_i2 = cop_state.saved_i2;
+	cp->vcmp = cop_state.vcmp;
+	cp->strobe = cop_state.strobe;
+	cp->cop1lc = cop1lc;
+	cp->cop2lc = cop2lc;
+	cp->maxhpos = maxhpos;
+	cp->copcon = copcon;
+	cp->chipset_mask = currprefs.chipset_mask;
+	cp->valid = true;
+}
+
+static void predict_copper_schedule(unsigned int c_hpos, unsigned int modified)
+{
+	unsigned int cycle_count = c_hpos - cop_state.hpos;
+	if (cycle_count >= 8) {
+		cop_state.regtypes_modified = modified;
+		unset_special(SPCFLAG_COPPER);
+		eventtab[ev_copper].active = 1;
+		eventtab[ev_copper].evtime = get_cycles() + cycle_count * CYCLE_UNIT;
+		events_schedule();
+	}
+}
+
+/* Remember a list word read by the prediction. Reads are contiguous, the
+   only jump (COPJMP strobe) happens before the first read. */
+static bool copper_prediction_read(struct copper_prediction *cp, uaecptr *readip, int *readwords, uaecptr ip)
+{
+	if (*readwords == 0)
+		*readip = ip;
+	if ((ip & 1) || ip != *readip + *readwords * 2 || *readwords >= COPPER_PREDICT_MAXWORDS ||
+		ip + 2 > currprefs.chipmem.size)
+		return false;
+	memcpy(&cp->words[*readwords * 2], chipmem_bank.baseaddr + ip, 2);
+	(*readwords)++;
+	return true;
+}
+
 static void predict_copper(void)
 {
 	uaecptr ip = cop_state.ip;
 	unsigned int c_hpos = cop_state.hpos;
 	enum copper_states state = cop_state.state;
-	unsigned int w1, w2, cycle_count;
+	unsigned int w1, w2;
 	unsigned int modified = REGTYPE_FORCE;
 	unsigned int vcmp;
 	int vp;
@@ -6856,6 +6954,16 @@ static void predict_copper(void)
 	if (cop_state.ignore_next || cop_state.movedelay)
 		return;
 
+	struct copper_prediction *cp = copper_prediction_slot();
+	if (copper_prediction_match(cp)) {
+		predict_copper_schedule(cp->end_hpos, cp->modified);
+		return;
+	}
+	// only lists in plain chip RAM can be validated later
+	bool memo = chipmem_wget_indirect == chipmem_agnus_wget;
+	uaecptr readip = 0;
+	int readwords = 0;
+
 	int until_hpos = maxhpos - 3;
 	int force_exit = 0;
 
@@ -6924,12 +7032,16 @@ static void predict_copper(void)
 
 		case COP_read1:
 			w1 = chipmem_wget_indirect(ip);
+			if (memo)
+				memo = copper_prediction_read(cp, &readip, &readwords, ip);
 			ip += 2;
 			state = COP_read2;
 			break;
 
 		case COP_read2:
 			w2 = chipmem_wget_indirect(ip);
+			if (memo)
+				memo = copper_prediction_read(cp, &readip, &readwords, ip);
 			ip += 2;
 			if (w1 & 1) { // WAIT or SKIP
 				if (w2 & 1)
@@ -6997,14 +7109,16 @@ static void predict_copper(void)
 			c_hpos += 2;
 	}
 
-	cycle_count = c_hpos - cop_state.hpos;
-	if (cycle_count >= 8) {
-		cop_state.regtypes_modified = modified;
-		unset_special(SPCFLAG_COPPER);
-		eventtab[ev_copper].active = 1;
-		eventtab[ev_copper].evtime = get_cycles() + cycle_count * CYCLE_UNIT;
-		events_schedule();
+	if (memo) {
+		copper_prediction_store(cp);
+		cp->readip = readip;
+		cp->readwords = readwords;
+		cp->end_hpos = c_hpos;
+		cp->modified = modified;
+	} else {
+		cp->valid = false;
 	}
+	predict_copper_schedule(c_hpos, modified);
 }
 #endif
 
@@ -8118,15 +8232,10 @@ static bool framewait(void)
 			frame_rendered = render_screen(0, 1, false);
 
 		if (currprefs.m68k_speed_throttle) {
-			// this delay can safely overshoot frame time by 1-2 ms, following code will compensate for it.
-			for (;;) {
+			curr_time = read_processor_time();
+			if (vsyncwaittime - curr_time > 0 && vsyncwaittime - curr_time <= 2 * vsynctimebase) {
+				target_pace_until(vsyncwaittime, NULL);
 				curr_time = read_processor_time();
-				if ((int)vsyncwaittime  - (int)curr_time <= 0 || (int)vsyncwaittime  - (int)curr_time > 2 * vsynctimebase)
-					break;
-				if (cpu_sleep_millis(1) < 0) {
-					curr_time = read_processor_time();
-					break;
-				}
 			}
 		} else {
 			curr_time = read_processor_time();
@@ -8158,20 +8267,16 @@ static bool framewait(void)
 			t = read_processor_time() - start;
 		}
 		if (!currprefs.cpu_thread) {
-			while (!currprefs.turbo_emulation) {
-				float v = rpt_vsync(0) / (syncbase / 1000.0);
-				if (v >= -3)
-					break;
-
-				maybe_process_pull_audio();
-				if (cpu_sleep_millis(1) < 0)
-					break;
-			}
-			while (rpt_vsync(0) < 0) {
-				maybe_process_pull_audio();
+			if (currprefs.turbo_emulation) {
+				frame_time_t spin = read_processor_time();
+				while (rpt_vsync(0) < 0) {
+					maybe_process_pull_audio();
+				}
+				idletime += read_processor_time() - spin;
+			} else if (rpt_vsync(0) < 0) {
+				target_pace_until(vsyncwaittime, maybe_process_pull_audio);
 			}
 		}
-		idletime += read_processor_time() - start;
 		curr_time = read_processor_time();
 		vsyncmintime = curr_time;
 		vsyncmaxtime = vsyncwaittime = curr_time + vstb;
@@ -8316,10 +8421,13 @@ static void vsync_handler_pre(void)
 		frameskiptime += end - start;
 	}
 
-	bool frameok = framewait();
 #ifdef AMIBERRY
-	if (!ad->picasso_on && !nodraw()) {
+	// only the last frame run ahead is shown and paced
+	bool hidden = runahead_frame >= 0 && runahead_frame != currprefs.runahead;
+	bool frameok = hidden ? true : framewait();
+	if (!ad->picasso_on && !nodraw() && !hidden) {
 #else
+	bool frameok = framewait();
 	if (!ad->picasso_on) {
 #endif
 		if (!frame_rendered && vblank_hz_state) {
@@ -8333,10 +8441,18 @@ static void vsync_handler_pre(void)
 	// GUI check here, must be after frame rendering
 	devices_vsync_pre();
 
+#ifdef AMIBERRY
+	if (!hidden)
+#endif
 	fpscounter(frameok);
 
 	bool waspaused = false;
+#ifdef AMIBERRY
+	// host input is only consumed by the real frame, frames run ahead are replayed
+	while (runahead_frame <= 0 && handle_events()) {
+#else
 	while (handle_events()) {
+#endif
 		if (!waspaused) {
 			render_screen(0, 1, true);
 			show_screen(0, 0);
@@ -9322,6 +9438,79 @@ static void init_regtypes(void)
 }
 #endif
 
+#ifdef AMIBERRY
+static void runahead_hash_frame(uae_u32 *hash)
+{
+	const struct vidbuffer *vb = &adisplays[0].gfxvidinfo.drawbuffer;
+	hash[0] = get_crc32(chipmem_bank.baseaddr, currprefs.chipmem.size);
+	hash[1] = vb->bufmem ? get_crc32(vb->bufmem, vb->rowbytes * vb->height_allocated) : 0;
+}
+
+/* Determinism check: the real frame after a rollback replays the input of
+ * the first frame run ahead, so both must end with the same chip RAM and
+ * display. With runahead_verify=N, quit after N checked frames. */
+static void runahead_verify_frame(void)
+{
+	uae_u32 hash[2];
+
+	if (!runahead_hashed)
+		return;
+	runahead_hashed = false;
+	runahead_hash_frame(hash);
+	runahead_verified++;
+	if (hash[0] != runahead_hash[0] || hash[1] != runahead_hash[1]) {
+		runahead_mismatches++;
+		write_log(_T("Run-ahead verify: frame %u differs, chip %08x/%08x display %08x/%08x\n"),
+			vsync_counter, runahead_hash[0], hash[0], runahead_hash[1], hash[1]);
+	}
+	if (runahead_verified >= currprefs.runahead_verify) {
+		write_log(_T("Run-ahead verify: %d frames, %d mismatches\n"), runahead_verified, runahead_mismatches);
+		uae_quit();
+	}
+}
+
+/* Run-ahead: after each real frame the state is captured, 'runahead'
+ * frames are emulated with output muted, the last one is shown and the
+ * state is rolled back to the capture so the next real frame continues
+ * from there. Input latency seen on screen drops by 'runahead' frames.
+ * Experimental: the rollback still goes through the m68k_go reset path
+ * (custom_reset, m68k_reset) once per real frame. */
+static void runahead_vsync(void)
+{
+	bool enabled = currprefs.runahead > 0 && savestate_runahead_possible();
+
+	if (runahead_frame < 0) {
+		if (!enabled)
+			return;
+		write_log(_T("Run-ahead (experimental): %d frame(s)\n"), currprefs.runahead);
+		runahead_frame = 0;
+	}
+	if (runahead_frame == 1 && currprefs.runahead_verify > 0) {
+		runahead_hash_frame(runahead_hash);
+		runahead_hashed = true;
+	}
+	if (runahead_frame == 0) {
+		if (currprefs.runahead_verify > 0)
+			runahead_verify_frame();
+		if (!enabled || !savestate_runahead_capture()) {
+			runahead_frame = -1;
+			runahead_muted = false;
+			return;
+		}
+		sound_runahead_capture();
+		runahead_frame = 1;
+		runahead_muted = true;
+	} else if (enabled && runahead_frame < currprefs.runahead) {
+		runahead_frame++;
+	} else {
+		runahead_frame = 0;
+		runahead_muted = false;
+		sound_runahead_rewind();
+		savestate_runahead_rewind();
+	}
+}
+#endif
+
 static void hsync_handler(void)
 {
 	bool vs = is_custom_vsync();
@@ -9329,6 +9518,9 @@ static void hsync_handler(void)
 	if (vs) {
 		vsyncmintimepre = read_processor_time();
 		vsync_handler_pre();
+#ifdef AMIBERRY
+		runahead_vsync();
+#endif
 		if (savestate_check()) {
 			uae_reset(0, 0);
 			return;
@@ -9346,9 +9538,7 @@ void init_eventtab (void)
 		eventtab[i].active = 0;
 		eventtab[i].oldcycles = get_cycles();
 	}
-	for (i = 0; i < ev2_max; i++) {
-		eventtab2[i].active = 0;
-	}
+	event2_clear();
 
 	eventtab[ev_cia].handler = CIA_handler;
 	eventtab[ev_hsync].handler = hsync_handler;
@@ -10167,12 +10357,7 @@ static void REGPARAM2 custom_lput (uaecptr addr, uae_u32 value)
 
 void custom_prepare_savestate(void)
 {
-	for (int i = 0; i < ev2_max; i++) {
-		if (eventtab2[i].active) {
-			eventtab2[i].active = 0;
-			eventtab2[i].handler(eventtab2[i].data);
-		}
-	}
+	event2_flush();
 }
 
 void restore_custom_finish(void)
@@ -10773,32 +10958,24 @@ uae_u8 *restore_custom_event_delay(uae_u8 *src)
 uae_u8 *save_custom_event_delay(size_t *len, uae_u8 *dstptr)
 {
 	uae_u8 *dstbak, *dst;
-	int cnt = 0;
+	struct ev2 *list[255];
 
-	for (int i = ev2_misc; i < ev2_max; i++) {
-		struct ev2 *e = &eventtab2[i];
-		if (e->active && e->handler == send_interrupt_do) {
-			cnt++;
-		}
-	}
+	int cnt = event2_find(send_interrupt_do, list, 255);
 	if (cnt == 0)
 		return NULL;
 
 	if (dstptr)
 		dstbak = dst = dstptr;
 	else
-		dstbak = dst = xmalloc(uae_u8, 1000);
+		dstbak = dst = xmalloc(uae_u8, 16 + cnt * 16);
 
 	save_u32(1);
 	save_u8(cnt);
-	for (int i = ev2_misc; i < ev2_max; i++) {
-		struct ev2 *e = &eventtab2[i];
-		if (e->active && e->handler == send_interrupt_do) {
-			save_u8(1);
-			save_u64(e->evtime - get_cycles());
-			save_u32(e->data);
-		
-		}
+	for (int i = 0; i < cnt; i++) {
+		struct ev2 *e = list[i];
+		save_u8(1);
+		save_u64(e->evtime - get_cycles());
+		save_u32(e->data);
 	}
 
 	*len = dst - dstbak;
@@ -3695,6 +3695,36 @@ int debugmem_get_symbol(uaecptr addr, TCHAR *out, int maxsize)
 	return found;
 }
 
+/* Nearest symbol at or below addr in the same segment */
+int debugmem_get_symbol_near(uaecptr addr, TCHAR *out, int maxsize, uae_u32 *offsetp)
+{
+	struct debugsymbol *best = NULL;
+	if (out)
+		out[0] = 0;
+	int id = debugmem_get_segment(addr, NULL, NULL, NULL, NULL);
+	if (!id)
+		return 0;
+	for (int i = 0; i < symbolcnt; i++) {
+		struct debugsymbol *ds = symbols[i];
+		if (ds->allocid != id || ds->value > addr)
+			continue;
+		if (!best || ds->value > best->value)
+			best = ds;
+	}
+	if (!best)
+		return 0;
+	if (offsetp)
+		*offsetp = addr - best->value;
+	if (out) {
+		if (addr != best->value)
+			_sntprintf(out, maxsize, _T("%s+%x"), best->name, addr - best->value);
+		else
+			_sntprintf(out, maxsize, _T("%s"), best->name);
+		out[maxsize - 1] = 0;
+	}
+	return 1;
+}
+
 struct debugcodefile *last_codefile;
 
 int debugmem_get_sourceline(uaecptr addr, TCHAR *out, int maxsize)
@@ -3963,6 +3993,21 @@ bool debugmem_enable_stackframe(bool enable)
 	return false;
 }
 
+/* Branch targets of the tracked stack frames, outermost first. Keeps the
+ * innermost frames if there are more than max. */
+int debugmem_get_branch_stack(uaecptr *pcs, int max)
+{
+	if (!stackframes)
+		return 0;
+	int cnt = regs.s ? stackframecntsuper : stackframecnt;
+	int first = cnt > max ? cnt - max : 0;
+	for (int i = first; i < cnt; i++) {
+		struct debugstackframe *sf = regs.s ? &stackframessuper[i] : &stackframes[i];
+		pcs[i - first] = sf->branch_pc;
+	}
+	return cnt - first;
+}
+
 bool debugmem_list_stackframe(bool super)
 {
 	if (!debugmem_bank.baseaddr && !stackframemode) {
@@ -68,6 +68,7 @@
 #endif
 #include "rommgr.h"
 #include "newcpu.h"
+#include "pcprofile.h"
 #ifdef WITH_MIDIEMU
 #include "midiemu.h"
 #endif
@@ -439,6 +440,7 @@ void virtualdevice_init (void)
 #ifdef WITH_DRACO
 	draco_init();
 #endif
+	pcprofile_install();
 }
 
 void devices_restore_start(void)
@@ -2919,6 +2919,11 @@ static void drive_write_data (drive * drv)
 	int ret = -1;
 	int tr = drv->cyl * 2 + side;
 
+#ifdef AMIBERRY
+	// the track is written again when the real frame reaches this point
+	if (runahead_muted)
+		return;
+#endif
 	if (drive_writeprotected (drv) || drv->trackdata[tr].type == TRACK_NONE) {
 		/* read original track back because we didn't really write anything */
 		drv->buffered_side = 2;
@@ -6393,3 +6398,48 @@ void disk_reserved_reset_disk_change(int num)
 		drv->dskchange = false;
 	}
 }
+
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+/* One track of pseudo-random data in a memory zfile, encoded as a normal ADF */
+static drive *bench_disk_drive(int secs)
+{
+	static drive *drv;
+	static uae_u8 *data;
+
+	if (!drv) {
+		uae_u32 seed = 0x13579bdf;
+		data = xmalloc(uae_u8, 22 * 512);
+		for (int i = 0; i < 22 * 512; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 24;
+		}
+		drv = xcalloc(drive, 1);
+		drv->diskfile = zfile_fopen_data(_T("bench.adf"), 22 * 512, data);
+		drv->filetype = ADF_NORMAL;
+		drv->ddhd = 1;
+		drv->trackdata[0].len = 22 * 512;
+		drv->trackdata[0].track = 1;
+	}
+	drv->num_secs = secs;
+	return drv;
+}
+
+uae_u64 bench_disk_amigados(int iterations)
+{
+	drive *drv = bench_disk_drive(11);
+	for (int i = 0; i < iterations; i++)
+		decode_amigados(drv, 0);
+	return (uae_u64)iterations * drv->num_secs * 512;
+}
+
+/* PC format track, dominated by mfmcoder() */
+uae_u64 bench_disk_pcdos(int iterations)
+{
+	drive *drv = bench_disk_drive(9);
+	for (int i = 0; i < iterations; i++)
+		decode_pcdos(drv, 0);
+	return (uae_u64)iterations * drv->num_secs * 512;
+}
+#endif
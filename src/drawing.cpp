@@ -2066,6 +2066,140 @@ static void dummy_worker (int start, int stop, int blank)
 static int ham_decode_pixel;
 static uae_u32 ham_lastcolor;
 
+/* Every HAM pixel either loads a palette color or replaces one component of
+ * the previous color, both are color = (previous & keep) | set. Pairs of
+ * (keep, set) compose associatively, so the control bits are turned into
+ * masks without branches and the SIMD path then resolves four pixels at a
+ * time with a two step prefix scan, carrying the last color between groups.
+ */
+#define HAM_BLOCK 64
+
+static void ham_masks_ecs(const uae_u8 *src, int n, uae_u32 *keep, uae_u32 *set)
+{
+	static const uae_u32 ham_keep[4] = { 0x000, 0xff0, 0x0ff, 0xf0f };
+	static const uae_u8 ham_shift[4] = { 0, 0, 8, 4 };
+	for (int i = 0; i < n; i++) {
+		int pv = src[i];
+		int ctl = (pv >> 4) & 3;
+		uae_u32 pal = colors_for_drawing.color_regs_ecs[ctl ? 0 : pv] & 0xfff;
+		uae_u32 mod = (pv & 0xf) << ham_shift[ctl];
+		keep[i] = ham_keep[ctl];
+		set[i] = ctl ? mod : pal;
+	}
+}
+
+#ifdef AGA
+static void ham_masks_aga6(const uae_u8 *src, int n, uae_u32 *keep, uae_u32 *set)
+{
+	static const uae_u32 ham_keep[4] = { 0x000000, 0xffff00, 0x00ffff, 0xff00ff };
+	static const uae_u8 ham_shift[4] = { 0, 0, 16, 8 };
+	for (int i = 0; i < n; i++) {
+		int pw = src[i];
+		int pv = pw ^ bplxor;
+		int ctl = (pv >> 4) & 3;
+		uae_u32 pal = colors_for_drawing.color_regs_aga[pv & 0x0f] & 0xffffff;
+		uae_u32 mod = ((pw & 0xf) * 0x11) << ham_shift[ctl];
+		keep[i] = ham_keep[ctl];
+		set[i] = ctl ? mod : pal;
+	}
+}
+
+static void ham_masks_aga8(const uae_u8 *src, int n, uae_u32 *keep, uae_u32 *set)
+{
+	static const uae_u32 ham_keep[4] = { 0x000000, 0xffff03, 0x03ffff, 0xff03ff };
+	static const uae_u8 ham_shift[4] = { 0, 0, 16, 8 };
+	for (int i = 0; i < n; i++) {
+		int pw = src[i];
+		int pv = pw ^ bplxor;
+		int ctl = pv & 3;
+		uae_u32 pal = colors_for_drawing.color_regs_aga[pv >> 2] & 0xffffff;
+		uae_u32 mod = (pw & 0xfc) << ham_shift[ctl];
+		keep[i] = ham_keep[ctl];
+		set[i] = ctl ? mod : pal;
+	}
+}
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(CPU_AARCH64) || defined(USE_ARMNEON)) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* apply n (keep, set) pairs to color c, storing each result to dst if not NULL */
+static uae_u32 ham_scan(const uae_u32 *keep, const uae_u32 *set, int n, uae_u32 c, uae_u32 *dst)
+{
+	int i = 0;
+
+	if (dst) {
+#if defined(__SSE2__)
+		const __m128i id1 = _mm_setr_epi32(-1, 0, 0, 0);
+		const __m128i id2 = _mm_setr_epi32(-1, -1, 0, 0);
+		__m128i vc = _mm_set1_epi32(c);
+		for (; i + 4 <= n; i += 4) {
+			__m128i vk = _mm_loadu_si128((const __m128i*)&keep[i]);
+			__m128i vs = _mm_loadu_si128((const __m128i*)&set[i]);
+			vs = _mm_or_si128(_mm_and_si128(_mm_slli_si128(vs, 4), vk), vs);
+			vk = _mm_and_si128(_mm_or_si128(_mm_slli_si128(vk, 4), id1), vk);
+			vs = _mm_or_si128(_mm_and_si128(_mm_slli_si128(vs, 8), vk), vs);
+			vk = _mm_and_si128(_mm_or_si128(_mm_slli_si128(vk, 8), id2), vk);
+			__m128i r = _mm_or_si128(_mm_and_si128(vc, vk), vs);
+			_mm_storeu_si128((__m128i*)&dst[i], r);
+			vc = _mm_shuffle_epi32(r, 0xff);
+		}
+		c = _mm_cvtsi128_si32(vc);
+#elif (defined(CPU_AARCH64) || defined(USE_ARMNEON)) && defined(__ARM_NEON)
+		const uint32x4_t ones = vdupq_n_u32(0xffffffff);
+		const uint32x4_t zero = vdupq_n_u32(0);
+		uint32x4_t vc = vdupq_n_u32(c);
+		for (; i + 4 <= n; i += 4) {
+			uint32x4_t vk = vld1q_u32(&keep[i]);
+			uint32x4_t vs = vld1q_u32(&set[i]);
+			vs = vorrq_u32(vandq_u32(vextq_u32(zero, vs, 3), vk), vs);
+			vk = vandq_u32(vextq_u32(ones, vk, 3), vk);
+			vs = vorrq_u32(vandq_u32(vextq_u32(zero, vs, 2), vk), vs);
+			vk = vandq_u32(vextq_u32(ones, vk, 2), vk);
+			uint32x4_t r = vorrq_u32(vandq_u32(vc, vk), vs);
+			vst1q_u32(&dst[i], r);
+			vc = vdupq_n_u32(vgetq_lane_u32(r, 3));
+		}
+		c = vgetq_lane_u32(vc, 0);
+#endif
+	}
+	for (; i < n; i++) {
+		c = (c & keep[i]) | set[i];
+		if (dst)
+			dst[i] = c;
+	}
+	return c;
+}
+
+/* decode n HAM pixels starting from color c, returns the last color */
+static uae_u32 ham_decode_run(const uae_u8 *src, uae_u32 *dst, int n, uae_u32 c)
+{
+	uae_u32 keep[HAM_BLOCK], set[HAM_BLOCK];
+
+	while (n > 0) {
+		int cnt = n > HAM_BLOCK ? HAM_BLOCK : n;
+#ifdef AGA
+		if (currprefs.chipset_mask & CSMASK_AGA) {
+			if (bplplanecnt >= 7) /* AGA mode HAM8 */
+				ham_masks_aga8(src, cnt, keep, set);
+			else /* AGA mode HAM6 */
+				ham_masks_aga6(src, cnt, keep, set);
+		} else
+#endif
+			/* OCS/ECS mode HAM6 */
+			ham_masks_ecs(src, cnt, keep, set);
+		c = ham_scan(keep, set, cnt, c, dst);
+		src += cnt;
+		if (dst)
+			dst += cnt;
+		n -= cnt;
+	}
+	return c;
+}
+
 /* Decode HAM in the invisible portion of the display (left of VISIBLE_LEFT_BORDER),
  * but don't draw anything in.  This is done to prepare HAM_LASTCOLOR for later,
  * when decode_ham runs.
@@ -2088,48 +2222,9 @@ static void init_ham_decoding(void)
 #endif
 				ham_lastcolor = colors_for_drawing.color_regs_ecs[pv] & 0xfff;
 		}
-#ifdef AGA
-	} else if (currprefs.chipset_mask & CSMASK_AGA) {
-		if (bplplanecnt >= 7) { /* AGA mode HAM8 */
-			while (unpainted_amiga-- > 0) {
-				int pw = pixdata.apixels[ham_decode_pixel++];
-				int pv = pw ^ bplxor;
-				int pc = pv >> 2;
-				switch (pv & 0x3)
-				{
-				case 0x0: ham_lastcolor = colors_for_drawing.color_regs_aga[pc] & 0xffffff; break;
-				case 0x1: ham_lastcolor &= 0xFFFF03; ham_lastcolor |= (pw & 0xFC); break;
-				case 0x2: ham_lastcolor &= 0x03FFFF; ham_lastcolor |= (pw & 0xFC) << 16; break;
-				case 0x3: ham_lastcolor &= 0xFF03FF; ham_lastcolor |= (pw & 0xFC) << 8; break;
-				}
-			}
-		} else { /* AGA mode HAM6 */
-			while (unpainted_amiga-- > 0) {
-				int pw = pixdata.apixels[ham_decode_pixel++];
-				int pv = pw ^ bplxor;
-				uae_u32 pc = ((pw & 0xf) << 0) | ((pw & 0xf) << 4);
-				switch (pv & 0x30)
-				{
-				case 0x00: ham_lastcolor = colors_for_drawing.color_regs_aga[pv & 0x0f] & 0xffffff; break;
-				case 0x10: ham_lastcolor &= 0xFFFF00; ham_lastcolor |= pc << 0; break;
-				case 0x20: ham_lastcolor &= 0x00FFFF; ham_lastcolor |= pc << 16; break;
-				case 0x30: ham_lastcolor &= 0xFF00FF; ham_lastcolor |= pc << 8; break;
-				}
-			}
-		}
-#endif
-	} else {
-		/* OCS/ECS mode HAM6 */
-		while (unpainted_amiga-- > 0) {
-			int pv = pixdata.apixels[ham_decode_pixel++];
-			switch (pv & 0x30)
-			{
-			case 0x00: ham_lastcolor = colors_for_drawing.color_regs_ecs[pv] & 0xfff; break;
-			case 0x10: ham_lastcolor &= 0xFF0; ham_lastcolor |= (pv & 0xF); break;
-			case 0x20: ham_lastcolor &= 0x0FF; ham_lastcolor |= (pv & 0xF) << 8; break;
-			case 0x30: ham_lastcolor &= 0xF0F; ham_lastcolor |= (pv & 0xF) << 4; break;
-			}
-		}
+	} else if (unpainted_amiga > 0) {
+		ham_lastcolor = ham_decode_run(&pixdata.apixels[ham_decode_pixel], NULL, unpainted_amiga, ham_lastcolor);
+		ham_decode_pixel += unpainted_amiga;
 	}
 }
 
@@ -2149,51 +2244,9 @@ static void decode_ham(int pix, int stoppos, int blank)
 
 			ham_linebuf[ham_decode_pixel++] = ham_lastcolor;
 		}
-#ifdef AGA
-	} else if (currprefs.chipset_mask & CSMASK_AGA) {
-		if (bplplanecnt >= 7) { /* AGA mode HAM8 */
-			while (todraw_amiga-- > 0) {
-				int pw = pixdata.apixels[ham_decode_pixel];
-				int pv = pw ^ bplxor;
-				int pc = pv >> 2;
-				switch (pv & 0x3)
-				{
-				case 0x0: ham_lastcolor = colors_for_drawing.color_regs_aga[pc] & 0xffffff; break;
-				case 0x1: ham_lastcolor &= 0xFFFF03; ham_lastcolor |= (pw & 0xFC); break;
-				case 0x2: ham_lastcolor &= 0x03FFFF; ham_lastcolor |= (pw & 0xFC) << 16; break;
-				case 0x3: ham_lastcolor &= 0xFF03FF; ham_lastcolor |= (pw & 0xFC) << 8; break;
-				}
-				ham_linebuf[ham_decode_pixel++] = ham_lastcolor;
-			}
-		} else { /* AGA mode HAM6 */
-			while (todraw_amiga-- > 0) {
-				int pw = pixdata.apixels[ham_decode_pixel];
-				int pv = pw ^ bplxor;
-				uae_u32 pc = ((pw & 0xf) << 0) | ((pw & 0xf) << 4);
-				switch (pv & 0x30)
-				{
-				case 0x00: ham_lastcolor = colors_for_drawing.color_regs_aga[pv & 0x0f] & 0xffffff; break;
-				case 0x10: ham_lastcolor &= 0xFFFF00; ham_lastcolor |= pc << 0; break;
-				case 0x20: ham_lastcolor &= 0x00FFFF; ham_lastcolor |= pc << 16; break;
-				case 0x30: ham_lastcolor &= 0xFF00FF; ham_lastcolor |= pc << 8; break;
-				}
-				ham_linebuf[ham_decode_pixel++] = ham_lastcolor;
-			}
-		}
-#endif
-	} else {
-		/* OCS/ECS mode HAM6 */
-		while (todraw_amiga-- > 0) {
-			int pv = pixdata.apixels[ham_decode_pixel];
-			switch (pv & 0x30)
-			{
-			case 0x00: ham_lastcolor = colors_for_drawing.color_regs_ecs[pv] & 0xfff; break;
-			case 0x10: ham_lastcolor &= 0xFF0; ham_lastcolor |= (pv & 0xF); break;
-			case 0x20: ham_lastcolor &= 0x0FF; ham_lastcolor |= (pv & 0xF) << 8; break;
-			case 0x30: ham_lastcolor &= 0xF0F; ham_lastcolor |= (pv & 0xF) << 4; break;
-			}
-			ham_linebuf[ham_decode_pixel++] = ham_lastcolor;
-		}
+	} else if (todraw_amiga > 0) {
+		ham_lastcolor = ham_decode_run(&pixdata.apixels[ham_decode_pixel], &ham_linebuf[ham_decode_pixel], todraw_amiga, ham_lastcolor);
+		ham_decode_pixel += todraw_amiga;
 	}
 }
 
@@ -4724,3 +4777,57 @@ int isvsync(void)
 		return isvsync_rtg ();
 	return isvsync_chipset ();
 }
+
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+static uae_u32 bench_drawing_buf[MAX_PIXELS_PER_LINE];
+
+static void bench_drawing_setup(void)
+{
+	static bool done;
+	uae_u32 seed = 0x12345678;
+
+	if (done)
+		return;
+	done = true;
+	for (int i = 0; i < MAX_PLANES * MAX_WORDS_PER_LINE * 2; i++) {
+		seed = seed * 1103515245 + 12345;
+		line_data[0][i] = seed >> 24;
+	}
+	int colors = sizeof colors_for_drawing.acolors / sizeof(xcolnr);
+	for (int i = 0; i < MAX_PIXELS_PER_LINE; i++)
+		pixdata.apixels[i] = i & (colors - 1);
+	for (int i = 0; i < colors; i++)
+		colors_for_drawing.acolors[i] = i * 0x010101;
+}
+
+/* Bitplane to chunky conversion of one line, through the same path as a real line */
+uae_u64 bench_drawing_doline(int planes, int iterations)
+{
+	static struct decision dp;
+	int wordcount = 24;
+
+	bench_drawing_setup();
+	dp.plflinelen = wordcount;
+	dp_for_drawing = &dp;
+	bplplanecnt = planes;
+	for (int i = 0; i < iterations; i++)
+		pfield_doline(0);
+	return (uae_u64)iterations * planes * wordcount * 4;
+}
+
+/* Chunky pixels to 32-bit host pixels, normal palette mode */
+uae_u64 bench_drawing_linetoscr(int iterations)
+{
+	int pixels = MAX_PIXELS_PER_LINE / 2;
+
+	bench_drawing_setup();
+	xlinebuffer = (uae_u8*)bench_drawing_buf;
+	p_acolors = colors_for_drawing.acolors;
+	bplmode = CMODE_NORMAL;
+	for (int i = 0; i < iterations; i++)
+		linetoscr_32(0, 0, pixels);
+	return (uae_u64)iterations * pixels * 4;
+}
+#endif
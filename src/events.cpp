@@ -330,56 +330,154 @@ do_cycles_func do_cycles = do_cycles_cpu_norm;
 static ev2 *last_event2;
 static ev2 dummy_event;
 
+/*
+ * Pending ev2 events are kept in a binary min-heap ordered by expiry time
+ * and then by scheduling order, so the next event is always ev2heap[0].
+ * Fixed events (eventtab2[]) and anonymous events share the heap.
+ * Anonymous events come from a pool that grows on demand.
+ */
+static ev2 **ev2heap;
+static int ev2heap_num, ev2heap_size;
+static uae_u64 ev2seq;
+
+#define EV2_POOL_BLOCK 32
+static ev2 *ev2pool_free;
+
+static inline bool ev2_before(const ev2 *a, const ev2 *b)
+{
+	if (a->evtime != b->evtime)
+		return a->evtime < b->evtime;
+	return a->seq < b->seq;
+}
+
+static inline void ev2heap_set(int idx, ev2 *e)
+{
+	ev2heap[idx] = e;
+	e->heapidx = idx;
+}
+
+static void ev2heap_up(int idx)
+{
+	ev2 *e = ev2heap[idx];
+	while (idx > 0) {
+		int parent = (idx - 1) / 2;
+		if (!ev2_before(e, ev2heap[parent]))
+			break;
+		ev2heap_set(idx, ev2heap[parent]);
+		idx = parent;
+	}
+	ev2heap_set(idx, e);
+}
+
+static void ev2heap_down(int idx)
+{
+	ev2 *e = ev2heap[idx];
+	for (;;) {
+		int child = idx * 2 + 1;
+		if (child >= ev2heap_num)
+			break;
+		if (child + 1 < ev2heap_num && ev2_before(ev2heap[child + 1], ev2heap[child]))
+			child++;
+		if (!ev2_before(ev2heap[child], e))
+			break;
+		ev2heap_set(idx, ev2heap[child]);
+		idx = child;
+	}
+	ev2heap_set(idx, e);
+}
+
+static void ev2heap_insert(ev2 *e)
+{
+	if (ev2heap_num >= ev2heap_size) {
+		ev2heap_size = ev2heap_size ? ev2heap_size * 2 : EV2_POOL_BLOCK;
+		ev2heap = xrealloc(ev2*, ev2heap, ev2heap_size);
+	}
+	e->seq = ev2seq++;
+	ev2heap_set(ev2heap_num++, e);
+	ev2heap_up(e->heapidx);
+}
+
+static void ev2heap_delete(ev2 *e)
+{
+	int idx = e->heapidx;
+	e->heapidx = -1;
+	ev2heap_num--;
+	if (idx == ev2heap_num)
+		return;
+	ev2heap_set(idx, ev2heap[ev2heap_num]);
+	if (idx > 0 && ev2_before(ev2heap[idx], ev2heap[(idx - 1) / 2]))
+		ev2heap_up(idx);
+	else
+		ev2heap_down(idx);
+}
+
+static ev2 *ev2pool_alloc(void)
+{
+	if (!ev2pool_free) {
+		// blocks are never freed, pointers to events must stay valid
+		ev2 *block = xcalloc(ev2, EV2_POOL_BLOCK);
+		for (int i = 0; i < EV2_POOL_BLOCK; i++) {
+			block[i].pooled = true;
+			block[i].heapidx = -1;
+			block[i].nextfree = ev2pool_free;
+			ev2pool_free = &block[i];
+		}
+	}
+	ev2 *e = ev2pool_free;
+	ev2pool_free = e->nextfree;
+	e->nextfree = NULL;
+	e->next = NULL;
+	return e;
+}
+
+// remove active event from the pending set, pooled events return to the pool
+static void ev2_release(ev2 *e)
+{
+	ev2heap_delete(e);
+	e->active = false;
+	if (e->pooled) {
+		e->nextfree = ev2pool_free;
+		ev2pool_free = e;
+	}
+}
+
+static void ev2_fire(ev2 *e)
+{
+	evfunc2 handler = e->handler;
+	uae_u32 data = e->data;
+	ev2_release(e);
+	handler(data);
+}
+
 void MISC_handler(void)
 {
-	static bool dorecheck;
-	bool recheck;
-	int i;
-	evt_t mintime;
 	evt_t ct = get_cycles();
 	static int recursive;
 
 	if (recursive) {
-		dorecheck = true;
+		// outer call will see the new event in the heap
 		return;
 	}
 	recursive++;
 	eventtab[ev_misc].active = 0;
-	recheck = true;
-	while (recheck) {
-		recheck = false;
-		mintime = EVT_MAX;
-		for (i = 0; i < ev2_max; i++) {
-			ev2 *e = &eventtab2[i];
-			if (e->active) {
-				if (e->evtime == ct) {
-					e->active = false;
-					e->handler(e->data);
-					ev2 *e2 = e->next;
-					if (e2) {
-						e->next = NULL;
-						if (e2->active && e2->evtime == e->evtime + 1) {
-							e2->active = false;
-							e2->handler(e2->data);
-						}
-					}
-					if (dorecheck || e->active) {
-						recheck = true;
-						dorecheck = false;
-					}
-				} else {
-					evt_t eventtime = e->evtime - ct;
-					if (eventtime < mintime)
-						mintime = eventtime;
-				}
-			}
+	// Overdue events (evtime < ct) fire too. The old scan only matched
+	// evtime == ct and left a missed event pending forever.
+	while (ev2heap_num > 0 && ev2heap[0]->evtime <= ct) {
+		ev2 *e = ev2heap[0];
+		evt_t evtime = e->evtime;
+		ev2 *e2 = e->next;
+		e->next = NULL;
+		ev2_fire(e);
+		// chained event that was scheduled for the same cycle runs immediately after
+		if (e2 && e2->active && e2->evtime == evtime + 1) {
+			ev2_fire(e2);
 		}
 	}
-	if (mintime < EVT_MAX) {
+	if (ev2heap_num > 0) {
 		ev *e = &eventtab[ev_misc];
 		e->active = true;
 		e->oldcycles = ct;
-		e->evtime = ct + mintime;
+		e->evtime = ev2heap[0]->evtime;
 		events_schedule();
 	}
 	recursive--;
@@ -396,46 +494,24 @@ void event2_newevent_xx_ce(evt_t t, uae_u32 data, evfunc2 func)
 
 void event2_newevent_xx(int no, evt_t t, uae_u32 data, evfunc2 func)
 {
-	evt_t et;
-	static int next = ev2_misc;
+	evt_t et = t + get_cycles();
+	ev2 *e;
 
-	et = t + get_cycles();
 	if (no < 0) {
-		no = next;
-		for (;;) {
-			if (!eventtab2[no].active) {
-				break;
-			}
-			if (eventtab2[no].evtime == et && eventtab2[no].handler == func && eventtab2[no].data == data)
-				break;
-			no++;
-			if (no == ev2_max)
-				no = ev2_misc;
-			if (no == next) {
-				write_log (_T("out of event2's!\n"));
-				// execute most recent event immediately
-				evt_t mintime = EVT_MAX;
-				int minevent = -1;
-				evt_t ct = get_cycles();
-				for (int i = 0; i < ev2_max; i++) {
-					if (eventtab2[i].active) {
-						evt_t eventtime = eventtab2[i].evtime - ct;
-						if (eventtime < mintime) {
-							mintime = eventtime;
-							minevent = i;
-						}
-					}
-				}
-				if (minevent >= 0) {
-					eventtab2[minevent].active = false;
-					eventtab2[minevent].handler(eventtab2[minevent].data);
-				}
-				continue;
-			}
+		// Identical to the previous request: nothing to add. Only the most
+		// recent event is compared, the old table scan also caught older
+		// identical pending events but that costs a walk of every event.
+		if (last_event2->active && last_event2->pooled && last_event2->evtime == et &&
+			last_event2->handler == func && last_event2->data == data) {
+			MISC_handler();
+			return;
 		}
-		next = no;
+		e = ev2pool_alloc();
+	} else {
+		e = &eventtab2[no];
+		if (e->active)
+			ev2heap_delete(e);
 	}
-	ev2 *e = &eventtab2[no];
 	// if previous event has same expiry time, make sure it gets executed first.
 	if (last_event2->active && last_event2 != e && et == last_event2->evtime) {
 		last_event2->next = e;
@@ -445,15 +521,23 @@ void event2_newevent_xx(int no, evt_t t, uae_u32 data, evfunc2 func)
 	e->evtime = et;
 	e->handler = func;
 	e->data = data;
+	ev2heap_insert(e);
 	last_event2 = e;
 	MISC_handler();
 }
 
+void event2_remove(ev2 *e)
+{
+	if (e->active)
+		ev2_release(e);
+}
+
 void event2_newevent_x_replace_exists(evt_t t, uae_u32 data, evfunc2 func)
 {
-	for (int i = 0; i < ev2_max; i++) {
-		if (eventtab2[i].active && eventtab2[i].handler == func) {
-			eventtab2[i].active = false;
+	for (int i = 0; i < ev2heap_num; i++) {
+		ev2 *e = ev2heap[i];
+		if (e->handler == func) {
+			ev2_release(e);
 			if (t <= 0) {
 				func(data);
 				return;
@@ -466,9 +550,12 @@ void event2_newevent_x_replace_exists(evt_t t, uae_u32 data, evfunc2 func)
 
 void event2_newevent_x_remove(evfunc2 func)
 {
-	for (int i = 0; i < ev2_max; i++) {
-		if (eventtab2[i].active && eventtab2[i].handler == func) {
-			eventtab2[i].active = false;
+	for (int i = 0; i < ev2heap_num; i++) {
+		ev2 *e = ev2heap[i];
+		if (e->handler == func) {
+			ev2_release(e);
+			// deletion reorders the heap, rescan
+			i = -1;
 		}
 	}
 }
@@ -483,11 +570,68 @@ void event2_newevent_x_replace(evt_t t, uae_u32 data, evfunc2 func)
 	event2_newevent_xx(-1, t * CYCLE_UNIT, data, func);
 }
 
-void event_init(void)
+static int ev2_compare(const void *a, const void *b)
+{
+	const ev2 *e1 = *(const ev2**)a;
+	const ev2 *e2 = *(const ev2**)b;
+	return ev2_before(e1, e2) ? -1 : (ev2_before(e2, e1) ? 1 : 0);
+}
+
+int event2_find(evfunc2 func, ev2 **list, int max)
+{
+	int cnt = 0;
+	for (int i = 0; i < ev2heap_num && cnt < max; i++) {
+		ev2 *e = ev2heap[i];
+		if (e->handler == func)
+			list[cnt++] = e;
+	}
+	qsort(list, cnt, sizeof(ev2*), ev2_compare);
+	return cnt;
+}
+
+void event2_flush(void)
+{
+	// execute events pending now once, in expiry order
+	int cnt = ev2heap_num;
+	if (!cnt)
+		return;
+	ev2 **list = xmalloc(ev2*, cnt);
+	uae_u64 *seqs = xmalloc(uae_u64, cnt);
+	memcpy(list, ev2heap, cnt * sizeof(ev2*));
+	qsort(list, cnt, sizeof(ev2*), ev2_compare);
+	for (int i = 0; i < cnt; i++) {
+		seqs[i] = list[i]->seq;
+	}
+	for (int i = 0; i < cnt; i++) {
+		ev2 *e = list[i];
+		// skip if already executed or rescheduled by an earlier handler
+		if (e->active && e->seq == seqs[i]) {
+			e->next = NULL;
+			ev2_fire(e);
+		}
+	}
+	xfree(seqs);
+	xfree(list);
+}
+
+void event2_clear(void)
 {
+	while (ev2heap_num > 0) {
+		ev2_release(ev2heap[0]);
+	}
+	for (int i = 0; i < ev2_max; i++) {
+		eventtab2[i].active = false;
+		eventtab2[i].heapidx = -1;
+		eventtab2[i].next = NULL;
+	}
 	last_event2 = &dummy_event;
 }
 
+void event_init(void)
+{
+	event2_clear();
+}
+
 int current_hpos(void)
 {
 	int hp = current_hpos_safe();
@@ -505,7 +649,54 @@ void clear_events(void)
 		eventtab[i].active = 0;
 		eventtab[i].oldcycles = get_cycles();
 	}
-	for (int i = 0; i < ev2_max; i++) {
-		eventtab2[i].active = 0;
+	event2_clear();
+}
+
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+/*
+ * Event2 scheduling trace in the order and with the delays (half CCKs)
+ * the callers use: delayed INTREQs from CIA/audio/disk, CIA ICR
+ * and TOD, audio DSR, paula serial at 9600 baud and the copper/blitter
+ * interrupt delays. Each burst is issued back to back, like a scanline.
+ */
+static const uae_u16 bench_ev2_trace[][2] = {
+	{ 23, 3 }, { 3, 7 }, { 8, 5 }, { 740, 0 }, { 23, 13 }, { 3, 8 },
+	{ 3, 9 }, { 3, 10 }, { 8, 4 }, { 140, 14 }, { 23, 3 }, { 744, 0 },
+	{ 8, 6 }, { 2, 1 }, { 3, 7 }, { 23, 13 }, { 454, 11 }, { 8, 5 },
+	{ 3, 8 }, { 740, 0 }, { 23, 3 }, { 8, 4 }, { 2, 12 }, { 3, 9 },
+	{ 140, 14 }, { 23, 13 }, { 8, 6 }, { 3, 10 }, { 744, 0 }, { 8, 5 },
+	{ 23, 3 }, { 454, 11 }
+};
+#define BENCH_EV2_BURST 8
+#define BENCH_EV2_EVENTS ((int)(sizeof bench_ev2_trace / sizeof bench_ev2_trace[0]))
+
+static uae_u32 bench_ev2_sum;
+
+static void bench_ev2_handler(uae_u32 data)
+{
+	bench_ev2_sum += data;
+}
+
+/* Replay the trace in scanline-sized bursts, dispatched in order */
+uae_u64 bench_events_ev2(int iterations)
+{
+	evt_t oldcycle = currcycle;
+
+	event2_clear();
+	for (int i = 0; i < iterations; i++) {
+		for (int j = 0; j < BENCH_EV2_EVENTS; j += BENCH_EV2_BURST) {
+			for (int k = j; k < j + BENCH_EV2_BURST; k++)
+				event2_newevent_xx(-1, bench_ev2_trace[k][0] * CYCLE_UNIT / 2, bench_ev2_trace[k][1], bench_ev2_handler);
+			while (eventtab[ev_misc].active) {
+				currcycle = eventtab[ev_misc].evtime;
+				MISC_handler();
+			}
+		}
 	}
+	currcycle = oldcycle;
+	event2_clear();
+	return (uae_u64)iterations * BENCH_EV2_EVENTS * sizeof(struct ev2);
 }
+#endif
@@ -860,6 +860,10 @@ static int set_filesys_volume (const TCHAR *rootdir, int *flags, bool *readonly,
 		*zvp = zv;
 		*flags = MYVOLUMEINFO_ARCHIVE;
 		*readonly = 1;
+#ifdef AMIBERRY
+		if (currprefs.archive_prefetch_threads > 0)
+			zfile_prefetch_archive (zv, currprefs.archive_prefetch_threads, currprefs.archive_prefetch_cache);
+#endif
 	} else {
 		*flags = my_getvolumeinfo (rootdir);
 		if (*flags < 0) {
@@ -4353,7 +4357,8 @@ static ExAllKey *getexall (Unit *unit, uaecptr control, int id)
 static int exalldo(TrapContext *ctx, uaecptr exalldata, uae_u32 exalldatasize, uae_u32 type, uaecptr control, Unit *unit, a_inode *aino)
 {
 	uaecptr exp = exalldata;
-	int i;
+	int i, len;
+	uae_u32 entries;
 	int size, size2;
 	int entrytype;
 	const TCHAR *xs = NULL, *commentx = NULL;
@@ -4363,6 +4368,7 @@ static int exalldo(TrapContext *ctx, uaecptr exalldata, uae_u32 exalldatasize, u
 	int fsdb_can = fsdb_cando (unit);
 	uae_u16 uid = 0, gid = 0;
 	char *x = NULL, *comment = NULL;
+	struct trap_batch tb;
 	int ret = 0;
 
 	memset (&statbuf, 0, sizeof statbuf);
@@ -4420,52 +4426,49 @@ static int exalldo(TrapContext *ctx, uaecptr exalldata, uae_u32 exalldatasize, u
 		size2 += 8;
 	}
 
-	i = trap_get_long(ctx, control + 0);
-	while (i > 0) {
+	entries = trap_get_long(ctx, control + 0);
+	for (i = entries; i > 0; i--)
 		exp = trap_get_long(ctx, exp); /* ed_Next */
-		i--;
-	}
 
 	if (exalldata + exalldatasize - exp < size + size2)
 		goto end; /* not enough space */
 
-	trap_put_long(ctx, exp, exp + size + size2); /* ed_Next */
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_long(&tb, exp, exp + size + size2); /* ed_Next */
 	if (type >= 1) {
-		trap_put_long(ctx, exp + 4, exp + size2);
-		for (i = 0; i <= strlen (x); i++) {
-			trap_put_byte(ctx, exp + size2, x[i]);
-			size2++;
-		}
+		trap_batch_put_long(&tb, exp + 4, exp + size2);
+		len = uaestrlen(x) + 1;
+		trap_batch_put_bytes(&tb, x, exp + size2, len);
+		size2 += len;
 	}
 	if (type >= 2)
-		trap_put_long(ctx, exp + 8, entrytype);
+		trap_batch_put_long(&tb, exp + 8, entrytype);
 	if (type >= 3)
-		trap_put_long(ctx, exp + 12, (uae_u32)(statbuf.size > MAXFILESIZE32 ? MAXFILESIZE32 : statbuf.size));
+		trap_batch_put_long(&tb, exp + 12, (uae_u32)(statbuf.size > MAXFILESIZE32 ? MAXFILESIZE32 : statbuf.size));
 	if (type >= 4)
-		trap_put_long(ctx, exp + 16, flags);
+		trap_batch_put_long(&tb, exp + 16, flags);
 	if (type >= 5) {
-		trap_put_long(ctx, exp + 20, days);
-		trap_put_long(ctx, exp + 24, mins);
-		trap_put_long(ctx, exp + 28, ticks);
+		trap_batch_put_long(&tb, exp + 20, days);
+		trap_batch_put_long(&tb, exp + 24, mins);
+		trap_batch_put_long(&tb, exp + 28, ticks);
 	}
 	if (type >= 6) {
-		trap_put_long(ctx, exp + 32, exp + size2);
-		trap_put_byte(ctx, exp + size2, (uae_u8)strlen(comment));
-		for (i = 0; i <= strlen (comment); i++) {
-			trap_put_byte(ctx, exp + size2, comment[i]);
-			size2++;
-		}
+		trap_batch_put_long(&tb, exp + 32, exp + size2);
+		len = uaestrlen(comment) + 1;
+		trap_batch_put_bytes(&tb, comment, exp + size2, len);
+		size2 += len;
 	}
 	if (type >= 7) {
-		trap_put_word(ctx, exp + 36, uid);
-		trap_put_word(ctx, exp + 38, gid);
+		trap_batch_put_word(&tb, exp + 36, uid);
+		trap_batch_put_word(&tb, exp + 38, gid);
 	}
 	if (type >= 8) {
-		trap_put_long(ctx, exp + 40, statbuf.size >> 32);
-		trap_put_long(ctx, exp + 44, (uae_u32)statbuf.size);
+		trap_batch_put_long(&tb, exp + 40, statbuf.size >> 32);
+		trap_batch_put_long(&tb, exp + 44, (uae_u32)statbuf.size);
 	}
 
-	trap_put_long(ctx, control + 0, trap_get_long(ctx, control + 0) + 1);
+	trap_batch_put_long(&tb, control + 0, entries + 1);
+	trap_batch_run(&tb);
 	ret = 1;
 end:
 	xfree (x);
@@ -5554,7 +5557,13 @@ static void	action_same_lock(TrapContext *ctx, Unit *unit, dpacket *packet)
 	if (!lock1 || !lock2) {
 		PUT_PCK_RES1 (packet, lock1 == lock2 ? DOS_TRUE : DOS_FALSE);
 	} else {
-		PUT_PCK_RES1 (packet, trap_get_long(ctx, lock1 + 4) == trap_get_long(ctx, lock2 + 4) ? DOS_TRUE : DOS_FALSE);
+		struct trap_batch tb;
+		uae_u32 key1, key2;
+		trap_batch_init(ctx, &tb);
+		trap_batch_get_long(&tb, &key1, lock1 + 4);
+		trap_batch_get_long(&tb, &key2, lock2 + 4);
+		trap_batch_run(&tb);
+		PUT_PCK_RES1 (packet, key1 == key2 ? DOS_TRUE : DOS_FALSE);
 	}
 }
 
@@ -5933,7 +5942,9 @@ static void	action_set_date(TrapContext *ctx, Unit *unit, dpacket *packet)
 		return;
 	}
 	if (!a->vfso) {
-		amiga_to_timeval (&tv, trap_get_long(ctx, date), trap_get_long(ctx, date + 4), trap_get_long(ctx, date + 8), 50);
+		uae_u32 ds[3];
+		trap_get_longs(ctx, ds, date, 3);
+		amiga_to_timeval (&tv, ds[0], ds[1], ds[2], 50);
 		//write_log (_T("%llu.%u (%d,%d,%d) %s\n"), tv.tv_sec, tv.tv_usec, trap_get_long(ctx, date), trap_get_long(ctx, date + 4), trap_get_long(ctx, date + 8), a->nname);
 		if (!my_utime (a->nname, &tv))
 			err = dos_errno ();
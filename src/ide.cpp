@@ -624,6 +624,7 @@ static void set_signature (struct ide_hdf *ide, bool hard)
 	}
 	ide->regs.ide_error = 0x01; // device ok
 	ide->packet_state = 0;
+	ide->burst_left = 0;
 }
 
 static void reset_device (struct ide_hdf *ide, bool both, bool hard)
@@ -1168,6 +1169,7 @@ static void ide_do_command (struct ide_hdf *ide, uae_u8 cmd)
 	ide->intdrq = false;
 	ide->lba48cmd = false;
 	ide->irq_delay = 0;
+	ide->burst_left = 0;
 
 	if (ide->atapi) {
 
@@ -1316,9 +1318,45 @@ static uae_u16 ide_get_data_2(struct ide_hdf *ide, int bussize)
 	return v;
 }
 
+/* Sustained 16-bit PIO runs only need the slow path for the word that
+ * completes a block (or the whole transfer). After each slow access,
+ * compute how many bytes can be moved before that happens and serve them
+ * straight from secbuf. */
+static void ide_burst_setup(struct ide_hdf *ide)
+{
+	ide->burst_left = 0;
+	if (IDE_LOG > 4 || ide->packet_state || ide->data_size <= 0 || !(ide->regs.ide_status & IDE_STATUS_DRQ))
+		return;
+	if (ide->blocksize <= 0 || ide->data_multi <= 0)
+		return;
+	int block = ide->blocksize * ide->data_multi;
+	int left = block - ide->data_offset % block;
+	if (left > ide->data_size)
+		left = ide->data_size;
+	if (ide->secbuf_size - (ide->buffer_offset + ide->data_offset) < left)
+		return;
+	ide->burst_offset = ide->data_offset;
+	ide->burst_left = (left - 2) & ~1;
+}
+
+static bool ide_burst_check(struct ide_hdf *ide)
+{
+	return ide->burst_left > 0 && ide->burst_offset == ide->data_offset && (ide->regs.ide_status & IDE_STATUS_DRQ);
+}
+
 uae_u16 ide_get_data(struct ide_hdf *ide)
 {
-	return ide_get_data_2(ide, 1);
+	if (ide_burst_check(ide)) {
+		uae_u8 *p = ide->secbuf + ide->buffer_offset + ide->data_offset;
+		ide->data_offset += 2;
+		ide->data_size -= 2;
+		ide->burst_offset += 2;
+		ide->burst_left -= 2;
+		return (p[0] << 8) | p[1];
+	}
+	uae_u16 v = ide_get_data_2(ide, 1);
+	ide_burst_setup(ide);
+	return v;
 }
 uae_u8 ide_get_data_8bit(struct ide_hdf *ide)
 {
@@ -1374,7 +1412,18 @@ static void ide_put_data_2(struct ide_hdf *ide, uae_u16 v, int bussize)
 
 void ide_put_data(struct ide_hdf *ide, uae_u16 v)
 {
+	if (ide_burst_check(ide)) {
+		uae_u8 *p = ide->secbuf + ide->buffer_offset + ide->data_offset;
+		p[0] = v >> 8;
+		p[1] = (uae_u8)v;
+		ide->data_offset += 2;
+		ide->data_size -= 2;
+		ide->burst_offset += 2;
+		ide->burst_left -= 2;
+		return;
+	}
 	ide_put_data_2(ide, v, 1);
+	ide_burst_setup(ide);
 }
 void ide_put_data_8bit(struct ide_hdf *ide, uae_u8 v)
 {
@@ -1806,5 +1855,6 @@ uae_u8 *ide_restore_state(uae_u8 *src, struct ide_hdf *ide)
 	ide->hdhfd.hfd.ci.surfaces = restore_u32 ();
 	ide->hdhfd.hfd.ci.reserved = restore_u32 ();
 	ide->hdhfd.hfd.ci.bootpri = restore_u32 ();
+	ide->burst_left = 0;
 	return src;
 }
@@ -0,0 +1,25 @@
+#ifndef UAE_BENCH_H
+#define UAE_BENCH_H
+
+#include "uae/types.h"
+
+/*
+ * Hooks for the amiberry-bench executable. Only compiled when AMIBERRY_BENCH
+ * is defined. Each kernel hook prepares synthetic input on its first call,
+ * runs the kernel 'iterations' times and returns the number of bytes processed.
+ */
+
+extern void bench_memory_init(uae_u32 chipsize);
+
+extern uae_u64 bench_drawing_doline(int planes, int iterations);
+extern uae_u64 bench_drawing_linetoscr(int iterations);
+extern uae_u64 bench_audio_sinc(int iterations);
+extern uae_u64 bench_p96_copyrow(int srcpixbytes, int iterations);
+extern uae_u64 bench_p96_planartodirect(int depth, int iterations);
+extern uae_u64 bench_disk_amigados(int iterations);
+extern uae_u64 bench_disk_pcdos(int iterations);
+extern uae_u64 bench_akiko_c2p(bool generic, int iterations);
+extern uae_u64 bench_events_ev2(int iterations);
+extern uae_u64 bench_serial_tcp(int iterations);
+
+#endif /* UAE_BENCH_H */
@@ -175,6 +175,7 @@ extern uae_u32 sys_command_cd_volume (int unitnum, uae_u16 volume_left, uae_u16
 extern int sys_command_cd_qcode (int unitnum, uae_u8*, int lsn, bool all);
 extern int sys_command_cd_toc (int unitnum, struct cd_toc_head*);
 extern int sys_command_cd_read (int unitnum, uae_u8 *data, int block, int size);
+extern int sys_command_cd_read_cached (int unitnum, uae_u8 *data, int block, int size);
 extern int sys_command_cd_rawread (int unitnum, uae_u8 *data, int sector, int size, int sectorsize);
 int sys_command_cd_rawread (int unitnum, uae_u8 *data, int sector, int size, int sectorsize, uae_u8 sectortype, uae_u8 scsicmd9, uae_u8 subs);
 extern int sys_command_read (int unitnum, uae_u8 *data, int block, int size);
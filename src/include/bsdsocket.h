@@ -74,9 +74,9 @@ struct socketbase {
 	void *hAsyncTask;		/* async task handle */
 	void *hEvent;		/* thread event handle */
 #else
-	uae_sem_t sem;		/* semaphore to notify the socket thread of work */
-	uae_thread_id thread;	/* socket thread */
-	int  sockabort[2];		/* pipe used to tell the thread to abort a select */
+	uae_sem_t sem;		/* posted when the socket reactor lets go of this base */
+	struct bsd_reactor_op *reactor;	/* pending operation state of the socket reactor */
+	int  sockabort[2];		/* pipe used to tell the reactor to abort a wait */
 	int action;
 	int s;			/* for accept */
 	uae_u32 name;		/* For gethostbyname */
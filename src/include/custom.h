@@ -60,6 +60,12 @@ extern int vpos, lof_store;
 
 extern int n_frames;
 
+#ifdef AMIBERRY
+/* True while run-ahead frames are being emulated that will be rolled back,
+ * output devices must not commit anything generated during them. */
+extern bool runahead_muted;
+#endif
+
 STATIC_INLINE int dmaen(unsigned int dmamask)
 {
 	return (dmamask & dmacon) && (dmacon & 0x200);
@@ -22,6 +22,8 @@ bool debugger_load_libraries(void);
 void debugger_scan_libraries(void);
 bool debugger_get_library_symbol(uaecptr base, uaecptr addr, TCHAR *out);
 bool debugmem_list_stackframe(bool super);
+int debugmem_get_branch_stack(uaecptr *pcs, int max);
+int debugmem_get_symbol_near(uaecptr addr, TCHAR *out, int maxsize, uae_u32 *offsetp);
 bool debugmem_break_stack_pop(void);
 bool debugmem_break_stack_push(void);
 bool debugmem_enable_stackframe(bool enable);
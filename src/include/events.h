@@ -66,6 +66,11 @@ struct ev2
 	uae_u32 data;
 	evfunc2 handler;
 	ev2 *next;
+	// scheduler internals
+	bool pooled;
+	int heapidx;
+	uae_u64 seq;
+	ev2 *nextfree;
 };
 
 // hsync handlers must have priority over misc
@@ -75,9 +80,10 @@ enum {
 	ev_max
 };
 
+// fixed ev2 events, anonymous ones are allocated from a growable pool
 enum {
-	ev2_blitter, ev2_disk, ev2_misc,
-	ev2_max = 12
+	ev2_blitter, ev2_disk,
+	ev2_max
 };
 
 extern int pissoff_value;
@@ -145,6 +151,10 @@ extern void event2_newevent_x_replace(evt_t t, uae_u32 data, evfunc2 func);
 extern void event2_newevent_x_replace_exists(evt_t t, uae_u32 data, evfunc2 func);
 extern void event2_newevent_x_remove(evfunc2 func);
 extern void event2_newevent_xx_ce(evt_t t, uae_u32 data, evfunc2 func);
+extern void event2_remove(struct ev2 *e);
+extern int event2_find(evfunc2 func, struct ev2 **list, int max);
+extern void event2_flush(void);
+extern void event2_clear(void);
 
 STATIC_INLINE void event2_newevent_x(int no, evt_t t, uae_u32 data, evfunc2 func)
 {
@@ -166,7 +176,7 @@ STATIC_INLINE void event2_newevent2(evt_t t, uae_u32 data, evfunc2 func)
 
 STATIC_INLINE void event2_remevent(int no)
 {
-	eventtab2[no].active = 0;
+	event2_remove(&eventtab2[no]);
 }
 
 void event_audxdat_func(uae_u32);
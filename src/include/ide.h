@@ -84,6 +84,8 @@ struct ide_hdf
 	int data_offset;
 	int data_size;
 	int data_multi;
+	int burst_offset; // PIO burst window: data_offset it starts at
+	int burst_left; // bytes that can be moved without a block transition
 	int direction; // 0 = read, 1 = write
 	bool intdrq;
 	bool lba;
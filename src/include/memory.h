@@ -505,20 +505,31 @@ extern addrbank *mem_banks[MEMORY_BANKS];
 extern uae_u8 *baseaddr[MEMORY_BANKS];
 #endif
 
+/* Host address of each 64KB bank that is plain RAM or ROM, so that
+ * get_long() and friends can skip the bank functions. NULL when the
+ * access has to go through the bank (I/O, custom chips, special banks). */
+extern uae_u8 *mem_direct_r[MEMORY_BANKS];
+extern uae_u8 *mem_direct_w[MEMORY_BANKS];
+extern void put_mem_direct(int bnr, addrbank *ab);
+extern void clear_mem_direct(addrbank *ab);
+
 #define get_mem_bank(addr) (*mem_banks[bankindex(addr)])
 extern addrbank *get_mem_bank_real(uaecptr);
 
 #ifdef JIT
 #define put_mem_bank(addr, b, realstart) do { \
 	(mem_banks[bankindex(addr)] = (b)); \
+	put_mem_direct(bankindex(addr), (b)); \
 	if ((b)->baseaddr) \
 		baseaddr[bankindex(addr)] = (b)->baseaddr - (realstart); \
 	else \
 		baseaddr[bankindex(addr)] = (uae_u8*)(((uae_u8*)b)+1); \
 } while (0)
 #else
-#define put_mem_bank(addr, b, realstart) \
-	(mem_banks[bankindex(addr)] = (b));
+#define put_mem_bank(addr, b, realstart) do { \
+	(mem_banks[bankindex(addr)] = (b)); \
+	put_mem_direct(bankindex(addr), (b)); \
+} while (0)
 #endif
 
 extern void memory_init (void);
@@ -553,22 +564,37 @@ uae_u32 memory_get_wordi(uaecptr);
 
 STATIC_INLINE uae_u32 get_long(uaecptr addr)
 {
+	uae_u8 *m = mem_direct_r[bankindex(addr)];
+	if (m)
+		return do_get_mem_long((uae_u32*)(m + (addr & 0xffff)));
 	return memory_get_long(addr);
 }
 STATIC_INLINE uae_u32 get_word (uaecptr addr)
 {
+	uae_u8 *m = mem_direct_r[bankindex(addr)];
+	if (m)
+		return do_get_mem_word((uae_u16*)(m + (addr & 0xffff)));
 	return memory_get_word(addr);
 }
 STATIC_INLINE uae_u32 get_byte (uaecptr addr)
 {
+	uae_u8 *m = mem_direct_r[bankindex(addr)];
+	if (m)
+		return m[addr & 0xffff];
 	return memory_get_byte(addr);
 }
 STATIC_INLINE uae_u32 get_longi(uaecptr addr)
 {
+	uae_u8 *m = mem_direct_r[bankindex(addr)];
+	if (m)
+		return do_get_mem_long((uae_u32*)(m + (addr & 0xffff)));
 	return memory_get_longi(addr);
 }
 STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 {
+	uae_u8 *m = mem_direct_r[bankindex(addr)];
+	if (m)
+		return do_get_mem_word((uae_u16*)(m + (addr & 0xffff)));
 	return memory_get_wordi(addr);
 }
 
@@ -576,45 +602,45 @@ STATIC_INLINE uae_u32 get_wordi(uaecptr addr)
 STATIC_INLINE uae_u32 get_long_compatible(uaecptr addr)
 {
 	if ((addr &0xffff) < 0xfffd) {
-		return memory_get_long(addr);
+		return get_long(addr);
 	} else if (addr & 1) {
-		uae_u8 v0 = memory_get_byte(addr + 0);
-		uae_u16 v1 = memory_get_word(addr + 1);
-		uae_u8 v3 = memory_get_byte(addr + 3);
+		uae_u8 v0 = get_byte(addr + 0);
+		uae_u16 v1 = get_word(addr + 1);
+		uae_u8 v3 = get_byte(addr + 3);
 		return (v0 << 24) | (v1 << 8) | (v3 << 0);
 	} else {
-		uae_u16 v0 = memory_get_word(addr + 0);
-		uae_u16 v1 = memory_get_word(addr + 2);
+		uae_u16 v0 = get_word(addr + 0);
+		uae_u16 v1 = get_word(addr + 2);
 		return (v0 << 16) | (v1 << 0);
 	}
 }
 STATIC_INLINE uae_u32 get_word_compatible(uaecptr addr)
 {
 	if ((addr & 0xffff) < 0xffff) {
-		return memory_get_word(addr);
+		return get_word(addr);
 	} else {
-		uae_u8 v0 = memory_get_byte(addr + 0);
-		uae_u8 v1 = memory_get_byte(addr + 1);
+		uae_u8 v0 = get_byte(addr + 0);
+		uae_u8 v1 = get_byte(addr + 1);
 		return (v0 << 8) | (v1 << 0);
 	}
 }
 STATIC_INLINE uae_u32 get_byte_compatible(uaecptr addr)
 {
-	return memory_get_byte(addr);
+	return get_byte(addr);
 }
 STATIC_INLINE uae_u32 get_longi_compatible(uaecptr addr)
 {
 	if ((addr & 0xffff) < 0xfffd) {
-		return memory_get_longi(addr);
+		return get_longi(addr);
 	} else {
-		uae_u16 v0 = memory_get_wordi(addr + 0);
-		uae_u16 v1 = memory_get_wordi(addr + 2);
+		uae_u16 v0 = get_wordi(addr + 0);
+		uae_u16 v1 = get_wordi(addr + 2);
 		return (v0 << 16) | (v1 << 0);
 	}
 }
 STATIC_INLINE uae_u32 get_wordi_compatible(uaecptr addr)
 {
-	return memory_get_wordi(addr);
+	return get_wordi(addr);
 }
 
 
@@ -624,7 +650,7 @@ STATIC_INLINE uae_u32 get_long_jit(uaecptr addr)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_read_flag;
 #endif
-	return memory_get_long(addr);
+	return get_long(addr);
 }
 STATIC_INLINE uae_u32 get_word_jit(uaecptr addr)
 {
@@ -632,7 +658,7 @@ STATIC_INLINE uae_u32 get_word_jit(uaecptr addr)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_read_flag;
 #endif
-	return memory_get_word(addr);
+	return get_word(addr);
 }
 STATIC_INLINE uae_u32 get_byte_jit(uaecptr addr)
 {
@@ -640,7 +666,7 @@ STATIC_INLINE uae_u32 get_byte_jit(uaecptr addr)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_read_flag;
 #endif
-	return memory_get_byte(addr);
+	return get_byte(addr);
 }
 STATIC_INLINE uae_u32 get_longi_jit(uaecptr addr)
 {
@@ -648,7 +674,7 @@ STATIC_INLINE uae_u32 get_longi_jit(uaecptr addr)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_read_flag;
 #endif
-	return memory_get_longi(addr);
+	return get_longi(addr);
 }
 STATIC_INLINE uae_u32 get_wordi_jit(uaecptr addr)
 {
@@ -656,7 +682,7 @@ STATIC_INLINE uae_u32 get_wordi_jit(uaecptr addr)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_read_flag;
 #endif
-	return memory_get_wordi(addr);
+	return get_wordi(addr);
 }
 
 /*
@@ -700,43 +726,55 @@ void memory_put_byte(uaecptr, uae_u32);
 
 STATIC_INLINE void put_long (uaecptr addr, uae_u32 l)
 {
-	memory_put_long(addr, l);
+	uae_u8 *m = mem_direct_w[bankindex(addr)];
+	if (m)
+		do_put_mem_long((uae_u32*)(m + (addr & 0xffff)), l);
+	else
+		memory_put_long(addr, l);
 }
 STATIC_INLINE void put_word (uaecptr addr, uae_u32 w)
 {
-	memory_put_word(addr, w);
+	uae_u8 *m = mem_direct_w[bankindex(addr)];
+	if (m)
+		do_put_mem_word((uae_u16*)(m + (addr & 0xffff)), w);
+	else
+		memory_put_word(addr, w);
 }
 STATIC_INLINE void put_byte (uaecptr addr, uae_u32 b)
 {
-	memory_put_byte(addr, b);
+	uae_u8 *m = mem_direct_w[bankindex(addr)];
+	if (m)
+		m[addr & 0xffff] = b;
+	else
+		memory_put_byte(addr, b);
 }
 
 // do split memory access if it can cross memory banks
 STATIC_INLINE void put_long_compatible(uaecptr addr, uae_u32 l)
 {
 	if ((addr & 0xffff) < 0xfffd) {
-		memory_put_long(addr, l);
+		put_long(addr, l);
 	} else if (addr & 1) {
-		memory_put_byte(addr + 0, l >> 24);
-		memory_put_word(addr + 1, l >>  8);
-		memory_put_byte(addr + 3, l >>  0);
+		put_byte(addr + 0, l >> 24);
+		put_word(addr + 1, l >>  8);
+		put_byte(addr + 3, l >>  0);
 	} else {
-		memory_put_word(addr + 0, l >> 16);
-		memory_put_word(addr + 2, l >>  0);
+		put_word(addr + 0, l >> 16);
+		put_word(addr + 2, l >>  0);
 	}
 }
 STATIC_INLINE void put_word_compatible(uaecptr addr, uae_u32 w)
 {
 	if ((addr & 0xffff) < 0xffff) {
-		memory_put_word(addr, w);
+		put_word(addr, w);
 	} else {
-		memory_put_byte(addr + 0, w >> 8);
-		memory_put_byte(addr + 1, w >> 0);
+		put_byte(addr + 0, w >> 8);
+		put_byte(addr + 1, w >> 0);
 	}
 }
 STATIC_INLINE void put_byte_compatible(uaecptr addr, uae_u32 b)
 {
-	memory_put_byte(addr, b);
+	put_byte(addr, b);
 }
 
 
@@ -746,7 +784,7 @@ STATIC_INLINE void put_long_jit(uaecptr addr, uae_u32 l)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_write_flag;
 #endif
-	memory_put_long(addr, l);
+	put_long(addr, l);
 }
 STATIC_INLINE void put_word_jit(uaecptr addr, uae_u32 l)
 {
@@ -754,7 +792,7 @@ STATIC_INLINE void put_word_jit(uaecptr addr, uae_u32 l)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_write_flag;
 #endif
-	memory_put_word(addr, l);
+	put_word(addr, l);
 }
 STATIC_INLINE void put_byte_jit(uaecptr addr, uae_u32 l)
 {
@@ -762,7 +800,7 @@ STATIC_INLINE void put_byte_jit(uaecptr addr, uae_u32 l)
 	addrbank *bank = &get_mem_bank(addr);
 	special_mem |= bank->jit_write_flag;
 #endif
-	memory_put_byte(addr, l);
+	put_byte(addr, l);
 }
 
 /*
@@ -1101,6 +1101,14 @@ struct uae_prefs
 	bool use_retroarch_statebuttons;
 	bool use_retroarch_vkbd;
 
+	int pcprofile_interval;
+	TCHAR pcprofile_file[MAX_DPATH];
+
+	int archive_prefetch_threads;
+	int archive_prefetch_cache;
+	int runahead; // experimental, see runahead_vsync()
+	int runahead_verify;
+
 #endif
 };
 
@@ -0,0 +1,9 @@
+#ifndef UAE_PCPROFILE_H
+#define UAE_PCPROFILE_H
+
+#include "uae/types.h"
+
+extern void pcprofile_install(void);
+extern void pcprofile_hsync(void);
+
+#endif /* UAE_PCPROFILE_H */
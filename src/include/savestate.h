@@ -256,6 +256,11 @@ extern void custom_prepare_savestate(void);
 
 extern bool savestate_check(void);
 
+extern bool savestate_runahead_possible(void);
+extern bool savestate_runahead_capture(void);
+extern bool savestate_runahead_rewind(void);
+extern bool savestate_runahead_restoring(void);
+
 #define STATE_SAVE 1
 #define STATE_RESTORE 2
 #define STATE_DOSAVE 4
@@ -142,6 +142,36 @@ void trap_set_bytes(TrapContext *ctx, uaecptr addr, uae_u8 v, int cnt);
 
 void trap_multi(TrapContext *ctx, struct trapmd *data, int items);
 
+/*
+ * Batched guest memory access. In indirect trap mode every trap_put/get
+ * call is a full round trip to the 68k side; a batch queues the accesses
+ * and submits them as one TRAPCMD_MULTI request. Operations execute in
+ * queue order. Values read by trap_batch_get_* are only valid after
+ * trap_batch_run(). In direct mode operations run immediately.
+ */
+#define TRAP_BATCH_ITEMS 32
+#define TRAP_BATCH_DATA (4096 - 144 - TRAP_BATCH_ITEMS * 5 * 4)
+
+struct trap_batch {
+	TrapContext *ctx;
+	bool indirect;
+	int items;
+	int datasize;
+	struct trapmd md[TRAP_BATCH_ITEMS];
+	uae_u16 offset[TRAP_BATCH_ITEMS];
+	uae_u8 data[TRAP_BATCH_DATA];
+};
+
+void trap_batch_init(TrapContext *ctx, struct trap_batch *tb);
+void trap_batch_put_long(struct trap_batch *tb, uaecptr addr, uae_u32 v);
+void trap_batch_put_word(struct trap_batch *tb, uaecptr addr, uae_u16 v);
+void trap_batch_put_byte(struct trap_batch *tb, uaecptr addr, uae_u8 v);
+void trap_batch_put_bytes(struct trap_batch *tb, const void *haddr, uaecptr addr, int cnt);
+void trap_batch_get_long(struct trap_batch *tb, uae_u32 *haddr, uaecptr addr);
+void trap_batch_get_word(struct trap_batch *tb, uae_u16 *haddr, uaecptr addr);
+void trap_batch_get_bytes(struct trap_batch *tb, void *haddr, uaecptr addr, int cnt);
+void trap_batch_run(struct trap_batch *tb);
+
 void trap_call_add_dreg(TrapContext *ctx, int reg, uae_u32 v);
 void trap_call_add_areg(TrapContext *ctx, int reg, uae_u32 v);
 uae_u32 trap_call_lib(TrapContext *ctx, uaecptr base, uae_s16 offset);
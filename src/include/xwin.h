@@ -59,6 +59,8 @@ extern bool target_graphics_buffer_update(int monid, bool force);
 extern float target_adjust_vblank_hz(int monid, float);
 extern int target_get_display_scanline(int displayindex);
 extern void target_spin(int);
+extern void target_calibrate_spin(void);
+extern void target_pace_until(uae_s64 deadline, void (*poll)(void));
 
 void getgfxoffset(int monid, float *dxp, float *dyp, float *mxp, float *myp);
 float target_getcurrentvblankrate(int monid);
@@ -48,6 +48,10 @@ struct znode {
     struct znode *next;
     struct znode *prev;
     struct znode *vfile; // points to real file when this node is virtual directory
+    struct znode *lastchild;
+    struct znode *hashnext; // next node in the volume name hash bucket
+    struct znode **sorted; // children sorted by name, built on demand
+    int sortedcnt;
     TCHAR *name;
     TCHAR *fullname;
     uae_s64 size;
@@ -62,6 +66,8 @@ struct znode {
     unsigned int packedsize;
 };
 
+struct zprefetch;
+
 struct zvolume
 {
     struct zfile *archive;
@@ -70,6 +76,9 @@ struct zvolume
     struct znode root;
     struct zvolume *next;
     struct znode *last;
+    struct znode **hash; // children hashed by parent and case folded name
+    unsigned int hashsize;
+    unsigned int hashcount;
     struct znode *parentz;
     struct zvolume *parent;
     uae_s64 size;
@@ -78,6 +87,7 @@ struct zvolume
     unsigned int method;
     TCHAR *volumename;
     int zfdmask;
+    struct zprefetch *prefetch; // background extraction state, if enabled
 };
 
 struct zarchive_info
@@ -145,6 +155,9 @@ extern void archive_access_scan (struct zfile *zf, zfile_callback zc, void *user
 extern void archive_access_close (void *handle, unsigned int id);
 
 extern struct zfile *archive_getzfile (struct znode *zn, unsigned int id, int flags);
+extern void archive_decoder_init (void);
+extern void archive_decoder_lock (void);
+extern void archive_decoder_unlock (void);
 extern struct zfile *archive_unpackzfile (struct zfile *zf);
 
 //extern struct zfile *decompress_zfd (struct zfile*);
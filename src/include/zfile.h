@@ -70,11 +70,14 @@ extern int zfile_getc(struct zfile *z);
 extern int zfile_putc(int c, struct zfile *z);
 extern int zfile_ferror(struct zfile *z);
 extern uae_u8 *zfile_getdata(struct zfile *z, uae_s64 offset, int len, int *outlen);
+extern void zfile_init(void);
 extern void zfile_exit(void);
 extern int execute_command(TCHAR *);
 extern int zfile_iscompressed(struct zfile *z);
 extern int zfile_zcompress(struct zfile *dst, void *src, size_t size);
 extern int zfile_zuncompress(void *dst, int dstsize, struct zfile *src, int srcsize);
+extern int zfile_zcompress_blocks(struct zfile *dst, void *src, size_t size, int blocksize);
+extern int zfile_zuncompress_blocks(void *dst, int dstsize, struct zfile *src, int srcsize);
 extern int zfile_gettype(struct zfile *z);
 #ifdef AMIBERRY
 extern int zfile_zopen(const std::string& name, zfile_callback zc, void* user);
@@ -132,6 +135,7 @@ extern struct zvolume *zfile_fopen_archive (const TCHAR *filename);
 extern struct zvolume *zfile_fopen_archive (const TCHAR *filename, int flags);
 extern struct zvolume *zfile_fopen_archive_root (const TCHAR *filename, int flags);
 extern void zfile_fclose_archive (struct zvolume *zv);
+extern void zfile_prefetch_archive (struct zvolume *zv, int threads, int cachemb);
 extern int zfile_fs_usage_archive (const TCHAR *path, const TCHAR *disk, struct fs_usage *fsp);
 extern int zfile_stat_archive (const TCHAR *path, struct mystat *statbuf);
 extern struct zdirectory *zfile_opendir_archive (const TCHAR *path);
@@ -19,6 +19,7 @@
 #include "isofs.h"
 
 #define MAX_CACHED_BH_COUNT 100
+#define BH_HASH_SIZE 256
 //#define MAX_CACHE_INODE_COUNT 10
 #define HASH_SIZE 65536
 
@@ -38,11 +39,10 @@
 
 struct buffer_head
 {
-	struct buffer_head *next;
+	struct buffer_head *next, *prev;
+	struct buffer_head *hashnext;
 	uae_u8 *b_data;
 	uae_u32 b_blocknr;
-	bool linked;
-	int usecnt;
 	struct super_block *sb;
 };
 
@@ -80,7 +80,8 @@ struct super_block
 	int unitnum;
 	struct inode *inodes, *root;
 	int inode_cnt;
-	struct buffer_head *buffer_heads;
+	struct buffer_head *buffer_heads, *buffer_heads_last;
+	struct buffer_head *bh_hash[BH_HASH_SIZE];
 	int bh_count;
 	bool unknown_media;
 	struct inode *hash[HASH_SIZE];
@@ -182,50 +183,67 @@ static struct inode *find_inode(struct super_block *sb, uae_u64 uniq)
 	return NULL;
 }
 
+static void bh_unlink(struct super_block *sb, struct buffer_head *bh)
+{
+	if (bh->prev)
+		bh->prev->next = bh->next;
+	else
+		sb->buffer_heads = bh->next;
+	if (bh->next)
+		bh->next->prev = bh->prev;
+	else
+		sb->buffer_heads_last = bh->prev;
+}
+
+static void bh_link_first(struct super_block *sb, struct buffer_head *bh)
+{
+	bh->prev = NULL;
+	bh->next = sb->buffer_heads;
+	if (sb->buffer_heads)
+		sb->buffer_heads->prev = bh;
+	else
+		sb->buffer_heads_last = bh;
+	sb->buffer_heads = bh;
+}
+
+// Buffer heads are kept in most recently used order and hashed by block
+// number. The data itself comes from the blkdev sector cache.
 static buffer_head *sb_bread(struct super_block *sb, uae_u32 block)
 {
-	struct buffer_head *bh;
+	struct buffer_head *bh, **pp;
 	
-	bh = sb->buffer_heads;
+	bh = sb->bh_hash[block & (BH_HASH_SIZE - 1)];
 	while (bh) {
 		if (bh->b_blocknr == block) {
-			bh->usecnt++;
+			if (bh != sb->buffer_heads) {
+				bh_unlink(sb, bh);
+				bh_link_first(sb, bh);
+			}
 			return bh;
 		}
-		bh = bh->next;
+		bh = bh->hashnext;
 	}
-	// simple LRU block cache. Should be in blkdev, not here..
 	while (sb->bh_count > MAX_CACHED_BH_COUNT) {
-		struct buffer_head *minbh = NULL, *minbhprev = NULL;
-		struct buffer_head *prev = NULL;
-		bh = sb->buffer_heads;
-		while (bh) {
-			if (minbh == NULL || bh->usecnt < minbh->usecnt) {
-				minbh = bh;
-				minbhprev = prev;
-			}
-			prev = bh;
-			bh = bh->next;
-		}
-		if (minbh) {
-			if (minbhprev)
-				minbhprev->next = minbh->next;
-			else
-				sb->buffer_heads = minbh->next;
-			free_bh(minbh);
-		}
+		bh = sb->buffer_heads_last;
+		bh_unlink(sb, bh);
+		pp = &sb->bh_hash[bh->b_blocknr & (BH_HASH_SIZE - 1)];
+		while (*pp != bh)
+			pp = &(*pp)->hashnext;
+		*pp = bh->hashnext;
+		free_bh(bh);
 	}
 	bh = xcalloc (struct buffer_head, 1);
 	bh->sb = sb;
 	bh->b_data = xmalloc (uae_u8, CD_BLOCK_SIZE);
 	bh->b_blocknr = block;
-	if (sys_command_cd_read (sb->unitnum, bh->b_data, block, 1)) {
-		bh->next = sb->buffer_heads;
-		sb->buffer_heads = bh;
-		bh->linked = true;
+	if (sys_command_cd_read_cached (sb->unitnum, bh->b_data, block, 1)) {
+		bh_link_first(sb, bh);
+		bh->hashnext = sb->bh_hash[block & (BH_HASH_SIZE - 1)];
+		sb->bh_hash[block & (BH_HASH_SIZE - 1)] = bh;
 		sb->bh_count++;
 		return bh;
 	}
+	xfree (bh->b_data);
 	xfree (bh);
 	return NULL;
 }
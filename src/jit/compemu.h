@@ -143,6 +143,15 @@ extern void alloc_cache(void);
 extern void compile_block(cpu_history* pc_hist, int blocklen, int totcyles);
 extern int check_for_cache_miss(void);
 
+/* Translation cache statistics */
+struct jit_cache_stats {
+  uae_u32 evictions;       /* segments reclaimed for new code */
+  uae_u32 evicted_blocks;  /* blocks whose code was thrown away by that */
+  uae_u32 recompiles;      /* evicted blocks that were translated again */
+  uae_u32 hard_flushes;    /* complete cache wipes */
+};
+extern struct jit_cache_stats jit_cache_stats;
+
 #define scaled_cycles(x) (currprefs.m68k_speed<0?(((x)/SCALE)?(((x)/SCALE<MAXCYCLES?((x)/SCALE):MAXCYCLES)):1):(x))
 
 /* JIT FPU compilation */
@@ -362,6 +371,9 @@ typedef struct blockinfo_t {
   uae_u8 optlevel;
   uae_u8 needed_flags;
   uae_u8 status;
+  uae_u8 segment;    /* Translation cache segment holding the code */
+  uae_u8 evicted;    /* Code was dropped by a segment eviction */
+  uae_s32 exec_count; /* Decremented by the compiled code on every run */
 
   dependency  dep[2];  /* Holds things we depend on */
   dependency* deplist; /* List of things that depend on this */
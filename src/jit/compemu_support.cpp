@@ -133,6 +133,8 @@ static int branch_cc;
 
 uae_u8* current_compile_p = NULL;
 static uae_u8* max_compile_start;
+static uae_u8* stub_compile_p = NULL;
+static uae_u8* max_stub_start;
 uae_u8* compiled_code = NULL;
 const int POPALLSPACE_SIZE = 2048; /* That should be enough space */
 uae_u8* popallspace = NULL;
@@ -1329,6 +1331,9 @@ void compiler_exit(void)
         popallspace = 0;
     }
 
+    jit_log("Translation cache: %u segment evictions (%u blocks, %u recompiled), %u hard flushes",
+        jit_cache_stats.evictions, jit_cache_stats.evicted_blocks, jit_cache_stats.recompiles, jit_cache_stats.hard_flushes);
+
 #ifdef PROFILE_COMPILE_TIME
     jit_log("### Compile Block statistics");
     jit_log("Number of calls to compile_block : %d", compile_count);
@@ -1840,6 +1845,119 @@ void set_cache_state(int enabled)
     cache_enabled = enabled;
 }
 
+/* The translation cache is split into segments that are filled one after
+   the other. Once the current segment is full, the coldest other one, going
+   by the execution counters of the blocks compiled into it, is evicted and
+   reused instead of flushing the whole cache. The direct_pen/direct_pcc
+   stubs of all blockinfos live in a separate area at the top of the cache
+   which only a hard flush reclaims, so evicted blocks stay valid jump
+   targets for the blocks that are still linked to them. */
+#define CACHE_SEGMENTS 8
+#define STUB_AREA_MARGIN 256
+
+static uae_u8* cache_seg_start[CACHE_SEGMENTS + 1];
+static int cache_segments;     // 1 means no eviction, flush everything instead
+static int cache_seg;          // Segment new code goes to
+static uae_u32 cache_seg_used; // Segments that have held code since the last hard flush
+
+struct jit_cache_stats jit_cache_stats;
+
+static void cache_set_segment(int seg)
+{
+    cache_seg = seg;
+    cache_seg_used |= 1 << seg;
+    current_compile_p = cache_seg_start[seg];
+#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
+    max_compile_start = cache_seg_start[seg + 1] - BYTES_PER_INST - DATA_BUFFER_SIZE;
+    reset_data_buffer();
+#else
+    max_compile_start = cache_seg_start[seg + 1] - BYTES_PER_INST;
+#endif
+}
+
+static void cache_layout(void)
+{
+    uae_u32 total = cache_size * 1024;
+    uae_u32 stubsize = total / 8;
+    uae_u32 segsize;
+    int i;
+
+    stub_compile_p = compiled_code + total - stubsize;
+    max_stub_start = compiled_code + total - STUB_AREA_MARGIN;
+
+    /* Each segment has to hold a good number of maximum sized blocks */
+    cache_segments = CACHE_SEGMENTS;
+    while (cache_segments > 1 && (total - stubsize) / cache_segments < 8 * BYTES_PER_INST)
+        cache_segments--;
+    segsize = ((total - stubsize) / cache_segments) & ~15;
+    for (i = 0; i < cache_segments; i++)
+        cache_seg_start[i] = compiled_code + i * segsize;
+    cache_seg_start[cache_segments] = compiled_code + total - stubsize;
+
+    cache_seg_used = 0;
+    cache_set_segment(0);
+}
+
+static void evict_block(blockinfo* bi)
+{
+    uae_u32 cl = cacheline(bi->pc_p);
+    bool translated = bi->count < 0;
+
+    /* Points everything linked to us back at our execute_normal stub */
+    invalidate_block(bi);
+    if (translated)
+        bi->count = -1; /* Was hot enough before, translate it right away */
+    if (bi == cache_tags[cl + 1].bi)
+        cache_tags[cl].handler = bi->handler_to_use;
+    bi->evicted = 1;
+    jit_cache_stats.evicted_blocks++;
+}
+
+/* Current segment is full: move on to the coldest of the others */
+static void evict_segment(void)
+{
+    uae_u64 heat[CACHE_SEGMENTS];
+    blockinfo* bi;
+    blockinfo* next;
+    int i, pass, victim = -1;
+
+    if (cache_segments < 2) {
+        flush_icache_hard(3);
+        return;
+    }
+
+    for (i = 0; i < cache_segments; i++) {
+        if (i != cache_seg && !(cache_seg_used & (1 << i))) {
+            cache_set_segment(i);
+            return;
+        }
+    }
+
+    memset(heat, 0, sizeof(heat));
+    for (pass = 0; pass < 2; pass++) {
+        for (bi = pass ? dormant : active; bi; bi = bi->next) {
+            if (!bi->direct_handler)
+                continue;
+            heat[bi->segment] += (uae_u32)0 - (uae_u32)bi->exec_count;
+            bi->exec_count /= 2; /* Age, so that old work doesn't pin a segment */
+        }
+    }
+    for (i = 0; i < cache_segments; i++) {
+        if (i != cache_seg && (victim < 0 || heat[i] < heat[victim]))
+            victim = i;
+    }
+
+    for (pass = 0; pass < 2; pass++) {
+        for (bi = pass ? dormant : active; bi; bi = next) {
+            next = bi->next;
+            if (bi->direct_handler && bi->segment == victim)
+                evict_block(bi);
+        }
+    }
+    jit_cache_stats.evictions++;
+    cache_set_segment(victim);
+}
+
 void alloc_cache(void)
 {
     if (compiled_code) {
@@ -1856,16 +1974,8 @@ void alloc_cache(void)
 
     if (compiled_code) {
         write_log("Actual translation cache size : %d KB at %p-%p\n", cache_size, compiled_code, compiled_code + cache_size * 1024);
-#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
-        max_compile_start = compiled_code + cache_size * 1024 - BYTES_PER_INST - DATA_BUFFER_SIZE;
-#else
-        max_compile_start = compiled_code + cache_size * 1024 - BYTES_PER_INST;
-#endif
-        current_compile_p = compiled_code;
+        cache_layout();
         current_cache_size = 0;
-#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
-        reset_data_buffer();
-#endif
     }
 }
 
@@ -2133,15 +2243,21 @@ static void prepare_block(blockinfo* bi)
 {
     int i;
 
-    set_target(current_compile_p);
+#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
+    reset_data_buffer();
+#endif
+    set_target(stub_compile_p);
     bi->direct_pen = (cpuop_func*)get_target();
     compemu_raw_execute_normal((uintptr) & (bi->pc_p));
 
     bi->direct_pcc = (cpuop_func*)get_target();
     compemu_raw_check_checksum((uintptr) & (bi->pc_p));
 
-    flush_cpu_icache((void*)current_compile_p, (void*)target);
-    current_compile_p = get_target();
+    flush_cpu_icache((void*)stub_compile_p, (void*)target);
+    stub_compile_p = get_target();
+#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
+    reset_data_buffer();
+#endif
 
     bi->deplist = NULL;
     for (i = 0; i < 2; i++) {
@@ -2149,6 +2265,9 @@ static void prepare_block(blockinfo* bi)
         bi->dep[i].next = NULL;
     }
     bi->status = BI_INVALID;
+    bi->segment = 0;
+    bi->evicted = 0;
+    bi->exec_count = 0;
 }
 
 void compemu_reset(void)
@@ -2156,6 +2275,15 @@ void compemu_reset(void)
     set_cache_state(0);
 }
 
+/* True if the current PC has live translated code, for the PC profiler */
+bool compemu_pc_translated(void)
+{
+    if (!cache_enabled || !compiled_code)
+        return false;
+    blockinfo* bi = get_blockinfo_addr(regs.pc_p);
+    return bi && bi->handler && (bi->status == BI_ACTIVE || bi->status == BI_NEED_CHECK || bi->status == BI_CHECKING);
+}
+
 // OPCODE is in big endian format
 STATIC_INLINE void reset_compop(int opcode)
 {
@@ -2284,11 +2412,8 @@ void flush_icache_hard(int n)
     if (!compiled_code)
         return;
 
-#if defined(CPU_arm) && !defined(ARMV6T2) && !defined(CPU_AARCH64)
-    reset_data_buffer();
-#endif
-
-    current_compile_p = compiled_code;
+    cache_layout();
+    jit_cache_stats.hard_flushes++;
     set_special(0); /* To get out of compiled code */
 }
 
@@ -2363,9 +2488,12 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
         blockinfo* bi2;
 
         if (current_compile_p >= MAX_COMPILE_PTR)
+            evict_segment();
+        if (stub_compile_p >= max_stub_start)
             flush_icache_hard(3);
 
         alloc_blockinfos();
+        set_target(current_compile_p);
 
         bi = get_blockinfo_addr_new(pc_hist[0].location);
         bi2 = get_blockinfo(cl);
@@ -2420,6 +2548,14 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
         bi->status = BI_COMPILING;
         current_block_start_target = (uintptr)get_target();
 
+        if (bi->evicted) {
+            jit_cache_stats.recompiles++;
+            bi->evicted = 0;
+        }
+        bi->segment = cache_seg;
+        bi->exec_count = 0;
+        compemu_raw_dec_m((uintptr) & (bi->exec_count));
+
         if (bi->count >= 0) { /* Need to generate countdown code */
             compemu_raw_set_pc_i((uintptr)pc_hist[0].location);
             compemu_raw_dec_m((uintptr) & (bi->count));
@@ -2617,9 +2753,9 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
         raise_in_cl_list(bi);
         bi->nexthandler = current_compile_p;
 
-        /* We will flush soon, anyway, so let's do it now */
+        /* We will have to make room soon, anyway, so let's do it now */
         if (current_compile_p >= MAX_COMPILE_PTR)
-            flush_icache_hard(3);
+            evict_segment();
 
         bi->status = BI_ACTIVE;
 
@@ -127,6 +127,40 @@ case, bit 0 is set (the memory access routines will take care of it).  */
 
 uae_u8 *baseaddr[MEMORY_BANKS];
 
+uae_u8 *mem_direct_r[MEMORY_BANKS];
+uae_u8 *mem_direct_w[MEMORY_BANKS];
+
+/* Only whole 64KB pages that fall inside the allocation are served
+directly, everything else keeps using the bank functions.  */
+void put_mem_direct(int bnr, addrbank *ab)
+{
+	uae_u32 offset;
+
+	mem_direct_r[bnr] = NULL;
+	mem_direct_w[bnr] = NULL;
+	if (!ab->baseaddr_direct_r && !ab->baseaddr_direct_w)
+		return;
+	if ((ab->mask & 0xffff) != 0xffff || (ab->startaccessmask & 0xffff))
+		return;
+	offset = (((uae_u32)bnr << 16) - ab->startaccessmask) & ab->mask;
+	if (ab->allocated_size < 0x10000 || offset > ab->allocated_size - 0x10000)
+		return;
+	if (ab->baseaddr_direct_r)
+		mem_direct_r[bnr] = ab->baseaddr_direct_r + offset;
+	if (ab->baseaddr_direct_w)
+		mem_direct_w[bnr] = ab->baseaddr_direct_w + offset;
+}
+
+void clear_mem_direct(addrbank *ab)
+{
+	for (int i = 0; i < MEMORY_BANKS; i++) {
+		if (mem_banks[i] == ab) {
+			mem_direct_r[i] = NULL;
+			mem_direct_w[i] = NULL;
+		}
+	}
+}
+
 #ifdef NO_INLINE_MEMORY_ACCESS
 __inline__ uae_u32 longget (uaecptr addr)
 {
@@ -981,6 +1015,8 @@ void (REGPARAM2 *chipmem_bput_indirect)(uaecptr, uae_u32);
 int (REGPARAM2 *chipmem_check_indirect)(uaecptr, uae_u32);
 uae_u8 *(REGPARAM2 *chipmem_xlate_indirect)(uaecptr);
 
+static void set_direct_memory(addrbank *ab);
+
 void chipmem_setindirect(void)
 {
 #ifdef DEBUGGER
@@ -1031,6 +1067,12 @@ void chipmem_setindirect(void)
 		chipmem_bank.wput = chipmem_wput;
 		chipmem_bank.lput = chipmem_lput;
 	}
+	// the read handlers may have changed while chip RAM is mapped
+	set_direct_memory(&chipmem_bank);
+	for (int i = 0; i < MEMORY_BANKS; i++) {
+		if (mem_banks[i] == &chipmem_bank)
+			put_mem_direct(i, &chipmem_bank);
+	}
 }
 
 /* Slow memory */
@@ -2112,6 +2154,15 @@ err:
 
 static void set_direct_memory(addrbank *ab)
 {
+	ab->baseaddr_direct_r = NULL;
+	ab->baseaddr_direct_w = NULL;
+	if (ab == &chipmem_bank) {
+		// reads only, Action Replay replaces the chip RAM write handlers.
+		// Any other read handler (1.5M limit, debugmem) must see every access.
+		if (ab->lget == chipmem_lget && ab->wget == chipmem_wget && ab->bget == chipmem_bget)
+			ab->baseaddr_direct_r = ab->baseaddr;
+		return;
+	}
 	if (!(ab->flags & ABFLAG_DIRECTACCESS))
 		return;
 	ab->baseaddr_direct_r = ab->baseaddr;
@@ -2394,8 +2445,10 @@ static void setmemorywidth(struct ramboard *mb, addrbank *ab)
 		}
 	}
 	if (mb->fault) {
+		ab->flags &= ~ABFLAG_DIRECTACCESS;
 		ab->baseaddr_direct_w = NULL;
 		ab->baseaddr_direct_r = NULL;
+		clear_mem_direct(ab);
 		ab->lput = &dummy_lput;
 		ab->wput = &dummy_wput;
 		ab->bput = &dummy_bput;
@@ -3223,6 +3276,7 @@ static void map_banks2 (addrbank *bank, int start, int size, int realsize, int q
 	addrbank *orig_bank = NULL;
 
 	bank->flags |= ABFLAG_MAPPED;
+	set_direct_memory(bank);
 
 #ifdef WITH_THREADED_CPU
 	if (currprefs.cpu_thread) {
@@ -3959,3 +4013,18 @@ uae_u8 dma_get_byte(uaecptr addr)
 		return 0xff;
 	return get_byte(addr);
 }
+
+#ifdef AMIBERRY_BENCH
+/* Plain chip RAM mapped at address 0, without the natmem setup memory_reset() needs */
+void bench_memory_init(uae_u32 chipsize)
+{
+	init_mem_banks();
+	chipmem_bank.baseaddr = xcalloc(uae_u8, chipsize);
+	chipmem_bank.reserved_size = chipmem_bank.allocated_size = chipsize;
+	chipmem_bank.mask = chipmem_full_mask = chipsize - 1;
+	chipmem_full_size = chipsize;
+	chipmem_setindirect();
+	for (uae_u32 i = 0; i < (chipsize >> 16); i++)
+		put_mem_bank(i << 16, &chipmem_bank, 0);
+}
+#endif
@@ -3646,22 +3646,131 @@ static int cpu_thread_run_2(void *v)
 }
 #endif
 
+/* Block cache for the fast interpreter loops
+
+   The first time a stretch of code runs, it is executed normally while the
+   opcode, handler and host PC offset of each instruction are recorded, up
+   to the next change of flow. Later runs dispatch straight from that record
+   and account the cycles of the whole block at once. Before every
+   instruction the host PC and the opcode word in memory are compared with
+   the record, so taken branches, exceptions and modified code simply leave
+   the block and fall back to recording. */
+
+#define ICB_HASH_BITS 12
+#define ICB_MAXINSNS 32
+
+struct icb_insn {
+	cpuop_func *handler;
+	uae_u16 opcode;
+	uae_u16 offset;
+};
+
+struct icb_block {
+	uae_u8 *start;
+	uae_u32 gen;
+	int count;
+	struct icb_insn insn[ICB_MAXINSNS];
+};
+
+static struct icb_block *icb_blocks;
+static uae_u32 icb_gen;
+static int icb_cycles;
+
+/* Called when entering a run loop, cpufunctbl may have been rebuilt */
+static void icb_reset(void)
+{
+	if (!icb_blocks)
+		icb_blocks = xcalloc(struct icb_block, 1 << ICB_HASH_BITS);
+	icb_gen++;
+	if (icb_gen == 0) {
+		memset(icb_blocks, 0, sizeof(struct icb_block) << ICB_HASH_BITS);
+		icb_gen = 1;
+	}
+	icb_cycles = 0;
+}
+
+/* An exception left a block early, account what did run */
+static void icb_abort(void)
+{
+	if (icb_cycles) {
+		do_cycles(icb_cycles);
+		icb_cycles = 0;
+	}
+}
+
+static void icb_record(struct regstruct *r, struct icb_block *b)
+{
+	uae_u8 *start = r->pc_p;
+	uae_u8 *p;
+
+	b->gen = 0;
+	b->start = start;
+	b->count = 0;
+	for (;;) {
+		p = r->pc_p;
+		r->instruction_pc = m68k_getpc();
+		r->opcode = get_diword(0);
+
+		if (b->count < ICB_MAXINSNS && p >= start && p - start <= 0xffff) {
+			struct icb_insn *in = &b->insn[b->count++];
+			in->handler = cpufunctbl[r->opcode];
+			in->opcode = r->opcode;
+			in->offset = (uae_u16)(p - start);
+		}
+
+		cpu_cycles = (*cpufunctbl[r->opcode])(r->opcode);
+		cpu_cycles = adjust_cycles(cpu_cycles);
+		do_cycles(cpu_cycles);
+
+		if (r->spcflags || b->count >= ICB_MAXINSNS || (table68k[r->opcode].cflow & fl_end_block))
+			break;
+	}
+	b->gen = icb_gen;
+}
+
+/* Returns false if the record did not match at all */
+static bool icb_execute(struct regstruct *r, struct icb_block *b)
+{
+	struct icb_insn *in = b->insn;
+	struct icb_insn *end = in + b->count;
+
+	do {
+		if (r->pc_p != b->start + in->offset || do_get_mem_word((uae_u16 *)r->pc_p) != in->opcode)
+			break;
+		r->instruction_pc = m68k_getpc();
+		r->opcode = in->opcode;
+		cpu_cycles = in->handler(in->opcode);
+		cpu_cycles = adjust_cycles(cpu_cycles);
+		icb_cycles += cpu_cycles;
+		in++;
+	} while (in < end && !r->spcflags);
+
+	if (in == b->insn)
+		return false;
+	do_cycles(icb_cycles);
+	icb_cycles = 0;
+	return true;
+}
+
+STATIC_INLINE void icb_step(struct regstruct *r)
+{
+	struct icb_block *b = &icb_blocks[((uintptr_t)r->pc_p >> 1) & ((1 << ICB_HASH_BITS) - 1)];
+
+	if (b->gen != icb_gen || b->start != r->pc_p || !icb_execute(r, b))
+		icb_record(r, b);
+}
+
 /* Same thing, but don't use prefetch to get opcode.  */
 static void m68k_run_2_000(void)
 {
 	struct regstruct *r = &regs;
 	bool exit = false;
 
+	icb_reset();
 	while (!exit) {
 		TRY(prb) {
 			while (!exit) {
-				r->instruction_pc = m68k_getpc ();
-
-				r->opcode = get_diword(0);
-
-				cpu_cycles = (*cpufunctbl[r->opcode])(r->opcode);
-				cpu_cycles = adjust_cycles (cpu_cycles);
-				do_cycles(cpu_cycles);
+				icb_step(r);
 
 				if (r->spcflags) {
 					if (do_specialties (cpu_cycles))
@@ -3669,6 +3778,7 @@ static void m68k_run_2_000(void)
 				}
 			}
 		} CATCH(prb) {
+			icb_abort();
 			bus_error();
 			if (r->spcflags) {
 				if (do_specialties(cpu_cycles))
@@ -3690,16 +3800,11 @@ static void m68k_run_2_020(void)
 	struct regstruct *r = &regs;
 	bool exit = false;
 
+	icb_reset();
 	while (!exit) {
 		TRY(prb) {
 			while (!exit) {
-				r->instruction_pc = m68k_getpc();
-
-				r->opcode = get_diword(0);
-
-				cpu_cycles = (*cpufunctbl[r->opcode])(r->opcode);
-				cpu_cycles = adjust_cycles(cpu_cycles);
-				do_cycles(cpu_cycles);
+				icb_step(r);
 
 				if (r->spcflags) {
 					if (do_specialties(cpu_cycles))
@@ -3707,6 +3812,7 @@ static void m68k_run_2_020(void)
 				}
 			}
 		} CATCH(prb) {
+			icb_abort();
 			bus_error();
 			if (r->spcflags) {
 				if (do_specialties(cpu_cycles))
@@ -3772,6 +3878,7 @@ void m68k_go (int may_quit)
 	in_m68k_go++;
 	for (;;) {
 		int restored = 0;
+		bool runahead_restore = false;
 		void (*run_func)(void);
 
 		cputrace.state = -1;
@@ -3803,13 +3910,20 @@ void m68k_go (int may_quit)
 				restore_state (savestate_fname);
 			else if (savestate_state == STATE_REWIND)
 				savestate_rewind ();
+			runahead_restore = savestate_runahead_restoring ();
 #endif
-			prefs_changed_cpu();
-			build_cpufunctbl();
+			// run-ahead rollbacks keep the CPU tables, CPU option changes
+			// are picked up by the SPCFLAG_MODE_CHANGE path instead
+			if (!runahead_restore) {
+				prefs_changed_cpu();
+				build_cpufunctbl();
+			}
 			set_x_funcs();
 			set_cycles (start_cycles);
 			custom_reset (cpu_hardreset != 0, cpu_keyboardreset);
 			m68k_reset (cpu_hardreset != 0);
+			if (runahead_restore && cpu_prefs_changed_flag)
+				set_special(SPCFLAG_MODE_CHANGE);
 			if (cpu_hardreset) {
 				memory_clear ();
 				write_log (_T("hardreset, memory cleared\n"));
@@ -3833,7 +3947,8 @@ void m68k_go (int may_quit)
 				savestate_check ();
 			if (input_record == INPREC_RECORD_START)
 				input_record = INPREC_RECORD_NORMAL;
-			statusline_clear();
+			if (!runahead_restore)
+				statusline_clear();
 		} else {
 			if (input_record == INPREC_RECORD_START) {
 				input_record = INPREC_RECORD_NORMAL;
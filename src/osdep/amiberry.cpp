@@ -341,9 +341,152 @@ void target_spin(int total)
 
 extern int vsync_activeheight;
 
+/* Frame pacer.
+ *
+ * Sleeps on an absolute CLOCK_MONOTONIC deadline so that wakeup latency
+ * does not accumulate, but wakes up a little early and busy-waits the
+ * last stretch. The spin window is calibrated at startup from the
+ * measured oversleep of the host scheduler and then adapts to the
+ * wakeups seen while pacing frames.
+ */
+
+#define PACER_MIN_SPIN 50
+#define PACER_MAX_SPIN 2000
+#define PACER_HIST_BUCKETS 18
+
+static frame_time_t pacer_spin = -1;
+static frame_time_t pacer_lastwake;
+static frame_time_t pacer_lastinterval;
+static uae_u32 pacer_late_hist[PACER_HIST_BUCKETS];
+static uae_u32 pacer_jitter_hist[PACER_HIST_BUCKETS];
+static uae_u32 pacer_frames, pacer_missed;
+static frame_time_t pacer_late_max, pacer_jitter_max;
+
+static void pacer_sleep_abs(frame_time_t t)
+{
+#ifdef __APPLE__
+	frame_time_t d = t - read_processor_time();
+	if (d <= 0)
+		return;
+	struct timespec ts;
+	ts.tv_sec = d / 1000000;
+	ts.tv_nsec = (d % 1000000) * 1000;
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+#else
+	frame_time_t abst = t + g_uae_epoch;
+	struct timespec ts;
+	ts.tv_sec = abst / 1000000;
+	ts.tv_nsec = (abst % 1000000) * 1000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#endif
+}
+
+static int pacer_bucket(frame_time_t v)
+{
+	int b = 0;
+	while (v > 0 && b < PACER_HIST_BUCKETS - 1) {
+		v >>= 1;
+		b++;
+	}
+	return b;
+}
+
 void target_calibrate_spin(void)
 {
+	frame_time_t worst = 0;
 	spincount = 0;
+	for (int i = 0; i < 16; i++) {
+		frame_time_t t = read_processor_time() + 500;
+		pacer_sleep_abs(t);
+		frame_time_t over = read_processor_time() - t;
+		if (over > worst)
+			worst = over;
+	}
+	pacer_spin = std::clamp<frame_time_t>(worst + worst / 2, PACER_MIN_SPIN, PACER_MAX_SPIN);
+	write_log(_T("Frame pacer: worst sleep overshoot %lldus, spin window %lldus\n"), (long long)worst, (long long)pacer_spin);
+}
+
+/* Wait until read_processor_time() reaches deadline. poll, if set, is called
+ * at least once per millisecond while sleeping. */
+void target_pace_until(frame_time_t deadline, void (*poll)(void))
+{
+	if (pacer_spin < 0)
+		target_calibrate_spin();
+	const auto start = read_processor_time();
+	for (;;) {
+		frame_time_t now = read_processor_time();
+		frame_time_t wake = deadline - pacer_spin;
+		if (now >= wake)
+			break;
+		if (poll) {
+			poll();
+			if (wake - now > 1000)
+				wake = now + 1000;
+		}
+		pacer_sleep_abs(wake);
+		if (wake == deadline - pacer_spin) {
+			// Woke up past the deadline: the spin window is too small.
+			frame_time_t over = read_processor_time() - deadline;
+			if (over > 0)
+				pacer_spin = std::min<frame_time_t>(pacer_spin + over, PACER_MAX_SPIN);
+		}
+	}
+	frame_time_t now;
+	while ((now = read_processor_time()) < deadline) {
+		if (poll)
+			poll();
+	}
+	idletime += now - start;
+
+	frame_time_t late = now - deadline;
+	if (late > pacer_late_max)
+		pacer_late_max = late;
+	if (late > 50)
+		pacer_missed++;
+	else if (pacer_spin > PACER_MIN_SPIN && (pacer_frames & 63) == 63)
+		pacer_spin--;
+	pacer_late_hist[pacer_bucket(late)]++;
+	if (pacer_lastwake) {
+		frame_time_t interval = now - pacer_lastwake;
+		if (pacer_lastinterval) {
+			frame_time_t jitter = interval > pacer_lastinterval ? interval - pacer_lastinterval : pacer_lastinterval - interval;
+			if (jitter > pacer_jitter_max)
+				pacer_jitter_max = jitter;
+			pacer_jitter_hist[pacer_bucket(jitter)]++;
+		}
+		pacer_lastinterval = interval;
+	}
+	pacer_lastwake = now;
+	pacer_frames++;
+}
+
+static void pacer_dump_hist(const TCHAR *name, const uae_u32 *hist, frame_time_t maxv)
+{
+	write_log(_T("Frame pacer %s (max %lldus):\n"), name, (long long)maxv);
+	for (int i = 0; i < PACER_HIST_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		int lo = i ? 1 << (i - 1) : 0;
+		if (i == PACER_HIST_BUCKETS - 1)
+			write_log(_T("  >=%7dus %u\n"), lo, hist[i]);
+		else
+			write_log(_T("  <%8dus %u\n"), 1 << i, hist[i]);
+	}
+}
+
+static void pacer_dump_stats(void)
+{
+	if (!pacer_frames)
+		return;
+	write_log(_T("Frame pacer: %u frames, %u late by more than 50us, spin window %lldus\n"),
+		pacer_frames, pacer_missed, (long long)pacer_spin);
+	pacer_dump_hist(_T("lateness"), pacer_late_hist, pacer_late_max);
+	pacer_dump_hist(_T("jitter"), pacer_jitter_hist, pacer_jitter_max);
+	memset(pacer_late_hist, 0, sizeof pacer_late_hist);
+	memset(pacer_jitter_hist, 0, sizeof pacer_jitter_hist);
+	pacer_frames = pacer_missed = 0;
+	pacer_late_max = pacer_jitter_max = 0;
+	pacer_lastwake = pacer_lastinterval = 0;
 }
 
 void sleep_micros (int ms)
@@ -353,13 +496,13 @@ void sleep_micros (int ms)
 
 void sleep_millis(int ms)
 {
-	SDL_Delay(ms);
+	pacer_sleep_abs(read_processor_time() + ms * 1000);
 }
 
 int sleep_millis_main(int ms)
 {
 	const auto start = read_processor_time();
-	SDL_Delay(ms);
+	pacer_sleep_abs(start + ms * 1000);
 	idletime += read_processor_time() - start;
 	return 0;
 }
@@ -2004,6 +2147,7 @@ void target_run(void)
 
 void target_quit(void)
 {
+	pacer_dump_stats();
 }
 
 void target_fixup_options(struct uae_prefs* p)
@@ -2302,6 +2446,14 @@ void target_default_options(struct uae_prefs* p, int type)
 	p->alt_tab_release = false;
 	p->sound_pullmode = amiberry_options.default_sound_pull;
 
+	p->pcprofile_interval = 0;
+	p->pcprofile_file[0] = 0;
+
+	p->archive_prefetch_threads = 0;
+	p->archive_prefetch_cache = 64;
+	p->runahead = 0;
+	p->runahead_verify = 0;
+
 	p->use_retroarch_quit = amiberry_options.default_retroarch_quit;
 	p->use_retroarch_menu = amiberry_options.default_retroarch_menu;
 	p->use_retroarch_reset = amiberry_options.default_retroarch_reset;
@@ -2624,6 +2776,12 @@ void target_save_options(struct zfile* f, struct uae_prefs* p)
 	cfgfile_target_dwrite_bool(f, _T("drawbridge_connected_drive_b"), p->drawbridge_connected_drive_b);
 
 	cfgfile_target_dwrite_bool(f, _T("alt_tab_release"), p->alt_tab_release);
+	cfgfile_target_dwrite(f, _T("pcprofile_interval"), _T("%d"), p->pcprofile_interval);
+	cfgfile_target_dwrite_str(f, _T("pcprofile_file"), p->pcprofile_file);
+	cfgfile_target_dwrite(f, _T("archive_prefetch_threads"), _T("%d"), p->archive_prefetch_threads);
+	cfgfile_target_dwrite(f, _T("archive_prefetch_cache"), _T("%d"), p->archive_prefetch_cache);
+	cfgfile_target_dwrite(f, _T("runahead_experimental"), _T("%d"), p->runahead);
+	cfgfile_target_dwrite(f, _T("runahead_verify"), _T("%d"), p->runahead_verify);
 	cfgfile_target_dwrite(f, _T("sound_pullmode"), _T("%d"), p->sound_pullmode);
 
 	cfgfile_target_dwrite_bool(f, _T("use_retroarch_quit"), p->use_retroarch_quit);
@@ -2731,6 +2889,12 @@ static int target_parse_option_host(struct uae_prefs *p, const TCHAR *option, co
 		|| cfgfile_yesno(option, value, _T("drawbridge_autocache"), &p->drawbridge_autocache)
 		|| cfgfile_yesno(option, value, _T("drawbridge_connected_drive_b"), &p->drawbridge_connected_drive_b)
 		|| cfgfile_yesno(option, value, _T("alt_tab_release"), &p->alt_tab_release)
+		|| cfgfile_intval(option, value, _T("pcprofile_interval"), &p->pcprofile_interval, 1)
+		|| cfgfile_string(option, value, _T("pcprofile_file"), p->pcprofile_file, sizeof p->pcprofile_file / sizeof(TCHAR))
+		|| cfgfile_intval(option, value, _T("archive_prefetch_threads"), &p->archive_prefetch_threads, 1)
+		|| cfgfile_intval(option, value, _T("archive_prefetch_cache"), &p->archive_prefetch_cache, 1)
+		|| cfgfile_intval(option, value, _T("runahead_experimental"), &p->runahead, 1)
+		|| cfgfile_intval(option, value, _T("runahead_verify"), &p->runahead_verify, 1)
 		|| cfgfile_yesno(option, value, _T("use_retroarch_quit"), &p->use_retroarch_quit)
 		|| cfgfile_yesno(option, value, _T("use_retroarch_menu"), &p->use_retroarch_menu)
 		|| cfgfile_yesno(option, value, _T("use_retroarch_reset"), &p->use_retroarch_reset)
@@ -4158,6 +4322,7 @@ bool data_dir_exists(const char* directory)
 	return my_existsdir(check_for.c_str());
 }
 
+#ifndef AMIBERRY_BENCH
 int main(int argc, char* argv[])
 {
 	for (auto i = 1; i < argc; i++) {
@@ -4167,6 +4332,7 @@ int main(int argc, char* argv[])
 
 	struct sigaction action{};
 	mainthreadid = uae_thread_get_id(nullptr);
+	zfile_init();
 
 	if(argc == 2)
 	{
@@ -4379,6 +4545,7 @@ int main(int argc, char* argv[])
 		target_shutdown();
 	return 0;
 }
+#endif
 
 void toggle_mousegrab()
 {
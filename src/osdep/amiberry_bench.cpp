@@ -0,0 +1,195 @@
+/*
+ * Amiberry kernel micro-benchmarks
+ *
+ * Drives the hot emulation kernels with synthetic input, outside of a
+ * running emulation, and reports ns per call and throughput. Built as the
+ * amiberry-bench executable when WITH_BENCHMARKS is enabled.
+ *
+ * Usage: amiberry-bench [-t seconds] [name filter ...]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "options.h"
+#include "memory.h"
+#include "blitter.h"
+#include "bench.h"
+
+#define BENCH_CHIPMEM 0x80000
+#define BENCH_BLIT_WORDS 20
+#define BENCH_BLIT_LINES 256
+
+typedef uae_u64 (*bench_func)(int arg, int iterations);
+
+struct bench_kernel {
+	const char *name;
+	bench_func func;
+	int arg;
+};
+
+static uae_u64 bench_blitter(int minterm, int iterations)
+{
+	static bool init;
+	struct bltinfo b = { 0 };
+
+	if (!init) {
+		init = true;
+		uae_u32 seed = 0x600dcafe;
+		for (uaecptr addr = 0; addr < BENCH_CHIPMEM; addr += 2) {
+			seed = seed * 1103515245 + 12345;
+			chipmem_agnus_wput(addr, seed >> 16);
+		}
+		for (int i = 0; i < BLITTER_MAX_WORDS; i++)
+			blit_masktable[i] = 0xffff;
+	}
+	bltcon0 = 0x4f00 | minterm;
+	bltcon1 = 0x3000;
+	for (int i = 0; i < iterations; i++) {
+		b.hblitsize = BENCH_BLIT_WORDS;
+		b.vblitsize = BENCH_BLIT_LINES;
+		b.bltamod = b.bltbmod = b.bltcmod = b.bltdmod = 0;
+		blitfunc_dofast[minterm](0x10000, 0x20000, 0x30000, 0x40000, &b);
+	}
+	return (uae_u64)iterations * BENCH_BLIT_WORDS * BENCH_BLIT_LINES * 2;
+}
+
+static uae_u64 bench_doline(int planes, int iterations)
+{
+	return bench_drawing_doline(planes, iterations);
+}
+
+static uae_u64 bench_linetoscr(int arg, int iterations)
+{
+	return bench_drawing_linetoscr(iterations);
+}
+
+static uae_u64 bench_sinc(int arg, int iterations)
+{
+	return bench_audio_sinc(iterations);
+}
+
+static uae_u64 bench_amigados(int arg, int iterations)
+{
+	return bench_disk_amigados(iterations);
+}
+
+static uae_u64 bench_pcdos(int arg, int iterations)
+{
+	return bench_disk_pcdos(iterations);
+}
+
+static uae_u64 bench_c2p(int generic, int iterations)
+{
+	return bench_akiko_c2p(generic != 0, iterations);
+}
+
+static uae_u64 bench_ev2(int arg, int iterations)
+{
+	return bench_events_ev2(iterations);
+}
+
+static uae_u64 bench_serial(int arg, int iterations)
+{
+	return bench_serial_tcp(iterations);
+}
+
+#ifdef PICASSO96
+static uae_u64 bench_copyrow(int srcpixbytes, int iterations)
+{
+	return bench_p96_copyrow(srcpixbytes, iterations);
+}
+
+static uae_u64 bench_planar2direct(int depth, int iterations)
+{
+	return bench_p96_planartodirect(depth, iterations);
+}
+#endif
+
+static const struct bench_kernel kernels[] = {
+	{ "doline_1", bench_doline, 1 },
+	{ "doline_4", bench_doline, 4 },
+	{ "doline_6", bench_doline, 6 },
+#ifdef AGA
+	{ "doline_8", bench_doline, 8 },
+#endif
+	{ "linetoscr_32", bench_linetoscr, 0 },
+	{ "blitdofast_f0", bench_blitter, 0xf0 },
+	{ "blitdofast_ca", bench_blitter, 0xca },
+	{ "sinc_a500", bench_sinc, 0 },
+#ifdef PICASSO96
+	{ "copyrow_clut", bench_copyrow, 1 },
+	{ "copyrow_16", bench_copyrow, 2 },
+	{ "copyrow_24", bench_copyrow, 3 },
+	{ "copyrow_32", bench_copyrow, 4 },
+	{ "planar2direct_4", bench_planar2direct, 4 },
+	{ "planar2direct_8", bench_planar2direct, 8 },
+#endif
+	{ "decode_amigados", bench_amigados, 0 },
+	{ "decode_pcdos", bench_pcdos, 0 },
+	{ "akiko_c2p_generic", bench_c2p, 1 },
+	{ "akiko_c2p", bench_c2p, 0 },
+	{ "ev2_dispatch", bench_ev2, 0 },
+	{ "serial_tcp", bench_serial, 0 },
+	{ NULL, NULL, 0 }
+};
+
+static double bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool bench_selected(const char *name, int argc, char **argv, int first)
+{
+	if (first >= argc)
+		return true;
+	for (int i = first; i < argc; i++) {
+		if (strstr(name, argv[i]))
+			return true;
+	}
+	return false;
+}
+
+int main(int argc, char *argv[])
+{
+	double mintime = 0.25;
+	int first = 1;
+
+	if (argc > 2 && !strcmp(argv[1], "-t")) {
+		mintime = atof(argv[2]);
+		if (mintime <= 0)
+			mintime = 0.25;
+		first = 3;
+	}
+
+	bench_memory_init(BENCH_CHIPMEM);
+
+	printf("%-20s %12s %12s %12s\n", "kernel", "calls", "ns/call", "MB/s");
+	for (const struct bench_kernel *k = kernels; k->name; k++) {
+		if (!bench_selected(k->name, argc, argv, first))
+			continue;
+		/* warm up caches and any lazily built tables */
+		k->func(k->arg, 1);
+		int iterations = 1;
+		double elapsed;
+		uae_u64 bytes;
+		for (;;) {
+			double start = bench_now();
+			bytes = k->func(k->arg, iterations);
+			elapsed = bench_now() - start;
+			if (elapsed >= mintime || iterations >= (1 << 30))
+				break;
+			iterations *= elapsed > mintime / 16 ? 2 : 8;
+		}
+		printf("%-20s %12d %12.1f %12.1f\n", k->name, iterations,
+			elapsed * 1e9 / iterations, bytes / elapsed / (1024.0 * 1024.0));
+	}
+	return 0;
+}
@@ -11,10 +11,29 @@
 
 DBusConnection *dbusconn;
 
+// Reply to a SCREENSHOT call once its file has been written
+static void DBusScreenshotDone(void *data, bool ok)
+{
+	auto *msg = static_cast<DBusMessage*>(data);
+	DBusMessage *reply;
+	if(dbusconn && (reply = dbus_message_new_method_return(msg)))
+	{
+		dbus_bool_t status = ok;
+		dbus_message_append_args(reply, DBUS_TYPE_BOOLEAN, &status, DBUS_TYPE_INVALID);
+		dbus_connection_send(dbusconn, reply, nullptr);
+		dbus_connection_flush(dbusconn);
+		dbus_message_unref(reply);
+	}
+	dbus_message_unref(msg);
+}
+
 void DBusHandle()
 {
 	if(dbusconn)
 	{
+		// deliver finished screenshots, also while paused
+		screenshot_poll();
+
 		DBusError err;
 		DBusMessage *msg = nullptr;
 		DBusMessage *reply = nullptr;
@@ -105,10 +124,19 @@ void DBusHandle()
 				}
 				if(!error)
 				{
-					if(filename)
+					// Reply from DBusScreenshotDone once the file is on disk
+					if(filename && create_screenshot())
 					{
-						create_screenshot();
-						save_thumb(filename);
+						dbus_message_ref(msg);
+						if(save_thumb(filename, false, DBusScreenshotDone, msg))
+						{
+							respond = false;
+						}
+						else
+						{
+							dbus_message_unref(msg);
+							status = false;
+						}
 					}
 					else
 					{
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "sysdeps.h"
 #include "options.h"
@@ -85,7 +86,39 @@ Uint32 pixel_format;
 
 static frame_time_t last_synctime;
 
-static SDL_Surface* current_screenshot = nullptr;
+struct screenshot_job
+{
+	unsigned char* pixels;
+	int width;
+	int height;
+	int pitch;
+	int depth;
+	std::string path;
+	bool notify;
+	screenshot_done_func done;
+	void* done_data;
+};
+
+struct screenshot_done_call
+{
+	screenshot_done_func done;
+	void* done_data;
+	bool ok;
+};
+
+#define SCREENSHOT_QUEUE 4
+
+static screenshot_job* current_screenshot = nullptr;
+static screenshot_job* screenshot_queue[SCREENSHOT_QUEUE];
+static int screenshot_queue_first, screenshot_queue_count, screenshot_busy;
+static std::string screenshot_done_path;
+static int screenshot_done_ok, screenshot_done_failed, screenshot_flush_failed;
+static std::vector<screenshot_done_call> screenshot_done_calls;
+static uae_sem_t screenshot_sem, screenshot_wake, screenshot_slots;
+static uae_thread_id screenshot_tid;
+static bool screenshot_thread_running;
+static volatile bool screenshot_quit;
+static void stop_screenshot_thread();
 std::string screenshot_filename;
 FILE* screenshot_file = nullptr;
 int delay_savestate_frame = 0;
@@ -920,6 +953,8 @@ void show_screen(int monid, int mode)
 
 	const auto start = read_processor_time();
 
+	screenshot_poll();
+
 	// RTG status line is handled in P96 code, this is for native modes only
 	if ((currprefs.leds_on_screen & STATUSLINE_CHIPSET) && !rtg)
 	{
@@ -2296,6 +2331,7 @@ int graphics_setup()
 void graphics_leave()
 {
 	struct AmigaMonitor* mon = &AMonitors[0];
+	stop_screenshot_thread();
 	close_windows(mon);
 
 	SDL_DestroyMutex(screen_cs);
@@ -2839,18 +2875,17 @@ void update_display(struct uae_prefs* p)
 	open_screen(p);
 }
 
-static int save_png(const SDL_Surface* surface, const std::string& path)
+static int save_png(const screenshot_job* job)
 {
-	const auto w = surface->w;
-	const auto h = surface->h;
-	auto* const pix = static_cast<unsigned char*>(surface->pixels);
-	unsigned char writeBuffer[1920 * 3];
+	const auto w = job->width;
+	const auto h = job->height;
+	auto* const pix = job->pixels;
 
 	// Open the file for writing
-	auto* const f = fopen(path.c_str(), "wbe");
+	auto* const f = fopen(job->path.c_str(), "wbe");
 	if (!f)
 	{
-		write_log(_T("Failed to open file for writing: %s\n"), path.c_str());
+		write_log(_T("Failed to open file for writing: %s\n"), job->path.c_str());
 		return 0;
 	}
 
@@ -2871,6 +2906,16 @@ static int save_png(const SDL_Surface* surface, const std::string& path)
 		return 0;
 	}
 
+	auto* const writeBuffer = xmalloc(unsigned char, w * 3);
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		write_log(_T("Failed to write PNG file: %s\n"), job->path.c_str());
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		xfree(writeBuffer);
+		fclose(f);
+		return 0;
+	}
+
 	png_init_io(png_ptr, f);
 	png_set_IHDR(png_ptr,
 		info_ptr,
@@ -2886,9 +2931,8 @@ static int save_png(const SDL_Surface* surface, const std::string& path)
 	auto* b = writeBuffer;
 	const auto sizeX = w;
 	const auto sizeY = h;
-	const auto depth = get_display_depth();
 
-	if (depth <= 16)
+	if (job->depth <= 16)
 	{
 		auto* p = reinterpret_cast<unsigned short*>(pix);
 		for (auto y = 0; y < sizeY; y++)
@@ -2900,7 +2944,7 @@ static int save_png(const SDL_Surface* surface, const std::string& path)
 				*b++ = ((v & SYSTEM_GREEN_MASK) >> SYSTEM_GREEN_SHIFT) << 2; // G
 				*b++ = ((v & SYSTEM_BLUE_MASK) >> SYSTEM_BLUE_SHIFT) << 3; // B
 			}
-			p += surface->pitch / 2;
+			p += job->pitch / 2;
 			png_write_row(png_ptr, writeBuffer);
 			b = writeBuffer;
 		}
@@ -2915,7 +2959,7 @@ static int save_png(const SDL_Surface* surface, const std::string& path)
 				*b++ = ((v & SYSTEM_GREEN_MASK) >> SYSTEM_GREEN_SHIFT); // G 
 				*b++ = ((v & SYSTEM_BLUE_MASK) >> SYSTEM_BLUE_SHIFT); // B
 			}
-			p += surface->pitch / 4;
+			p += job->pitch / 4;
 			png_write_row(png_ptr, writeBuffer);
 			b = writeBuffer;
 		}
@@ -2924,42 +2968,197 @@ static int save_png(const SDL_Surface* surface, const std::string& path)
 	png_write_end(png_ptr, info_ptr);
 	png_destroy_write_struct(&png_ptr, &info_ptr);
 
+	xfree(writeBuffer);
 	fclose(f);
 	return 1;
 }
 
+static void free_screenshot(screenshot_job* job)
+{
+	xfree(job->pixels);
+	delete job;
+}
+
+// Encodes queued screenshots to PNG files, so that the emulation thread
+// only has to take a copy of the frame buffer.
+static int screenshot_thread(void* v)
+{
+	for (;;)
+	{
+		uae_sem_wait(&screenshot_wake);
+		if (screenshot_quit)
+			break;
+		uae_sem_wait(&screenshot_sem);
+		auto* job = screenshot_queue[screenshot_queue_first];
+		screenshot_queue_first = (screenshot_queue_first + 1) % SCREENSHOT_QUEUE;
+		screenshot_queue_count--;
+		uae_sem_post(&screenshot_sem);
+		uae_sem_post(&screenshot_slots);
+
+		const auto ok = save_png(job);
+
+		uae_sem_wait(&screenshot_sem);
+		if (!ok)
+			screenshot_flush_failed++;
+		if (job->notify)
+		{
+			if (ok)
+			{
+				screenshot_done_ok++;
+				screenshot_done_path = job->path;
+			}
+			else
+			{
+				screenshot_done_failed++;
+			}
+		}
+		if (job->done)
+			screenshot_done_calls.push_back({ job->done, job->done_data, ok != 0 });
+		screenshot_busy--;
+		uae_sem_post(&screenshot_sem);
+		free_screenshot(job);
+	}
+	return 0;
+}
+
+static bool start_screenshot_thread()
+{
+	if (screenshot_thread_running)
+		return true;
+	if (!screenshot_sem)
+	{
+		uae_sem_init(&screenshot_sem, 0, 1);
+		uae_sem_init(&screenshot_wake, 0, 0);
+		uae_sem_init(&screenshot_slots, 0, SCREENSHOT_QUEUE);
+	}
+	screenshot_quit = false;
+	if (!uae_start_thread(_T("screenshot"), screenshot_thread, nullptr, &screenshot_tid))
+	{
+		write_log(_T("Failed to start screenshot thread\n"));
+		return false;
+	}
+	screenshot_thread_running = true;
+	return true;
+}
+
+// Report finished screenshots on the statusline and run their completion
+// callbacks. Called from the emulation thread, as the statusline is not
+// thread safe.
+void screenshot_poll()
+{
+	if (!screenshot_sem)
+		return;
+	uae_sem_wait(&screenshot_sem);
+	const auto ok = screenshot_done_ok;
+	const auto failed = screenshot_done_failed;
+	const auto path = screenshot_done_path;
+	std::vector<screenshot_done_call> calls;
+	calls.swap(screenshot_done_calls);
+	screenshot_done_ok = screenshot_done_failed = 0;
+	uae_sem_post(&screenshot_sem);
+	for (const auto& c : calls)
+		c.done(c.done_data, c.ok);
+	if (failed)
+		statusline_add_message(STATUSTYPE_OTHER, _T("Screenshot failed"));
+	else if (ok)
+		statusline_add_message(STATUSTYPE_OTHER, _T("Screenshot saved: %s"), extract_filename(path).c_str());
+}
+
+// Wait until all queued screenshots have been written to disk. Returns
+// false if any of them failed since the previous flush.
+bool screenshot_flush()
+{
+	if (!screenshot_thread_running)
+		return true;
+	for (;;)
+	{
+		uae_sem_wait(&screenshot_sem);
+		const auto busy = screenshot_busy;
+		const auto failed = screenshot_flush_failed;
+		if (!busy)
+			screenshot_flush_failed = 0;
+		uae_sem_post(&screenshot_sem);
+		if (!busy)
+			return failed == 0;
+		sleep_millis(1);
+	}
+}
+
+static void stop_screenshot_thread()
+{
+	if (!screenshot_thread_running)
+		return;
+	screenshot_flush();
+	screenshot_quit = true;
+	uae_sem_post(&screenshot_wake);
+	uae_wait_thread(&screenshot_tid);
+	screenshot_thread_running = false;
+	screenshot_poll();
+}
+
 bool create_screenshot()
 {
 	if (current_screenshot != nullptr)
 	{
-		SDL_FreeSurface(current_screenshot);
+		free_screenshot(current_screenshot);
 		current_screenshot = nullptr;
 	}
 
 	if (amiga_surface != nullptr) {
-		current_screenshot = SDL_CreateRGBSurfaceFrom(amiga_surface->pixels,
-			AMIGA_WIDTH_MAX << currprefs.gfx_resolution,
-			AMIGA_HEIGHT_MAX << currprefs.gfx_vresolution,
-			amiga_surface->format->BitsPerPixel,
-			amiga_surface->pitch,
-			amiga_surface->format->Rmask,
-			amiga_surface->format->Gmask,
-			amiga_surface->format->Bmask,
-			amiga_surface->format->Amask);
+		const auto depth = get_display_depth();
+		const auto width = std::min(AMIGA_WIDTH_MAX << currprefs.gfx_resolution, amiga_surface->w);
+		const auto height = std::min(AMIGA_HEIGHT_MAX << currprefs.gfx_vresolution, amiga_surface->h);
+		const auto pitch = width * (depth / 8);
+		auto* pixels = xmalloc(unsigned char, pitch * height);
+		if (pixels == nullptr)
+			return false;
+		const auto* src = static_cast<const unsigned char*>(amiga_surface->pixels);
+		for (auto y = 0; y < height; y++)
+			memcpy(pixels + y * pitch, src + y * amiga_surface->pitch, pitch);
+
+		current_screenshot = new screenshot_job;
+		current_screenshot->pixels = pixels;
+		current_screenshot->width = width;
+		current_screenshot->height = height;
+		current_screenshot->pitch = pitch;
+		current_screenshot->depth = depth;
 	}
 	return current_screenshot != nullptr;
 }
 
-int save_thumb(const std::string& path)
+// Queue the frame taken by create_screenshot() for encoding. Only blocks
+// when the queue is full, call screenshot_flush() to wait for the file.
+// With notify set, the result is reported on the statusline. If done is
+// given, it is called from screenshot_poll() with the result once the file
+// is written; it is not called when save_thumb() returns 0.
+int save_thumb(const std::string& path, bool notify, screenshot_done_func done, void* done_data)
 {
-	auto ret = 0;
-	if (current_screenshot != nullptr)
+	auto* job = current_screenshot;
+	if (job == nullptr)
+		return 0;
+	current_screenshot = nullptr;
+	job->path = path;
+	job->notify = notify;
+	job->done = done;
+	job->done_data = done_data;
+
+	if (!start_screenshot_thread())
 	{
-		ret = save_png(current_screenshot, path);
-		SDL_FreeSurface(current_screenshot);
-		current_screenshot = nullptr;
+		const auto ret = save_png(job);
+		free_screenshot(job);
+		if (ret && done)
+			done(done_data, true);
+		return ret;
 	}
-	return ret;
+
+	uae_sem_wait(&screenshot_slots);
+	uae_sem_wait(&screenshot_sem);
+	screenshot_queue[(screenshot_queue_first + screenshot_queue_count) % SCREENSHOT_QUEUE] = job;
+	screenshot_queue_count++;
+	screenshot_busy++;
+	uae_sem_post(&screenshot_sem);
+	uae_sem_post(&screenshot_wake);
+	return 1;
 }
 
 void screenshot(int monid, int mode, int doprepare)
@@ -2984,5 +3183,5 @@ void screenshot(int monid, int mode, int doprepare)
 	screenshot_filename = remove_file_extension(screenshot_filename);
 	screenshot_filename += ".png";
 
-	save_thumb(screenshot_filename);
+	save_thumb(screenshot_filename, true);
 }
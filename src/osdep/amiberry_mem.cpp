@@ -530,7 +530,10 @@ void mapped_free(addrbank* ab)
 		free(ab->baseaddr);
 	}
 	ab->baseaddr = nullptr;
+	ab->baseaddr_direct_r = nullptr;
+	ab->baseaddr_direct_w = nullptr;
 	ab->allocated_size = 0;
+	clear_mem_direct(ab);
 }
 
 void protect_roms(bool protect)
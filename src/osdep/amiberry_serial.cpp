@@ -31,6 +31,7 @@
 #include "parallel.h"
 #endif
 #include "parser.h"
+#include "threaddep/thread.h"
 
 #ifdef WITH_MIDI
 #include "midi.h"
@@ -118,14 +119,73 @@ unsigned int timeout = 1000;
 #include "uae/socket.h"
 
 static SOCKET serialsocket = UAE_SOCKET_INVALID;
-static SOCKET serialconn = UAE_SOCKET_INVALID;
+static volatile SOCKET serialconn = UAE_SOCKET_INVALID;
 static BOOL tcpserial;
 
+/* Receive side runs on its own thread: it blocks on the host port or
+ * TCP connection and fills a single producer/single consumer ring, so
+ * the hsync handler only has to look at memory. */
+#define SERIAL_RX_RING 4096
+static uae_u8 serial_rx_ring[SERIAL_RX_RING];
+static volatile uae_u32 serial_rx_head; /* written by reader thread */
+static volatile uae_u32 serial_rx_tail; /* written by emulation */
+static uae_thread_id serial_reader_tid;
+static volatile bool serial_reader_active;
+static volatile int serial_reader_quit;
+static volatile int serial_tcp_hangup;
+/* While the reader thread runs it is the only one that accepts and
+ * closes serialconn; it holds this lock when doing so, and writeser
+ * holds it while sending. */
+static uae_sem_t serial_conn_sem;
+
+static int serial_rx_avail(void)
+{
+	return __atomic_load_n(&serial_rx_head, __ATOMIC_ACQUIRE) - serial_rx_tail;
+}
+
+static int serial_rx_get(void)
+{
+	uae_u32 tail = serial_rx_tail;
+	uae_u8 v = serial_rx_ring[tail & (SERIAL_RX_RING - 1)];
+	__atomic_store_n(&serial_rx_tail, tail + 1, __ATOMIC_RELEASE);
+	return v;
+}
+
+static int serial_rx_read(int *buffer)
+{
+	if (!serial_rx_avail())
+		return 0;
+	*buffer = serial_rx_get();
+	return 1;
+}
+
+static void serial_rx_flush(void)
+{
+	__atomic_store_n(&serial_rx_tail, __atomic_load_n(&serial_rx_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+static int serial_rx_space(void)
+{
+	return SERIAL_RX_RING - (serial_rx_head - __atomic_load_n(&serial_rx_tail, __ATOMIC_ACQUIRE));
+}
+
+static void serial_rx_put(const uae_u8 *buf, int len)
+{
+	uae_u32 head = serial_rx_head;
+	for (int i = 0; i < len; i++)
+		serial_rx_ring[(head + i) & (SERIAL_RX_RING - 1)] = buf[i];
+	__atomic_store_n(&serial_rx_head, head + len, __ATOMIC_RELEASE);
+}
+
 static bool tcp_is_connected (void)
 {
 	if (serialsocket == UAE_SOCKET_INVALID) {
 		return false;
 	}
+	if (serial_reader_active) {
+		// reader thread owns accept and disconnect
+		return serialconn != UAE_SOCKET_INVALID && !serial_tcp_hangup;
+	}
 	if (serialconn == UAE_SOCKET_INVALID) {
 		if (uae_socket_select_read(serialsocket)) {
 			serialconn = uae_socket_accept(serialsocket);
@@ -142,11 +202,103 @@ static void tcp_disconnect (void)
 	if (serialconn == UAE_SOCKET_INVALID) {
 		return;
 	}
+	if (serial_reader_active) {
+		serial_tcp_hangup = 1;
+		return;
+	}
 	uae_socket_close(serialconn);
 	serialconn = UAE_SOCKET_INVALID;
 	write_log(_T("TCP: Serial disconnect\n"));
 }
 
+static int serial_reader_thread(void *arg)
+{
+	uae_u8 buf[256];
+
+	while (!serial_reader_quit) {
+		int space = serial_rx_space();
+		if (space <= 0) {
+			// ring full: leave the data in the host buffers until emulation catches up
+			sleep_millis(1);
+			continue;
+		}
+		if (space > sizeof buf)
+			space = sizeof buf;
+		if (tcpserial) {
+			if (serial_tcp_hangup) {
+				serial_tcp_hangup = 0;
+				if (serialconn != UAE_SOCKET_INVALID) {
+					uae_sem_wait(&serial_conn_sem);
+					uae_socket_close(serialconn);
+					serialconn = UAE_SOCKET_INVALID;
+					uae_sem_post(&serial_conn_sem);
+					write_log(_T("TCP: Serial disconnect\n"));
+				}
+			}
+			if (serialconn == UAE_SOCKET_INVALID) {
+				if (uae_socket_select(serialsocket, true, false, false, 100000) > 0) {
+					SOCKET conn = uae_socket_accept(serialsocket);
+					if (conn != UAE_SOCKET_INVALID) {
+						uae_sem_wait(&serial_conn_sem);
+						serialconn = conn;
+						uae_sem_post(&serial_conn_sem);
+						write_log(_T("TCP: Serial connection accepted\n"));
+					}
+				}
+				continue;
+			}
+			int err = uae_socket_select(serialconn, true, false, false, 100000);
+			if (err == UAE_SELECT_ERROR) {
+				serial_tcp_hangup = 1;
+			} else if (err & UAE_SELECT_READ) {
+				int len = uae_socket_read(serialconn, buf, space);
+				if (len > 0)
+					serial_rx_put(buf, len);
+				else
+					serial_tcp_hangup = 1;
+			}
+		} else {
+			int len = sp_blocking_read_next(port, buf, space, 100);
+			if (len > 0) {
+				serial_rx_put(buf, len);
+			} else if (len < 0) {
+				check((sp_return)len);
+				sleep_millis(100);
+			}
+		}
+	}
+	return 0;
+}
+
+static void serial_reader_start(void)
+{
+	if (serial_reader_active || (!tcpserial && !port))
+		return;
+	if (!serial_conn_sem)
+		uae_sem_init(&serial_conn_sem, 0, 1);
+	serial_rx_head = serial_rx_tail = 0;
+	serial_reader_quit = 0;
+	serial_tcp_hangup = 0;
+	serial_reader_active = true;
+	if (!uae_start_thread(_T("serial"), serial_reader_thread, NULL, &serial_reader_tid)) {
+		serial_reader_active = false;
+		write_log(_T("SERIAL: failed to start reader thread, polling host port\n"));
+	}
+}
+
+static void serial_reader_stop(void)
+{
+	if (!serial_reader_active)
+		return;
+	serial_reader_quit = 1;
+	uae_wait_thread(&serial_reader_tid);
+	serial_reader_active = false;
+	if (serial_tcp_hangup) {
+		serial_tcp_hangup = 0;
+		tcp_disconnect();
+	}
+}
+
 static void closetcp (void)
 {
 	if (serialconn != UAE_SOCKET_INVALID) {
@@ -204,6 +356,7 @@ int openser (const TCHAR *sername)
 
 void closeser ()
 {
+	serial_reader_stop();
 	if (tcpserial) {
 		closetcp();
 		tcpserial = FALSE;
@@ -227,6 +380,7 @@ void closeser ()
 	{
 		check(sp_close(port));
 		sp_free_port(port);
+		port = NULL;
 	}
 }
 
@@ -325,6 +479,8 @@ static TCHAR dochar(int v)
 int readser(int* buffer)
 {
 	if (tcpserial) {
+		if (serial_reader_active)
+			return serial_rx_read(buffer);
 		if (tcp_is_connected()) {
 			char buf[1];
 			buf[0] = 0;
@@ -348,6 +504,8 @@ int readser(int* buffer)
 	} else {
 		if (!currprefs.use_serial)
 			return 0;
+		if (serial_reader_active)
+			return serial_rx_read(buffer);
 		if (dataininput > dataininputcnt) {
 			*buffer = inputbuffer[dataininputcnt++];
 			return 1;
@@ -376,6 +534,8 @@ void flushser(void)
 {
 	if (serdev) {
 		check(sp_flush(port, SP_BUF_BOTH));
+		if (serial_reader_active && !tcpserial)
+			serial_rx_flush();
 	}
 }
 
@@ -384,6 +544,8 @@ int readseravail(bool* breakcond)
 	if (breakcond)
 		*breakcond = false;
 	if (tcpserial) {
+		if (serial_reader_active)
+			return serial_rx_avail() > 0;
 		if (tcp_is_connected()) {
 			int err = uae_socket_select_read(serialconn);
 			if (err == UAE_SELECT_ERROR) {
@@ -409,6 +571,8 @@ int readseravail(bool* breakcond)
 				*breakcond = true;
 				breakpending = false;
 			}
+			if (serial_reader_active)
+				return serial_rx_avail();
 			const int bytes = check(sp_input_waiting(port));
 			if (bytes > 0)
 				return bytes;
@@ -453,7 +617,7 @@ static void checkreceive_serial (void)
 	static int ninebitdata;
 	int recdata;
 
-	if (!canreceive())
+	if (!canreceive() || runahead_muted)
 		return;
 
 	if (ninebit) {
@@ -585,7 +749,13 @@ void writeser_flush(void)
 
 void writeser(int c)
 {
+	// frames run ahead are replayed, the real frame sends the data
+	if (runahead_muted)
+		return;
 	if (tcpserial) {
+		const bool locked = serial_reader_active;
+		if (locked)
+			uae_sem_wait(&serial_conn_sem);
 		if (tcp_is_connected()) {
 			char buf[1];
 			buf[0] = (char) c;
@@ -593,6 +763,8 @@ void writeser(int c)
 				tcp_disconnect();
 			}
 		}
+		if (locked)
+			uae_sem_post(&serial_conn_sem);
 #ifdef WITH_MIDIEMU
 	} else if (midi_emu) {
 		uae_u8 b = (uae_u8)c;
@@ -1278,6 +1450,7 @@ void serial_open()
 		}
 	}
 	serdev = 1;
+	serial_reader_start();
 	ser_accurate = currprefs.cpu_memory_cycle_exact || (currprefs.cpu_model <= 68020 && currprefs.cpu_compatible && currprefs.m68k_speed == 0);
 #endif
 }
@@ -1371,3 +1544,79 @@ int check(const sp_return result)
 	}
 }
 
+
+#ifdef AMIBERRY_BENCH
+#include <sys/socket.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define BENCH_SERIAL_TIMEOUT_MS 2000
+
+/* Feed the reader thread and ring through a socketpair standing in for
+ * the TCP connection, and echo every byte back through writeser().
+ * Returns 0 if data is lost, corrupted or stalls for the timeout. */
+uae_u64 bench_serial_tcp(int iterations)
+{
+	uae_u8 buf[256], back[256];
+	uae_u32 seed = 0x5e71a1;
+	uae_u64 total = 0;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+		return 0;
+	struct timeval tv = { BENCH_SERIAL_TIMEOUT_MS / 1000, 0 };
+	setsockopt(sv[1], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+	tcpserial = TRUE;
+	serialsocket = serialconn = sv[0];
+	serial_reader_start();
+	for (int i = 0; i < iterations; i++) {
+		for (int j = 0; j < sizeof buf; j++) {
+			seed = seed * 1103515245 + 12345;
+			buf[j] = seed >> 24;
+		}
+		if (write(sv[1], buf, sizeof buf) != sizeof buf)
+			break;
+		int got = 0, idle = 0;
+		while (got < sizeof buf && idle < BENCH_SERIAL_TIMEOUT_MS * 1000) {
+			int c;
+			if (!readser(&c)) {
+				// spin briefly, then give the reader thread time
+				if (++idle % 1000 == 0)
+					sleep_millis(1);
+				continue;
+			}
+			idle = 0;
+			back[got++] = c;
+			writeser(c);
+		}
+		if (got != sizeof buf) {
+			write_log(_T("SERIAL: bench receive timed out after %d bytes\n"), got);
+			total = 0;
+			break;
+		}
+		if (memcmp(buf, back, sizeof buf)) {
+			write_log(_T("SERIAL: bench receive mismatch\n"));
+			total = 0;
+			break;
+		}
+		for (got = 0; got < sizeof buf; ) {
+			int len = read(sv[1], back + got, sizeof back - got);
+			if (len <= 0)
+				break;
+			got += len;
+		}
+		if (got != sizeof buf || memcmp(buf, back, sizeof buf)) {
+			write_log(_T("SERIAL: bench echo mismatch\n"));
+			total = 0;
+			break;
+		}
+		total += 2 * sizeof buf;
+	}
+	serial_reader_stop();
+	serialsocket = serialconn = UAE_SOCKET_INVALID;
+	tcpserial = FALSE;
+	close(sv[0]);
+	close(sv[1]);
+	return total;
+}
+#endif
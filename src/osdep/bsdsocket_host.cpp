@@ -34,10 +34,15 @@
 #include "threaddep/thread.h"
 #include "native2amiga.h"
 #include "bsdsocket.h"
+#include "commpipe.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
 #include <sys/ioctl.h>
 #ifdef HAVE_SYS_FILIO_H
 # include <sys/filio.h>
@@ -45,7 +50,9 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <cstddef>
+#include <ctime>
 #include <netdb.h>
+#include <poll.h>
 
 #include <csignal>
 #include <arpa/inet.h>
@@ -76,11 +83,8 @@
 
 uae_u32 bsdthr_Accept_2 (SB);
 uae_u32 bsdthr_Recv_2 (SB);
-uae_u32 bsdthr_blockingstuff (uae_u32 (*tryfunc)(SB), SB);
-uae_u32 bsdthr_SendRecvAcceptConnect (uae_u32 (*tryfunc)(SB), SB);
 uae_u32 bsdthr_Send_2 (SB);
 uae_u32 bsdthr_Connect_2 (SB);
-uae_u32 bsdthr_WaitSelect (SB);
 uae_u32 bsdthr_Wait (SB);
 void clearsockabort (SB);
 
@@ -687,140 +691,528 @@ uae_u32 bsdthr_Connect_2 (SB)
 	}
 }
 
-uae_u32 bsdthr_SendRecvAcceptConnect (uae_u32 (*tryfunc)(SB), SB)
+/*
+ * Socket reactor
+ *
+ * One thread serves the blocking operations of all socket bases. A host
+ * socket is added to a single epoll (kqueue on BSD and macOS) set the first
+ * time an operation has to wait on it and stays there, edge-triggered,
+ * until it is closed. An operation that would block parks its socket base
+ * on the waiter list of each descriptor it depends on and is retried when
+ * one of them reports new readiness; completion signals the Amiga task.
+ * Host name lookups can block for seconds and run on a resolver thread.
+ */
+
+#define BSD_REACTOR_EVENTS 64
+
+struct bsd_waiter {
+	struct bsd_reactor_op *op;
+	int fd;
+	struct bsd_waiter *next;
+};
+
+struct bsd_reactor_op {
+	struct socketbase *sb;
+	uae_u32 (*tryfunc)(SB);		/* connect/send/recv/accept step */
+	bool queued, detach, parked, ready;
+	struct bsd_reactor_op *qnext;	/* submit queue */
+	struct bsd_reactor_op *pnext;	/* parked operations */
+	struct bsd_reactor_op *rnext;	/* operations to retry */
+	uae_s64 deadline;		/* WaitSelect timeout in ms, -1 if none */
+	struct bsd_waiter *waiters;
+	int nwaiters, maxwaiters;
+	struct pollfd *pollfds;		/* WaitSelect descriptors, host side */
+	int *amigafds;			/* and their Amiga side numbers */
+	int npollfds, maxpollfds;
+};
+
+static int reactor_fd = -1;
+static int reactor_wake[2] = { -1, -1 };
+static uae_thread_id reactor_tid;
+static uae_sem_t reactor_lock;
+static struct bsd_reactor_op *reactor_queue;
+static struct bsd_reactor_op *reactor_parked;
+static struct bsd_waiter **reactor_fdwaiters;
+static uae_u8 *reactor_fdregistered;
+static int reactor_fdsize;
+static bool reactor_rescan;	/* a watched descriptor was closed */
+
+static smp_comm_pipe resolver_pipe;
+static uae_thread_id resolver_tid;
+
+static void bsd_waitselect_prepare (struct bsd_reactor_op *op);
+static bool bsd_waitselect_try (struct bsd_reactor_op *op, int *err);
+static void bsd_waitselect_clear (SB);
+
+static uae_s64 bsd_reactor_now (void)
 {
-	return bsdthr_blockingstuff (tryfunc, sb);
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uae_s64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
-uae_u32 bsdthr_blockingstuff(uae_u32(*tryfunc)(SB), SB)
+/* Called with reactor_lock held. Only the reactor thread grows the tables. */
+static void bsd_reactor_growfds (int fd)
 {
-	int done = 0, foo = 0;
-	long flags;
-	int nonblock;
-	if ((flags = fcntl(sb->s, F_GETFL)) == -1)
-		flags = 0;
-	nonblock = (flags & O_NONBLOCK);
-	fcntl(sb->s, F_SETFL, flags | O_NONBLOCK);
-	while (!done) {
-		done = 1;
-		foo = tryfunc(sb);
-		if (foo < 0 && !nonblock) {
-			if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINPROGRESS)) {
-				fd_set readset, writeset, exceptset;
-				int maxfd = (sb->s > sb->sockabort[0]) ? sb->s : sb->sockabort[0];
-				int num;
-
-				FD_ZERO(&readset);
-				FD_ZERO(&writeset);
-				FD_ZERO(&exceptset);
-
-				if (sb->action == 3 || sb->action == 6)
-					FD_SET(sb->s, &readset);
-				if (sb->action == 2 || sb->action == 1 || sb->action == 4)
-					FD_SET(sb->s, &writeset);
-				FD_SET(sb->sockabort[0], &readset);
-
-				num = select(maxfd + 1, &readset, &writeset, &exceptset, NULL);
-				if (num == -1) {
-					write_log("Blocking select(%d) returns -1,errno is %d\n", sb->sockabort[0], errno);
-					fcntl(sb->s, F_SETFL, flags);
-					return -1;
-				}
+	int size = reactor_fdsize ? reactor_fdsize : 256;
 
-				if (FD_ISSET(sb->sockabort[0], &readset) || FD_ISSET(sb->sockabort[0], &writeset)) {
-					/* reset sock abort pipe */
-					/* read from the pipe to reset it */
-					write_log("select aborted from signal\n");
+	if (fd < reactor_fdsize)
+		return;
+	while (size <= fd)
+		size *= 2;
+	reactor_fdwaiters = xrealloc (struct bsd_waiter *, reactor_fdwaiters, size);
+	reactor_fdregistered = xrealloc (uae_u8, reactor_fdregistered, size);
+	memset (reactor_fdwaiters + reactor_fdsize, 0, (size - reactor_fdsize) * sizeof (struct bsd_waiter *));
+	memset (reactor_fdregistered + reactor_fdsize, 0, size - reactor_fdsize);
+	reactor_fdsize = size;
+}
 
-					clearsockabort(sb);
-					write_log("Done read\n");
-					errno = EINTR;
-					done = 1;
-				}
-				else {
-					done = 0;
-				}
-			}
-			else if (errno == EINTR)
-				done = 1;
-		}
+static bool bsd_reactor_register (int fd)
+{
+	bool ok = true;
+
+	uae_sem_wait (&reactor_lock);
+	bsd_reactor_growfds (fd);
+	if (!reactor_fdregistered[fd]) {
+#ifdef __linux__
+		struct epoll_event ev{};
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP | EPOLLET;
+		ev.data.fd = fd;
+		ok = epoll_ctl (reactor_fd, EPOLL_CTL_ADD, fd, &ev) == 0 || errno == EEXIST;
+#else
+		struct kevent ev[2];
+		EV_SET (&ev[0], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, NULL);
+		EV_SET (&ev[1], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, NULL);
+		ok = kevent (reactor_fd, ev, 2, NULL, 0, NULL) == 0;
+#endif
+		if (ok)
+			reactor_fdregistered[fd] = 1;
+		else
+			write_log ("BSDSOCK: reactor can't watch descriptor %d, errno is %d\n", fd, errno);
 	}
-	fcntl(sb->s, F_SETFL, flags);
-	return foo;
+	uae_sem_post (&reactor_lock);
+	return ok;
 }
 
-static int bsdlib_threadfunc(void* arg)
+/* Must be called before a watched descriptor is closed, its number may be reused. */
+static void bsd_reactor_forget (int fd)
 {
-	auto* sb = (struct socketbase*)arg;
+	if (reactor_fd < 0 || fd < 0)
+		return;
+	uae_sem_wait (&reactor_lock);
+	if (fd < reactor_fdsize && reactor_fdregistered[fd]) {
+		reactor_fdregistered[fd] = 0;
+#ifdef __linux__
+		epoll_ctl (reactor_fd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+	}
+	uae_sem_post (&reactor_lock);
+}
 
-	write_log("THREAD_START\n");
+/* Call after closing a descriptor, a parked WaitSelect on it gets no event */
+static void bsd_reactor_closed (void)
+{
+	char chr = 0;
 
-	while (1) {
-		uae_sem_wait(&sb->sem);
+	if (reactor_fd < 0)
+		return;
+	uae_sem_wait (&reactor_lock);
+	reactor_rescan = true;
+	uae_sem_post (&reactor_lock);
+	if (write (reactor_wake[1], &chr, 1) != 1 && errno != EAGAIN)
+		write_log ("BSDSOCK: can't wake socket reactor, errno is %d\n", errno);
+}
 
-		write_log("Socket thread got action %d\n", sb->action);
+static void bsd_reactor_addwaiter (struct bsd_reactor_op *op, int fd)
+{
+	struct bsd_waiter *w;
 
-		TrapContext* ctx = sb->context;  // FIXME: Correct?
+	if (op->nwaiters >= op->maxwaiters) {
+		op->maxwaiters = op->maxwaiters ? op->maxwaiters * 2 : 8;
+		op->waiters = xrealloc (struct bsd_waiter, op->waiters, op->maxwaiters);
+	}
+	w = &op->waiters[op->nwaiters++];
+	w->op = op;
+	w->fd = fd;
+	w->next = NULL;
+}
 
-		switch (sb->action) {
-		case 0:       /* kill thread (CloseLibrary) */
+static bool bsd_reactor_park (struct bsd_reactor_op *op)
+{
+	int i;
 
-			write_log("THREAD_END\n");
+	for (i = 0; i < op->nwaiters; i++) {
+		if (!bsd_reactor_register (op->waiters[i].fd))
+			return false;
+	}
+	for (i = 0; i < op->nwaiters; i++) {
+		struct bsd_waiter *w = &op->waiters[i];
+		w->next = reactor_fdwaiters[w->fd];
+		reactor_fdwaiters[w->fd] = w;
+	}
+	op->pnext = reactor_parked;
+	reactor_parked = op;
+	op->parked = true;
+	return true;
+}
 
-			uae_sem_destroy(&sb->sem);
-			return 0;
+static void bsd_reactor_unpark (struct bsd_reactor_op *op)
+{
+	struct bsd_reactor_op **pp;
+	int i;
 
-		case 1:       /* Connect */
-			sb->resultval = bsdthr_SendRecvAcceptConnect(bsdthr_Connect_2, sb);
+	if (!op->parked)
+		return;
+	for (i = 0; i < op->nwaiters; i++) {
+		struct bsd_waiter *w = &op->waiters[i];
+		struct bsd_waiter **wp = &reactor_fdwaiters[w->fd];
+		while (*wp && *wp != w)
+			wp = &(*wp)->next;
+		if (*wp)
+			*wp = w->next;
+	}
+	for (pp = &reactor_parked; *pp; pp = &(*pp)->pnext) {
+		if (*pp == op) {
+			*pp = op->pnext;
 			break;
+		}
+	}
+	op->nwaiters = 0;
+	op->parked = false;
+}
 
-			/* @@@ Should check (from|to)len so it's 16.. */
-		case 2:       /* Send[to] */
-			sb->resultval = bsdthr_SendRecvAcceptConnect(bsdthr_Send_2, sb);
-			break;
+static bool bsd_reactor_aborted (SB)
+{
+	struct pollfd pfd;
 
-		case 3:       /* Recv[from] */
-			sb->resultval = bsdthr_SendRecvAcceptConnect(bsdthr_Recv_2, sb);
-			break;
+	pfd.fd = sb->sockabort[0];
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll (&pfd, 1, 0) > 0;
+}
 
-		case 4: {     /* Gethostbyname */
-			struct hostent* tmphostent = gethostbyname((char*)get_real_address(sb->name));
+static void bsd_reactor_complete (struct bsd_reactor_op *op, int err)
+{
+	SB = op->sb;
+	TrapContext* ctx = sb->context;  // FIXME: Correct?
 
-			if (tmphostent) {
-				copyHostent(ctx, tmphostent, sb);
-				bsdsocklib_setherrno(ctx, sb, 0);
-			}
-			else
-				SETHERRNO;
+	bsd_reactor_unpark (op);
+	errno = err;
+	SETERRNO;
+	SETSIGNAL;
+}
 
-			break;
+static bool bsd_socket_try (struct bsd_reactor_op *op, int *err)
+{
+	SB = op->sb;
+	long flags;
+	int foo;
+
+	if ((flags = fcntl (sb->s, F_GETFL)) == -1)
+		flags = 0;
+	fcntl (sb->s, F_SETFL, flags | O_NONBLOCK);
+	foo = op->tryfunc (sb);
+	*err = errno;
+	fcntl (sb->s, F_SETFL, flags);
+	sb->resultval = foo;
+	if (foo >= 0 || (flags & O_NONBLOCK))
+		return true;
+	return *err != EAGAIN && *err != EWOULDBLOCK && *err != EINPROGRESS;
+}
+
+static void bsd_reactor_run (struct bsd_reactor_op *op)
+{
+	SB = op->sb;
+	bool done;
+	int err = 0, i;
+
+	bsd_reactor_unpark (op);
+	if (sb->action == 5)
+		done = bsd_waitselect_try (op, &err);
+	else
+		done = bsd_socket_try (op, &err);
+	if (done) {
+		bsd_reactor_complete (op, err);
+		return;
+	}
+
+	if (bsd_reactor_aborted (sb)) {
+		write_log ("select aborted from signal\n");
+		clearsockabort (sb);
+		if (sb->action == 5) {
+			bsd_waitselect_clear (sb);
+			sb->resultval = 0;
+			bsd_reactor_complete (op, 0);
+		} else {
+			sb->resultval = -1;
+			bsd_reactor_complete (op, EINTR);
 		}
+		return;
+	}
 
-		case 5:       /* WaitSelect */
-			sb->resultval = bsdthr_WaitSelect(sb);
-			break;
+	if (sb->action == 5) {
+		for (i = 0; i < op->npollfds; i++)
+			bsd_reactor_addwaiter (op, op->pollfds[i].fd);
+	} else {
+		bsd_reactor_addwaiter (op, sb->s);
+	}
+	bsd_reactor_addwaiter (op, sb->sockabort[0]);
+	if (!bsd_reactor_park (op)) {
+		op->nwaiters = 0;
+		sb->resultval = -1;
+		bsd_reactor_complete (op, err ? err : EBADF);
+	}
+}
 
-		case 6:       /* Accept */
-			sb->resultval = bsdthr_SendRecvAcceptConnect(bsdthr_Accept_2, sb);
-			break;
+static void bsd_reactor_start (struct bsd_reactor_op *op)
+{
+	SB = op->sb;
 
-		case 7: {
-			struct hostent* tmphostent = gethostbyaddr(get_real_address(sb->name), sb->a_addrlen, sb->flags);
+	write_log ("Socket reactor got action %d\n", sb->action);
 
-			if (tmphostent) {
-				copyHostent(ctx, tmphostent, sb);
-				bsdsocklib_setherrno(ctx, sb, 0);
-			}
-			else
-				SETHERRNO;
+	switch (sb->action) {
+	case 1:       /* Connect */
+		op->tryfunc = bsdthr_Connect_2;
+		break;
+	/* @@@ Should check (from|to)len so it's 16.. */
+	case 2:       /* Send[to] */
+		op->tryfunc = bsdthr_Send_2;
+		break;
+	case 3:       /* Recv[from] */
+		op->tryfunc = bsdthr_Recv_2;
+		break;
+	case 5:       /* WaitSelect */
+		bsd_waitselect_prepare (op);
+		break;
+	case 6:       /* Accept */
+		op->tryfunc = bsdthr_Accept_2;
+		break;
+	default:
+		write_log ("BSDSOCK: reactor got unknown action %d\n", sb->action);
+		return;
+	}
+	bsd_reactor_run (op);
+}
 
-			break;
+static void bsd_reactor_submit (struct bsd_reactor_op *op)
+{
+	char chr = 0;
+
+	uae_sem_wait (&reactor_lock);
+	if (!op->queued) {
+		op->queued = true;
+		op->qnext = reactor_queue;
+		reactor_queue = op;
+	}
+	uae_sem_post (&reactor_lock);
+	if (write (reactor_wake[1], &chr, 1) != 1 && errno != EAGAIN)
+		write_log ("BSDSOCK: can't wake socket reactor, errno is %d\n", errno);
+}
+
+static void bsd_reactor_takequeue (void)
+{
+	struct bsd_reactor_op *op, *next;
+
+	uae_sem_wait (&reactor_lock);
+	op = reactor_queue;
+	reactor_queue = NULL;
+	for (next = op; next; next = next->qnext)
+		next->queued = false;
+	uae_sem_post (&reactor_lock);
+
+	while (op) {
+		next = op->qnext;
+		if (op->detach) {
+			bsd_reactor_unpark (op);
+			uae_sem_post (&op->sb->sem);
+		} else {
+			bsd_reactor_start (op);
+		}
+		op = next;
+	}
+}
+
+static int bsd_reactor_timeout (void)
+{
+	struct bsd_reactor_op *op;
+	uae_s64 next = -1, now;
+
+	for (op = reactor_parked; op; op = op->pnext) {
+		if (op->deadline >= 0 && (next < 0 || op->deadline < next))
+			next = op->deadline;
+	}
+	if (next < 0)
+		return -1;
+	now = bsd_reactor_now ();
+	if (next <= now)
+		return 0;
+	return next - now > 0x7fffffff ? 0x7fffffff : (int)(next - now);
+}
+
+static int bsd_reactor_func (void *arg)
+{
+#ifdef __linux__
+	struct epoll_event evs[BSD_REACTOR_EVENTS];
+#else
+	struct kevent evs[BSD_REACTOR_EVENTS];
+	struct timespec ts;
+#endif
+	struct bsd_reactor_op *op, *ready;
+	struct bsd_waiter *w;
+	uae_s64 now;
+	char buf[64];
+	int i, n, fd, timeout;
+	bool rescan;
+
+	write_log ("THREAD_START\n");
+
+	for (;;) {
+		timeout = bsd_reactor_timeout ();
+#ifdef __linux__
+		n = epoll_wait (reactor_fd, evs, BSD_REACTOR_EVENTS, timeout);
+#else
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000;
+		n = kevent (reactor_fd, NULL, 0, evs, BSD_REACTOR_EVENTS, timeout < 0 ? NULL : &ts);
+#endif
+		if (n < 0) {
+			if (errno != EINTR)
+				write_log ("BSDSOCK: reactor wait failed, errno is %d\n", errno);
+			n = 0;
+		}
+
+		ready = NULL;
+		for (i = 0; i < n; i++) {
+#ifdef __linux__
+			fd = evs[i].data.fd;
+#else
+			fd = (int)evs[i].ident;
+#endif
+			if (fd == reactor_wake[0]) {
+				while (read (reactor_wake[0], buf, sizeof buf) > 0);
+				continue;
+			}
+			if (fd >= reactor_fdsize)
+				continue;
+			for (w = reactor_fdwaiters[fd]; w; w = w->next) {
+				if (!w->op->ready) {
+					w->op->ready = true;
+					w->op->rnext = ready;
+					ready = w->op;
+				}
+			}
+		}
+		/* a closed descriptor raises no event, retry WaitSelects so poll() reports POLLNVAL */
+		uae_sem_wait (&reactor_lock);
+		rescan = reactor_rescan;
+		reactor_rescan = false;
+		uae_sem_post (&reactor_lock);
+		now = bsd_reactor_now ();
+		for (op = reactor_parked; op; op = op->pnext) {
+			if (((op->deadline >= 0 && op->deadline <= now) || (rescan && op->sb->action == 5)) && !op->ready) {
+				op->ready = true;
+				op->rnext = ready;
+				ready = op;
+			}
 		}
+		while (ready) {
+			bool queued;
+			op = ready;
+			ready = op->rnext;
+			op->ready = false;
+			/* an interrupted operation may already have been replaced by the next one */
+			uae_sem_wait (&reactor_lock);
+			queued = op->queued;
+			uae_sem_post (&reactor_lock);
+			if (op->parked && !queued)
+				bsd_reactor_run (op);
 		}
+
+		bsd_reactor_takequeue ();
+	}
+	return 0;
+}
+
+static int bsd_resolver_func (void *arg)
+{
+	for (;;) {
+		SB = (struct socketbase *)read_comm_pipe_pvoid_blocking (&resolver_pipe);
+		TrapContext* ctx = sb->context;  // FIXME: Correct?
+		struct hostent* tmphostent;
+
+		write_log ("Resolver got action %d\n", sb->action);
+
+		if (sb->action == 4)      /* Gethostbyname */
+			tmphostent = gethostbyname ((char*)get_real_address (sb->name));
+		else
+			tmphostent = gethostbyaddr (get_real_address (sb->name), sb->a_addrlen, sb->flags);
+
+		if (tmphostent) {
+			copyHostent (ctx, tmphostent, sb);
+			bsdsocklib_setherrno (ctx, sb, 0);
+		}
+		else
+			SETHERRNO;
+
 		SETERRNO;
 		SETSIGNAL;
 	}
-	return 0;        /* Just to keep GCC happy.. */
+	return 0;
+}
+
+static bool bsd_reactor_init (void)
+{
+	if (reactor_fd >= 0)
+		return true;
+
+	if (pipe (reactor_wake) < 0) {
+		write_log ("BSDSOCK: Failed to create reactor pipe.\n");
+		return false;
+	}
+	fcntl (reactor_wake[0], F_SETFL, O_NONBLOCK);
+	fcntl (reactor_wake[1], F_SETFL, O_NONBLOCK);
+
+#ifdef __linux__
+	reactor_fd = epoll_create1 (EPOLL_CLOEXEC);
+	if (reactor_fd >= 0) {
+		struct epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = reactor_wake[0];
+		epoll_ctl (reactor_fd, EPOLL_CTL_ADD, reactor_wake[0], &ev);
+	}
+#else
+	reactor_fd = kqueue ();
+	if (reactor_fd >= 0) {
+		struct kevent ev;
+		EV_SET (&ev, reactor_wake[0], EVFILT_READ, EV_ADD, 0, 0, NULL);
+		kevent (reactor_fd, &ev, 1, NULL, 0, NULL);
+	}
+#endif
+	if (reactor_fd < 0) {
+		write_log ("BSDSOCK: Failed to create reactor, errno is %d\n", errno);
+		close (reactor_wake[0]);
+		close (reactor_wake[1]);
+		return false;
+	}
+
+	uae_sem_init (&reactor_lock, 0, 1);
+	init_comm_pipe (&resolver_pipe, 64, 1);
+
+	if (uae_start_thread ("bsdsocket", bsd_reactor_func, NULL, &reactor_tid) == BAD_THREAD
+		|| uae_start_thread ("bsdsocket resolver", bsd_resolver_func, NULL, &resolver_tid) == BAD_THREAD) {
+		write_log ("BSDSOCK: Failed to create thread.\n");
+		return false;
+	}
+	return true;
+}
+
+/* Hand the operation set up in sb to the thread that runs it */
+static void bsd_startaction (SB)
+{
+	if (sb->action == 4 || sb->action == 7)
+		write_comm_pipe_pvoid (&resolver_pipe, sb, 1);
+	else
+		bsd_reactor_submit (sb->reactor);
 }
 
 void clearsockabort(SB)
@@ -842,6 +1234,8 @@ int init_socket_layer(void)
 			write_log("Can't create sem %d\n", errno);
 			return 0;
 		}
+		if (!bsd_reactor_init())
+			return 0;
 		return 1;
 	}
 
@@ -879,14 +1273,9 @@ int host_sbinit (TrapContext *ctx, SB)
 	sb->hostent = uae_AllocMem (ctx, 1024, 0, sb->sysbase);
 	sb->hostentsize = 1024;
 
-	/* @@@ The thread should be PTHREAD_CREATE_DETACHED */
-	if (uae_start_thread ("bsdsocket", bsdlib_threadfunc, (void *)sb, &sb->thread) == BAD_THREAD) {
-		write_log ("BSDSOCK: Failed to create thread.\n");
-		uae_sem_destroy (&sb->sem);
-		close (sb->sockabort[0]);
-		close (sb->sockabort[1]);
-		return 0;
-	}
+	sb->reactor = xcalloc (struct bsd_reactor_op, 1);
+	sb->reactor->sb = sb;
+	sb->reactor->deadline = -1;
 	return 1;
 }
 
@@ -897,7 +1286,9 @@ void host_closesocketquick (int s)
 	l.l_linger = 0;
 	if(s != -1) {
 		setsockopt (s, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+		bsd_reactor_forget (s);
 		close (s);
+		bsd_reactor_closed ();
 	}
 }
 
@@ -909,24 +1300,29 @@ void host_sbcleanup (SB)
 		return;
 	}
 
-	uae_thread_id thread = sb->thread;
+	struct bsd_reactor_op *op = sb->reactor;
+	if (op) {
+		/* wait until the reactor has dropped any operation still parked for us */
+		op->detach = true;
+		bsd_reactor_submit (op);
+		uae_sem_wait (&sb->sem);
+		xfree (op->waiters);
+		xfree (op->pollfds);
+		xfree (op->amigafds);
+		xfree (op);
+		sb->reactor = NULL;
+	}
+
+	bsd_reactor_forget (sb->sockabort[0]);
 	close (sb->sockabort[0]);
 	close (sb->sockabort[1]);
 	for (i = 0; i < sb->dtablesize; i++) {
 		if (sb->dtable[i] != -1) {
+			bsd_reactor_forget (sb->dtable[i]);
 			close(sb->dtable[i]);
 		}
 	}
-	sb->action = 0;
-
-	uae_sem_post (&sb->sem); /* destroy happens on socket thread */
-
-	/* We need to join with the socket thread to allow the thread to die
-	 * and clean up resources when the underlying thread layer is pthreads.
-	 * Ideally, this shouldn't be necessary, but, for example, when SDL uses
-	 * pthreads, it always creates joinable threads - and we can't do anything
-	 * about that. */
-	uae_wait_thread (&thread);
+	uae_sem_destroy (&sb->sem);
 }
 
 void host_sbreset (void)
@@ -958,6 +1354,7 @@ int host_dup2socket(TrapContext *ctx, SB, int fd1, int fd2)
 			fd2++;
 			s2 = getsock(ctx, sb, fd2);
 			if (s2 != -1) {
+				bsd_reactor_forget (s2);
 				close (s2);
 			}
 			setsd (ctx, sb, fd2, dup (s1));
@@ -1064,7 +1461,7 @@ void host_accept(TrapContext *ctx, SB, uae_u32 sd, uae_u32 name, uae_u32 namelen
 	// used by bsdthr_Accept_2
 	sb->context = ctx;
 
-	uae_sem_post (&sb->sem);
+	bsd_startaction (sb);
 
 	WAITSIGNAL;
 	write_log("Accept returns %d\n", sb->resultval);
@@ -1093,7 +1490,7 @@ void host_connect(TrapContext *ctx, SB, uae_u32 sd, uae_u32 name, uae_u32 namele
 			sb->a_addrlen = namelen;
 			sb->action    = 1;
 
-			uae_sem_post (&sb->sem);
+			bsd_startaction (sb);
 
 			WAITSIGNAL;
 		} else {
@@ -1135,7 +1532,7 @@ void host_sendto (TrapContext *ctx, SB, uae_u32 sd, uae_u32 msg, uae_u8 *hmsg, u
 		sb->tolen  = tolen;
 		sb->action = 2;
 
-		uae_sem_post (&sb->sem);
+		bsd_startaction (sb);
 
 		WAITSIGNAL;
 
@@ -1179,7 +1576,7 @@ void host_recvfrom(TrapContext *ctx, SB, uae_u32 sd, uae_u32 msg, uae_u8 *hmsg,
 	sb->fromlen= addrlen;
 	sb->action = 3;
 
-	uae_sem_post (&sb->sem);
+	bsd_startaction (sb);
 
 	WAITSIGNAL;
 }
@@ -1413,8 +1810,10 @@ int host_CloseSocket(TrapContext *ctx, SB, int sd)
 	}
 	*/
 	write_log("CloseSocket Amiga: %d, NativeSide %d\n", sd, s);
+	bsd_reactor_forget (s);
 	retval = close (s);
 	SETERRNO;
+	bsd_reactor_closed ();
 	releasesock (ctx, sb, sd + 1);
 	return retval;
 }
@@ -1426,93 +1825,120 @@ static void fd_zero(TrapContext *ctx, uae_u32 fdset, uae_u32 nfds)
 		trap_put_long(ctx, fdset,0);
 }
 
-uae_u32 bsdthr_WaitSelect(SB)
+static void bsd_waitselect_clear (SB)
 {
-	fd_set sets[3];
-	int i, s, set, a_s, max;
-	uae_u32 a_set;
-	struct timeval tv {};
-	int r;
+	int set;
+
+	for (set = 0; set < 3; set++)
+		if (sb->sets[set] != 0)
+			bsd_amigaside_FD_ZERO(sb->sets[set]);
+}
+
+/* Turn the Amiga side sets into a poll() list, no FD_SETSIZE limit on host descriptors */
+static void bsd_waitselect_prepare (struct bsd_reactor_op *op)
+{
+	static const short setevents[3] = { POLLIN, POLLOUT, POLLPRI };
+	SB = op->sb;
+	int i, s, set;
+	short events;
 	TrapContext* ctx = NULL;  // FIXME: Correct?
 
 	write_log("WaitSelect: %d 0x%x 0x%x 0x%x 0x%x 0x%x\n", sb->nfds, sb->sets[0], sb->sets[1], sb->sets[2], sb->timeout, sb->sigmp);
 
-	if (sb->timeout)
-		write_log("WaitSelect: timeout %d %d\n", get_long(sb->timeout), get_long(sb->timeout + 4));
-
-	FD_ZERO(&sets[0]);
-	FD_ZERO(&sets[1]);
-	FD_ZERO(&sets[2]);
-
-	/* Set up the abort socket */
-	FD_SET(sb->sockabort[0], &sets[0]);
-	FD_SET(sb->sockabort[0], &sets[2]);
-	max = sb->sockabort[0];
-
-	for (set = 0; set < 3; set++) {
-		if (sb->sets[set] != 0) {
-			a_set = sb->sets[set];
-			for (i = 0; i < sb->nfds; i++) {
-				if (bsd_amigaside_FD_ISSET(i, a_set)) {
-					s = getsock(ctx, sb, i + 1);
-					write_log("WaitSelect: AmigaSide %d set. NativeSide %d.\n", i, s);
-					if (s == -1) {
-						write_log("BSDSOCK: WaitSelect() called with invalid descriptor %d in set %d.\n", i, set);
-					} else {
-						FD_SET(s, &sets[set]);
-						if (max < s) max = s;
-					}
-				}
-			}
+	op->npollfds = 0;
+	for (i = 0; i < sb->nfds; i++) {
+		events = 0;
+		for (set = 0; set < 3; set++) {
+			if (sb->sets[set] != 0 && bsd_amigaside_FD_ISSET(i, sb->sets[set]))
+				events |= setevents[set];
+		}
+		if (!events)
+			continue;
+		s = getsock(ctx, sb, i + 1);
+		write_log("WaitSelect: AmigaSide %d set. NativeSide %d.\n", i, s);
+		if (s == -1) {
+			write_log("BSDSOCK: WaitSelect() called with invalid descriptor %d.\n", i);
+			continue;
 		}
+		if (op->npollfds >= op->maxpollfds) {
+			op->maxpollfds = op->maxpollfds ? op->maxpollfds * 2 : 16;
+			op->pollfds = xrealloc(struct pollfd, op->pollfds, op->maxpollfds);
+			op->amigafds = xrealloc(int, op->amigafds, op->maxpollfds);
+		}
+		op->pollfds[op->npollfds].fd = s;
+		op->pollfds[op->npollfds].events = events;
+		op->pollfds[op->npollfds].revents = 0;
+		op->amigafds[op->npollfds] = i;
+		op->npollfds++;
 	}
 
-	max++;
-
+	op->deadline = -1;
 	if (sb->timeout) {
-		tv.tv_sec = get_long(sb->timeout);
-		tv.tv_usec = get_long(sb->timeout + 4);
+		write_log("WaitSelect: timeout %d %d\n", get_long(sb->timeout), get_long(sb->timeout + 4));
+		op->deadline = bsd_reactor_now() + (uae_s64)get_long(sb->timeout) * 1000 + (get_long(sb->timeout + 4) + 999) / 1000;
 	}
+}
 
-	write_log("Select going to select\n");
-	r = select(max, &sets[0], &sets[1], &sets[2], (sb->timeout == 0) ? NULL : &tv);
-	write_log("Select returns %d, errno is %d\n", r, errno);
-	if (r > 0) {
-		/* Socket told us to abort */
-		if (FD_ISSET(sb->sockabort[0], &sets[0])) {
-			/* read from the pipe to reset it */
-			write_log("WaitSelect aborted from signal\n");
-			r = 0;
-			for (set = 0; set < 3; set++)
-				if (sb->sets[set] != 0)
-					bsd_amigaside_FD_ZERO(sb->sets[set]);
-			clearsockabort(sb);
+static bool bsd_waitselect_try (struct bsd_reactor_op *op, int *err)
+{
+	SB = op->sb;
+	int i, r = 0;
+
+	if (op->npollfds > 0) {
+		r = poll(op->pollfds, op->npollfds, 0);
+		if (r < 0) {
+			*err = errno;
+			sb->resultval = -1;
+			return true;
 		}
-		else
-			/* This is perhaps slightly inefficient, but I don't care.. */
-			for (set = 0; set < 3; set++) {
-				a_set = sb->sets[set];
-				if (a_set != 0) {
-					bsd_amigaside_FD_ZERO(a_set);
-					for (i = 0; i < sb->nfds; i++) {
-						a_s = getsock(ctx, sb, i + 1);
-						if (a_s != -1) {
-							if (FD_ISSET(a_s, &sets[set])) {
-								write_log("WaitSelect: NativeSide %d set. AmigaSide %d.\n", a_s, i);
-
-								bsd_amigaside_FD_SET(i, a_set);
-							}
-						}
-					}
-				}
+	}
+	if (r > 0) {
+		/* a descriptor closed under us: select() fails with EBADF */
+		for (i = 0; i < op->npollfds; i++) {
+			if (op->pollfds[i].revents & POLLNVAL) {
+				write_log("WaitSelect: descriptor %d closed while waiting\n", op->amigafds[i]);
+				bsd_waitselect_clear(sb);
+				*err = EBADF;
+				sb->resultval = -1;
+				return true;
 			}
-	} else if (r == 0) {         /* Timeout. I think we're supposed to clear the sets.. */
-		for (set = 0; set < 3; set++)
-			if (sb->sets[set] != 0)
-				bsd_amigaside_FD_ZERO(sb->sets[set]);
+		}
+		/* count like select() does, one per descriptor and set */
+		r = 0;
+		for (i = 0; i < op->npollfds; i++) {
+			struct pollfd *p = &op->pollfds[i];
+			if ((p->events & POLLIN) && (p->revents & (POLLIN | POLLHUP | POLLERR)))
+				r++;
+			if ((p->events & POLLOUT) && (p->revents & (POLLOUT | POLLERR)))
+				r++;
+			if ((p->events & POLLPRI) && (p->revents & POLLPRI))
+				r++;
+		}
 	}
-	write_log("WaitSelect: r=%d errno=%d\n", r, errno);
-	return r;
+	if (r == 0) {
+		if (op->deadline < 0 || bsd_reactor_now() < op->deadline)
+			return false;
+		/* Timeout. I think we're supposed to clear the sets.. */
+		bsd_waitselect_clear(sb);
+		sb->resultval = 0;
+		*err = 0;
+		return true;
+	}
+
+	bsd_waitselect_clear(sb);
+	for (i = 0; i < op->npollfds; i++) {
+		struct pollfd *p = &op->pollfds[i];
+		if ((p->events & POLLIN) && (p->revents & (POLLIN | POLLHUP | POLLERR)))
+			bsd_amigaside_FD_SET(op->amigafds[i], sb->sets[0]);
+		if ((p->events & POLLOUT) && (p->revents & (POLLOUT | POLLERR)))
+			bsd_amigaside_FD_SET(op->amigafds[i], sb->sets[1]);
+		if ((p->events & POLLPRI) && (p->revents & POLLPRI))
+			bsd_amigaside_FD_SET(op->amigafds[i], sb->sets[2]);
+	}
+	write_log("WaitSelect: r=%d\n", r);
+	sb->resultval = r;
+	*err = 0;
+	return true;
 }
 
 void host_WaitSelect(TrapContext *ctx, SB, uae_u32 nfds, uae_u32 readfds, uae_u32 writefds, uae_u32 exceptfds, uae_u32 timeout, uae_u32 sigmp)
@@ -1565,7 +1991,7 @@ void host_WaitSelect(TrapContext *ctx, SB, uae_u32 nfds, uae_u32 readfds, uae_u3
 	sb->sigmp    = wssigs;
 	sb->action   = 5;
 
-	uae_sem_post (&sb->sem);
+	bsd_startaction (sb);
 
 	trap_call_add_dreg(ctx, 0, (((uae_u32)1) << sb->signal) | sb->eintrsigs | wssigs);
 	sigs = trap_call_lib(ctx, sb->sysbase, -0x13e);	// Wait()
@@ -1650,7 +2076,7 @@ void host_gethostbynameaddr (TrapContext *ctx, SB, uae_u32 name, uae_u32 namelen
 	else
 		sb->action = 7;
 
-	uae_sem_post (&sb->sem);
+	bsd_startaction (sb);
 
 	WAITSIGNAL;
 }
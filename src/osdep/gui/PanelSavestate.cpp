@@ -231,6 +231,7 @@ void RefreshPanelSavestate()
 
 	if (screenshot_filename.length() > 0)
 	{
+		screenshot_flush();
 		auto* const f = fopen(screenshot_filename.c_str(), "rbe");
 		if (f)
 		{
@@ -7,10 +7,6 @@
 #include "mp3decoder.h"
 #include <mpg123.h>
 
-
-#define MP3_BLOCK_SIZE 522
-#define RAW_BLOCK_SIZE 32768
-
 static int mp3_bitrates[] = {
 	0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, -1,
 	0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, -1,
@@ -31,89 +27,98 @@ static int mp3_samplesperframe[] = {
 
 mp3decoder::~mp3decoder()
 {
+	close();
 }
 
 mp3decoder::mp3decoder()
 {
+	g_mp3stream = nullptr;
+	framesize = 4;
 }
 
-uae_u8* mp3decoder::get(struct zfile* zf, uae_u8* outbuf, int maxsize)
+static ssize_t mp3_zfile_read(void *handle, void *buf, size_t size)
 {
-	int outoffset = 0;
-	unsigned char mp3buf[MP3_BLOCK_SIZE];
-	unsigned char rawbuf[RAW_BLOCK_SIZE];
+	return zfile_fread(buf, 1, size, (struct zfile*)handle);
+}
 
-	write_log(_T("MP3: decoding '%s'..\n"), zfile_getname(zf));
+static off_t mp3_zfile_lseek(void *handle, off_t offset, int whence)
+{
+	struct zfile *zf = (struct zfile*)handle;
+	if (zfile_fseek(zf, offset, whence))
+		return -1;
+	return zfile_ftell(zf);
+}
 
+bool mp3decoder::open(struct zfile* zf)
+{
+	close();
 	if (mpg123_init() != MPG123_OK)
 	{
 		write_log("MP3: failed to init mpeg123\n");
-		return nullptr;
+		return false;
 	}
-
-	const char** decoders = mpg123_decoders();
-	if (decoders == nullptr || decoders[0] == nullptr)
+	mpg123_handle* mh = mpg123_new(nullptr, nullptr);
+	if (mh == nullptr)
 	{
-		write_log("MP3: no mp3 decoder available\n");
+		write_log("MP3: failed to init default decoder\n");
 		mpg123_exit();
-		return nullptr;
+		return false;
 	}
-
-	mpg123_handle* mh = mpg123_new(nullptr, nullptr); // Open default decoder
-	if (mh == nullptr)
+	zfile_fseek(zf, 0, SEEK_SET);
+	if (mpg123_replace_reader_handle(mh, mp3_zfile_read, mp3_zfile_lseek, nullptr) != MPG123_OK ||
+		mpg123_open_handle(mh, zf) != MPG123_OK)
 	{
-		write_log("MP3: failed to init default decoder\n");
+		write_log("MP3: failed to open '%s'\n", zfile_getname(zf));
+		mpg123_delete(mh);
 		mpg123_exit();
-		return nullptr;
+		return false;
 	}
+	long rate;
+	int channels, encoding;
+	framesize = 4;
+	if (mpg123_getformat(mh, &rate, &channels, &encoding) == MPG123_OK && channels == 1)
+		framesize = 2;
+	g_mp3stream = mh;
+	return true;
+}
 
-	if (mpg123_open_feed(mh) == MPG123_OK)
+int mp3decoder::read(uae_u8* outbuf, int size)
+{
+	mpg123_handle* mh = (mpg123_handle*)g_mp3stream;
+	if (!mh)
+		return -1;
+	size_t decoded = 0;
+	int ret;
+	do {
+		ret = mpg123_read(mh, outbuf, size, &decoded);
+	} while (ret == MPG123_NEW_FORMAT && decoded == 0);
+	if (ret == MPG123_NEW_FORMAT)
+		ret = MPG123_OK;
+	if (ret != MPG123_OK && ret != MPG123_DONE)
 	{
-		zfile_fseek(zf, 0, SEEK_SET);
-		for (; outoffset < maxsize;)
-		{
-			size_t count = zfile_fread(mp3buf, 1, MP3_BLOCK_SIZE, zf);
-			if (count != MP3_BLOCK_SIZE)
-				break;
-
-			size_t decoded = 0;
-			int ret = mpg123_decode(mh, mp3buf, MP3_BLOCK_SIZE, rawbuf, RAW_BLOCK_SIZE, &decoded);
-
-			if (ret != MPG123_ERR && decoded != 0)
-			{
-				if (outoffset + decoded > maxsize)
-					decoded = maxsize - outoffset;
-				memcpy(outbuf + outoffset, rawbuf, decoded);
-				outoffset += decoded;
-			}
-
-			while (ret != MPG123_ERR && ret != MPG123_NEED_MORE && outoffset < maxsize)
-			{
-				ret = mpg123_decode(mh, nullptr, 0, rawbuf, RAW_BLOCK_SIZE, &decoded);
-				if (ret != MPG123_ERR && decoded != 0)
-				{
-					if (outoffset + decoded > maxsize)
-						decoded = maxsize - outoffset;
-					memcpy(outbuf + outoffset, rawbuf, decoded);
-					outoffset += decoded;
-				}
-			}
-
-			if (ret == MPG123_ERR)
-			{
-				write_log("MP3: error while decoding\n");
-				outbuf = nullptr;
-				break;
-			}
-		}
-
-		mpg123_close(mh);
+		write_log("MP3: error while decoding\n");
+		return -1;
 	}
+	return (int)decoded;
+}
 
+bool mp3decoder::seek(uae_s64 offset)
+{
+	mpg123_handle* mh = (mpg123_handle*)g_mp3stream;
+	if (!mh)
+		return false;
+	return mpg123_seek(mh, (off_t)(offset / framesize), SEEK_SET) >= 0;
+}
+
+void mp3decoder::close()
+{
+	mpg123_handle* mh = (mpg123_handle*)g_mp3stream;
+	if (!mh)
+		return;
+	mpg123_close(mh);
 	mpg123_delete(mh);
 	mpg123_exit();
-
-	return outbuf;
+	g_mp3stream = nullptr;
 }
 
 uae_u32 mp3decoder::getsize(struct zfile* zf)
@@ -2,9 +2,14 @@
 class mp3decoder
 {
     void *g_mp3stream;
+    int framesize;
 public:
     mp3decoder();
     ~mp3decoder();
-    uae_u8 *get(struct zfile *zf, uae_u8 *, int maxsize);
     uae_u32 getsize(struct zfile *zf);
+    // incremental decoding
+    bool open(struct zfile *zf);
+    int read(uae_u8 *outbuf, int size);
+    bool seek(uae_s64 offset);
+    void close();
 };
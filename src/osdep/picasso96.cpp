@@ -694,6 +694,55 @@ static void AmigaListAddTail(TrapContext *ctx, uaecptr l, uaecptr n)
 	trap_put_long(ctx, l + 8, n); // l->lh_TailPred = n;
 }
 
+/*
+* 128-bit vector helpers for the RTG blitter, fill, pattern and template
+* paths. The scalar code stays as the reference: p96_simd is only set after
+* p96_simd_select() has checked the vector paths give identical output.
+*/
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define P96_SIMD
+typedef __m128i p96_vec;
+#define P96V_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define P96V_STORE(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define P96V_SET1(x) _mm_set1_epi32((int)(x))
+#define P96V_AND(a, b) _mm_and_si128((a), (b))
+#define P96V_OR(a, b) _mm_or_si128((a), (b))
+#define P96V_XOR(a, b) _mm_xor_si128((a), (b))
+/* ~a & b */
+#define P96V_ANDNOT(a, b) _mm_andnot_si128((a), (b))
+/* (a & m) | (b & ~m) */
+#define P96V_BLEND(m, a, b) _mm_or_si128(_mm_and_si128((m), (a)), _mm_andnot_si128((m), (b)))
+/* all-ones lanes for set bits of a 4-bit group, first pixel in bit 3 */
+STATIC_INLINE p96_vec p96v_bitmask(uae_u32 nib)
+{
+	const __m128i lanes = _mm_set_epi32(1, 2, 4, 8);
+	return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(nib), lanes), lanes);
+}
+#elif (defined(CPU_AARCH64) || defined(USE_ARMNEON)) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define P96_SIMD
+typedef uint32x4_t p96_vec;
+#define P96V_LOAD(p) vreinterpretq_u32_u8(vld1q_u8((const uint8_t*)(p)))
+#define P96V_STORE(p, v) vst1q_u8((uint8_t*)(p), vreinterpretq_u8_u32(v))
+#define P96V_SET1(x) vdupq_n_u32((uint32_t)(x))
+#define P96V_AND(a, b) vandq_u32((a), (b))
+#define P96V_OR(a, b) vorrq_u32((a), (b))
+#define P96V_XOR(a, b) veorq_u32((a), (b))
+#define P96V_ANDNOT(a, b) vbicq_u32((b), (a))
+#define P96V_BLEND(m, a, b) vbslq_u32((m), (a), (b))
+STATIC_INLINE p96_vec p96v_bitmask(uae_u32 nib)
+{
+	static const uint32_t lanebits[4] = { 8, 4, 2, 1 };
+	return vtstq_u32(vdupq_n_u32(nib), vld1q_u32(lanebits));
+}
+#endif
+#ifdef P96_SIMD
+#define P96V_NOT(a) P96V_XOR((a), P96V_SET1(0xffffffff))
+#endif
+
+static bool p96_simd;
+
 /*
 * Fill a rectangle in the screen.
 */
@@ -717,7 +766,18 @@ static void do_fillrect_frame_buffer(struct RenderInfo *ri, int X, int Y, int Wi
 		Pen |= Pen << 16;
 		for (int lines = 0; lines < Height; lines++, dst += bpr) {
 			uae_u32 *p = (uae_u32*)dst;
-			for (cols = 0; cols < (Width & ~15); cols += 16) {
+			cols = 0;
+#ifdef P96_SIMD
+			if (p96_simd) {
+				p96_vec vpen = P96V_SET1(Pen);
+				for (; cols < (Width & ~15); cols += 16) {
+					P96V_STORE(p, vpen);
+					P96V_STORE(p + 4, vpen);
+					p += 8;
+				}
+			}
+#endif
+			for (; cols < (Width & ~15); cols += 16) {
 				*p++ = Pen;
 				*p++ = Pen;
 				*p++ = Pen;
@@ -748,7 +808,26 @@ static void do_fillrect_frame_buffer(struct RenderInfo *ri, int X, int Y, int Wi
 			if (same) {
 				memset(p, Pen & 0xff, Width * 3);
 			} else {
-				for (cols = 0; cols < (Width & ~7); cols += 8) {
+				cols = 0;
+#ifdef P96_SIMD
+				if (p96_simd) {
+					/* 16 pixels are exactly three vectors */
+					uae_u16 pat[24];
+					for (int i = 0; i < 24; i += 3) {
+						pat[i + 0] = Pen1;
+						pat[i + 1] = Pen2;
+						pat[i + 2] = Pen3;
+					}
+					p96_vec v0 = P96V_LOAD(pat), v1 = P96V_LOAD(pat + 8), v2 = P96V_LOAD(pat + 16);
+					for (; cols < (Width & ~15); cols += 16) {
+						P96V_STORE(p, v0);
+						P96V_STORE(p + 8, v1);
+						P96V_STORE(p + 16, v2);
+						p += 24;
+					}
+				}
+#endif
+				for (; cols < (Width & ~7); cols += 8) {
 					*p++ = Pen1;
 					*p++ = Pen2;
 					*p++ = Pen3;
@@ -777,7 +856,18 @@ static void do_fillrect_frame_buffer(struct RenderInfo *ri, int X, int Y, int Wi
 	{
 		for (int lines = 0; lines < Height; lines++, dst += bpr) {
 			uae_u32 *p = (uae_u32*)dst;
-			for (cols = 0; cols < (Width & ~7); cols += 8) {
+			cols = 0;
+#ifdef P96_SIMD
+			if (p96_simd) {
+				p96_vec vpen = P96V_SET1(Pen);
+				for (; cols < (Width & ~7); cols += 8) {
+					P96V_STORE(p, vpen);
+					P96V_STORE(p + 4, vpen);
+					p += 8;
+				}
+			}
+#endif
+			for (; cols < (Width & ~7); cols += 8) {
 				*p++ = Pen;
 				*p++ = Pen;
 				*p++ = Pen;
@@ -797,6 +887,34 @@ static void do_fillrect_frame_buffer(struct RenderInfo *ri, int X, int Y, int Wi
 	}
 }
 
+/*
+* Fill a rectangle in an 8-bit screen, only touching the bits set in Mask.
+*/
+static void do_fillrect_mask_frame_buffer(struct RenderInfo *ri, int X, int Y, int Width, int Height, uae_u32 Pen, uae_u8 Mask)
+{
+	uae_u8 *start = ri->Memory + Y * ri->BytesPerRow + X;
+	uae_u8 *end = start + Height * ri->BytesPerRow;
+
+	Pen &= Mask;
+	Mask = ~Mask;
+	for (; start != end; start += ri->BytesPerRow) {
+		uae_u8 *p = start;
+		int cols = 0;
+#ifdef P96_SIMD
+		if (p96_simd) {
+			p96_vec vpen = P96V_SET1(Pen * 0x01010101);
+			p96_vec vmask = P96V_SET1(Mask * 0x01010101);
+			for (; cols + 16 <= Width; cols += 16)
+				P96V_STORE(p + cols, P96V_OR(vpen, P96V_AND(P96V_LOAD(p + cols), vmask)));
+		}
+#endif
+		for (; cols < Width; cols++) {
+			uae_u32 tmpval = do_get_mem_byte(p + cols) & Mask;
+			do_put_mem_byte(p + cols, (uae_u8)(Pen | tmpval));
+		}
+	}
+}
+
 static void setupcursor(void)
 {
 #ifdef AMIBERRY
@@ -1450,42 +1568,55 @@ static void picasso_handle_hsync(void)
 #define BLT_MULT 1
 #define BLT_NAME BLIT_FALSE_32
 #define BLT_FUNC(s,d) *d = 0
+#define BLT_VEC(s,d) P96V_SET1(0)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOR_32
 #define BLT_FUNC(s,d) *d = ~((*s) | (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_OR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYDST_32
 #define BLT_FUNC(s,d) *d = (*d) & ~(*s)
+#define BLT_VEC(s,d) P96V_ANDNOT(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTSRC_32
 #define BLT_FUNC(s,d) *d = ~(*s)
+#define BLT_VEC(s,d) P96V_NOT(s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYSRC_32
 #define BLT_FUNC(s,d) *d = (*s) & ((~(*d)) & rgbmask)
+#define BLT_VEC(s,d) P96V_AND(s, P96V_ANDNOT(d, P96V_SET1(rgbmask)))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTDST_32
 #define BLT_FUNC(s,d) *d = (~(*d)) & rgbmask
+#define BLT_VEC(s,d) P96V_ANDNOT(d, P96V_SET1(rgbmask))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_EOR_32
 #define BLT_FUNC(s,d) *d = (*s) ^ (*d)
+#define BLT_VEC(s,d) P96V_XOR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NAND_32
 #define BLT_FUNC(s,d) *d = ~((*s) & (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_AND(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_AND_32
 #define BLT_FUNC(s,d) *d = (*s) & (*d)
+#define BLT_VEC(s,d) P96V_AND(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NEOR_32
 #define BLT_FUNC(s,d) *d = ~((*s) ^ (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_XOR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYSRC_32
 #define BLT_FUNC(s,d) *d = ~(*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(s), d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYDST_32
 #define BLT_FUNC(s,d) *d = ((~(*d)) & rgbmask) | (*s)
+#define BLT_VEC(s,d) P96V_OR(P96V_ANDNOT(d, P96V_SET1(rgbmask)), s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_OR_32
 #define BLT_FUNC(s,d) *d = (*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_TRUE_32
 #ifdef AMIBERRY
@@ -1493,6 +1624,7 @@ static void picasso_handle_hsync(void)
 #else
 #define BLT_FUNC(s,d) *d = 0xffffffff
 #endif
+#define BLT_VEC(s,d) P96V_SET1(0xffffffff)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_SWAP_32
 #define BLT_FUNC(s,d) { uae_u16 tmp = *d ; *d = *s; *s = tmp; }
@@ -1504,45 +1636,59 @@ static void picasso_handle_hsync(void)
 #define BLT_MULT 1
 #define BLT_NAME BLIT_FALSE_24
 #define BLT_FUNC(s,d) *d = 0
+#define BLT_VEC(s,d) P96V_SET1(0)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOR_24
 #define BLT_FUNC(s,d) *d = ~((*s) | (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_OR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYDST_24
 #define BLT_FUNC(s,d) *d = (*d) & ~(*s)
+#define BLT_VEC(s,d) P96V_ANDNOT(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTSRC_24
 #define BLT_FUNC(s,d) *d = ~(*s)
+#define BLT_VEC(s,d) P96V_NOT(s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYSRC_24
 #define BLT_FUNC(s,d) *d = (*s) & (~(*d))
+#define BLT_VEC(s,d) P96V_ANDNOT(d, s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTDST_24
 #define BLT_FUNC(s,d) *d = (~(*d))
+#define BLT_VEC(s,d) P96V_NOT(d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_EOR_24
 #define BLT_FUNC(s,d) *d = (*s) ^ (*d)
+#define BLT_VEC(s,d) P96V_XOR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NAND_24
 #define BLT_FUNC(s,d) *d = ~((*s) & (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_AND(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_AND_24
 #define BLT_FUNC(s,d) *d = (*s) & (*d)
+#define BLT_VEC(s,d) P96V_AND(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NEOR_24
 #define BLT_FUNC(s,d) *d = ~((*s) ^ (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_XOR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYSRC_24
 #define BLT_FUNC(s,d) *d = ~(*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(s), d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYDST_24
 #define BLT_FUNC(s,d) *d = (~(*d)) | (*s)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(d), s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_OR_24
 #define BLT_FUNC(s,d) *d = (*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_TRUE_24
 #define BLT_FUNC(s,d) *d = 0xffffffff
+#define BLT_VEC(s,d) P96V_SET1(0xffffffff)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_SWAP_24
 #define BLT_FUNC(s,d) { uae_u32 tmp = *d; *d = *s; *s = tmp; }
@@ -1554,42 +1700,55 @@ static void picasso_handle_hsync(void)
 #define BLT_MULT 2
 #define BLT_NAME BLIT_FALSE_16
 #define BLT_FUNC(s,d) *d = 0
+#define BLT_VEC(s,d) P96V_SET1(0)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOR_16
 #define BLT_FUNC(s,d) *d = ~((*s) | (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_OR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYDST_16
 #define BLT_FUNC(s,d) *d = (*d) & ~(*s)
+#define BLT_VEC(s,d) P96V_ANDNOT(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTSRC_16
 #define BLT_FUNC(s,d) *d = ~(*s)
+#define BLT_VEC(s,d) P96V_NOT(s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYSRC_16
 #define BLT_FUNC(s,d) *d = (*s) & ((~(*d)) & rgbmask)
+#define BLT_VEC(s,d) P96V_AND(s, P96V_ANDNOT(d, P96V_SET1(rgbmask)))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTDST_16
 #define BLT_FUNC(s,d) *d = ((~(*d)) & rgbmask)
+#define BLT_VEC(s,d) P96V_ANDNOT(d, P96V_SET1(rgbmask))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_EOR_16
 #define BLT_FUNC(s,d) *d = (*s) ^ (*d)
+#define BLT_VEC(s,d) P96V_XOR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NAND_16
 #define BLT_FUNC(s,d) *d = ~((*s) & (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_AND(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_AND_16
 #define BLT_FUNC(s,d) *d = (*s) & (*d)
+#define BLT_VEC(s,d) P96V_AND(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NEOR_16
 #define BLT_FUNC(s,d) *d = ~((*s) ^ (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_XOR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYSRC_16
 #define BLT_FUNC(s,d) *d = ~(*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(s), d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYDST_16
 #define BLT_FUNC(s,d) *d = ((~(*d)) & rgbmask) | (*s)
+#define BLT_VEC(s,d) P96V_OR(P96V_ANDNOT(d, P96V_SET1(rgbmask)), s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_OR_16
 #define BLT_FUNC(s,d) *d = (*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_TRUE_16
 #define BLT_FUNC(s,d) *d = 0xffff
@@ -1605,72 +1764,100 @@ static void picasso_handle_hsync(void)
 #define BLT_NAME BLIT_FALSE_8
 #define BLT_NAME_MASK BLIT_FALSE_MASK_8
 #define BLT_FUNC(s,d) *d = 0
+#define BLT_VEC(s,d) P96V_SET1(0)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((0) & mask)
+#define BLT_VEC_MASK(s,d) P96V_SET1(0)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOR_8
 #define BLT_NAME_MASK BLIT_NOR_MASK_8
 #define BLT_FUNC(s,d) *d = ~((*s) | (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_OR(s, d))
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~((*s) | (*d))) & mask)
+#define BLT_VEC_MASK(s,d) P96V_NOT(P96V_OR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYDST_8
 #define BLT_NAME_MASK BLIT_ONLYDST_MASK_8
 #define BLT_FUNC(s,d) *d = (*d) & ~(*s)
+#define BLT_VEC(s,d) P96V_ANDNOT(s, d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | (((*d) & ~(*s)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_ANDNOT(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTSRC_8
 #define BLT_NAME_MASK BLIT_NOTSRC_MASK_8
 #define BLT_FUNC(s,d) *d = ~(*s)
+#define BLT_VEC(s,d) P96V_NOT(s)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~(*s)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_NOT(s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_ONLYSRC_8
 #define BLT_NAME_MASK BLIT_ONLYSRC_MASK_8
 #define BLT_FUNC(s,d) *d = (*s) & ~(*d)
+#define BLT_VEC(s,d) P96V_ANDNOT(d, s)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | (((*s) & ~(*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_ANDNOT(d, s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTDST_8
 #define BLT_NAME_MASK BLIT_NOTDST_MASK_8
 #define BLT_FUNC(s,d) *d = ~(*d)
+#define BLT_VEC(s,d) P96V_NOT(d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~(*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_NOT(d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_EOR_8
 #define BLT_NAME_MASK BLIT_EOR_MASK_8
 #define BLT_FUNC(s,d) *d = (*s) ^ (*d)
+#define BLT_VEC(s,d) P96V_XOR(s, d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | (((*s) ^ (*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_XOR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NAND_8
 #define BLT_NAME_MASK BLIT_NAND_MASK_8
 #define BLT_FUNC(s,d) *d = ~((*s) & (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_AND(s, d))
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~((*s) & (*d))) & mask)
+#define BLT_VEC_MASK(s,d) P96V_NOT(P96V_AND(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_AND_8
 #define BLT_NAME_MASK BLIT_AND_MASK_8
 #define BLT_FUNC(s,d) *d = (*s) & (*d)
+#define BLT_VEC(s,d) P96V_AND(s, d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | (((*s) & (*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_AND(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NEOR_8
 #define BLT_NAME_MASK BLIT_NEOR_MASK_8
 #define BLT_FUNC(s,d) *d = ~((*s) ^ (*d))
+#define BLT_VEC(s,d) P96V_NOT(P96V_XOR(s, d))
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~((*s) ^ (*d))) & mask)
+#define BLT_VEC_MASK(s,d) P96V_NOT(P96V_XOR(s, d))
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYSRC_8
 #define BLT_NAME_MASK BLIT_NOTONLYSRC_MASK_8
 #define BLT_FUNC(s,d) *d = ~(*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(s), d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~(*s) | (*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_OR(P96V_NOT(s), d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_SRC_8
 #define BLT_NAME_MASK BLIT_SRC_MASK_8
 #define BLT_FUNC(s,d) *d = *s
+#define BLT_VEC(s,d) s
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((*s) & mask)
+#define BLT_VEC_MASK(s,d) s
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_NOTONLYDST_8
 #define BLT_NAME_MASK BLIT_NOTONLYDST_MASK_8
 #define BLT_FUNC(s,d) *d = ~(*d) | (*s)
+#define BLT_VEC(s,d) P96V_OR(P96V_NOT(d), s)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | ((~(*d) | (*s)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_OR(P96V_NOT(d), s)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_OR_8
 #define BLT_NAME_MASK BLIT_OR_MASK_8
 #define BLT_FUNC(s,d) *d = (*s) | (*d)
+#define BLT_VEC(s,d) P96V_OR(s, d)
 #define BLT_FUNC_MASK(s,d,mask) *d = ((*d) & ~mask) | (((*s) | (*d)) & mask)
+#define BLT_VEC_MASK(s,d) P96V_OR(s, d)
 #include "p96_blit.cpp.in"
 #define BLT_NAME BLIT_TRUE_8
 #define BLT_NAME_MASK BLIT_TRUE_MASK_8
@@ -3686,7 +3873,6 @@ static uae_u32 REGPARAM2 picasso_FillRect(TrapContext *ctx)
 	uae_u32 Pen = trap_get_dreg(ctx, 4);
 	uae_u8 Mask = (uae_u8)trap_get_dreg(ctx, 5);
 	uae_u8 RGBFmt = (uae_u8)trap_get_dreg(ctx, 7);
-	uae_u8 *oldstart;
 	int Bpp;
 	struct RenderInfo ri;
 	uae_u32 result = 0;
@@ -3711,20 +3897,7 @@ static uae_u32 REGPARAM2 picasso_FillRect(TrapContext *ctx)
 		} else {
 
 			/* We get here only if Mask != 0xFF */
-			Pen &= Mask;
-			Mask = ~Mask;
-			oldstart = ri.Memory + Y * ri.BytesPerRow + X * Bpp;
-			{
-				uae_u8 *start = oldstart;
-				uae_u8 *end = start + Height * ri.BytesPerRow;
-				for (; start != end; start += ri.BytesPerRow) {
-					uae_u8 *p = start;
-					for (int cols = 0; cols < Width; cols++) {
-						uae_u32 tmpval = do_get_mem_byte(p + cols) & Mask;
-						do_put_mem_byte(p + cols, (uae_u8)(Pen | tmpval));
-					}
-				}
-			}
+			do_fillrect_mask_frame_buffer(&ri, X, Y, Width, Height, Pen, Mask);
 		}
 	}
 	return 1;
@@ -3932,6 +4105,115 @@ STATIC_INLINE void PixelWrite(uae_u8 *mem, int bits, uae_u32 fgpen, int Bpp, uae
 	}
 }
 
+#ifdef P96_SIMD
+/*
+* Vector version of the 32-bit JAM1/JAM2/COMP pixel loops in BlitPattern
+* and BlitTemplate. 'bits' holds 'count' (multiple of 4) pixels, first
+* pixel in bit 31.
+*/
+static void PixelExpand32(uae_u8 *mem, uae_u32 bits, int count, int drawmode, int inversion, uae_u32 fgpen, uae_u32 bgpen, uae_u32 rgbmask)
+{
+	uae_u32 *p = (uae_u32 *)mem;
+	p96_vec vfg = P96V_SET1(fgpen);
+	p96_vec vbg = P96V_SET1(bgpen);
+	p96_vec vrgb = P96V_SET1(rgbmask);
+
+	if (inversion && drawmode != COMP)
+		bits = ~bits;
+	for (int i = 0; i < count; i += 4, p += 4, bits <<= 4) {
+		p96_vec m = p96v_bitmask(bits >> 28);
+		switch (drawmode)
+		{
+		case JAM1:
+			P96V_STORE(p, P96V_BLEND(m, vfg, P96V_LOAD(p)));
+			break;
+		case JAM2:
+			P96V_STORE(p, P96V_BLEND(m, vfg, vbg));
+			break;
+		case COMP:
+			P96V_STORE(p, P96V_XOR(P96V_LOAD(p), P96V_AND(m, vrgb)));
+			break;
+		}
+	}
+}
+#endif
+
+/*
+* Expand 'count' pixels of single plane pattern or template data to mem
+* using the draw mode. 'bits' holds the first pixel in bit 31.
+*/
+static void PixelExpand(uae_u8 *mem, uae_u32 bits, int count, int drawmode, int inversion, uae_u32 fgpen, uae_u32 bgpen, int Bpp, uae_u32 mask, uae_u32 rgbmask)
+{
+#ifdef P96_SIMD
+	if (p96_simd && Bpp == 4 && !(count & 3)) {
+		PixelExpand32(mem, bits, count, drawmode, inversion, fgpen, bgpen, rgbmask);
+		return;
+	}
+#endif
+	switch (drawmode)
+	{
+	case JAM1:
+		{
+			for (int i = 0; i < count; i++) {
+				int bit_set = (bits & 0x80000000) != 0;
+				bits <<= 1;
+				if (inversion)
+					bit_set = !bit_set;
+				if (bit_set)
+					PixelWrite(mem, i, fgpen, Bpp, mask);
+			}
+			break;
+		}
+	case JAM2:
+		{
+			for (int i = 0; i < count; i++) {
+				int bit_set = (bits & 0x80000000) != 0;
+				bits <<= 1;
+				if (inversion)
+					bit_set = !bit_set;
+				PixelWrite(mem, i, bit_set ? fgpen : bgpen, Bpp, mask);
+			}
+			break;
+		}
+	case COMP:
+		{
+			for (int i = 0; i < count; i++) {
+				int bit_set = (bits & 0x80000000) != 0;
+				bits <<= 1;
+				if (bit_set) {
+					switch (Bpp)
+					{
+					case 1:
+						{
+							mem[i] ^= rgbmask & mask;
+						}
+						break;
+					case 2:
+						{
+							uae_u16 *addr = (uae_u16 *)mem;
+							addr[i] ^= rgbmask;
+						}
+						break;
+					case 3:
+						{
+							uae_u32 *addr = (uae_u32 *)(mem + i * 3);
+							do_put_mem_long(addr, do_get_mem_long(addr) ^ 0x00ffffff);
+						}
+						break;
+					case 4:
+						{
+							uae_u32 *addr = (uae_u32 *)mem;
+							addr[i] ^= rgbmask;
+						}
+						break;
+					}
+				}
+			}
+			break;
+		}
+	}
+}
+
 /*
 * BlitPattern:
 *
@@ -4030,75 +4312,12 @@ static uae_u32 REGPARAM2 picasso_BlitPattern(TrapContext *ctx)
 				d = (d << xshift) | (d >> (16 - xshift));
 
 			for (int cols = 0; cols < W; cols += 16, uae_mem2 += Bpp * 16) {
-				int bits;
 				int max = W - cols;
-				uae_u32 data = d;
 
 				if (max > 16)
 					max = 16;
 
-				switch (pattern.DrawMode)
-				{
-				case JAM1:
-					{
-						for (bits = 0; bits < max; bits++) {
-							int bit_set = data & 0x8000;
-							data <<= 1;
-							if (inversion)
-								bit_set = !bit_set;
-							if (bit_set)
-								PixelWrite(uae_mem2, bits, fgpen, Bpp, Mask);
-						}
-						break;
-					}
-				case JAM2:
-					{
-						for (bits = 0; bits < max; bits++) {
-							int bit_set = data & 0x8000;
-							data <<= 1;
-							if (inversion)
-								bit_set = !bit_set;
-							PixelWrite(uae_mem2, bits, bit_set ? fgpen : bgpen, Bpp, Mask);
-						}
-						break;
-					}
-				case COMP:
-					{
-						for (bits = 0; bits < max; bits++) {
-							int bit_set = data & 0x8000;
-							data <<= 1;
-							if (bit_set) {
-								switch (Bpp)
-								{
-								case 1:
-									{
-										uae_mem2[bits] ^= rgbmask & Mask;
-									}
-									break;
-								case 2:
-									{
-										uae_u16 *addr = (uae_u16*)uae_mem2;
-										addr[bits] ^= rgbmask;
-									}
-									break;
-								case 3:
-									{
-										uae_u32 *addr = (uae_u32*)(uae_mem2 + bits * 3);
-										do_put_mem_long (addr, do_get_mem_long (addr) ^ 0x00ffffff);
-									}
-									break;
-								case 4:
-									{
-										uae_u32 *addr = (uae_u32*)uae_mem2;
-										addr[bits] ^= rgbmask;
-									}
-									break;
-								}
-							}
-						}
-						break;
-					}
-				}
+				PixelExpand(uae_mem2, (d & 0xffff) << 16, max, pattern.DrawMode, inversion, fgpen, bgpen, Bpp, Mask, rgbmask);
 			}
 		}
 		xfree(tmplbuf);
@@ -4207,69 +4426,7 @@ static uae_u32 REGPARAM2 picasso_BlitTemplate(TrapContext *ctx)
 
 				byte = data >> (8 - bitoffset);
 
-				switch (tmp.DrawMode)
-				{
-				case JAM1:
-					{
-						for (int bits = 0; bits < max; bits++) {
-							int bit_set = (byte & 0x80);
-							byte <<= 1;
-							if (inversion)
-								bit_set = !bit_set;
-							if (bit_set)
-								PixelWrite(uae_mem2, bits, fgpen, Bpp, Mask);
-						}
-						break;
-					}
-				case JAM2:
-					{
-						for (int bits = 0; bits < max; bits++) {
-							int bit_set = (byte & 0x80);
-							byte <<= 1;
-							if (inversion)
-								bit_set = !bit_set;
-							PixelWrite(uae_mem2, bits, bit_set ? fgpen : bgpen, Bpp, Mask);
-						}
-						break;
-					}
-				case COMP:
-					{
-						for (int bits = 0; bits < max; bits++) {
-							int bit_set = (byte & 0x80);
-							byte <<= 1;
-							if (bit_set) {
-								switch (Bpp)
-								{
-								case 1:
-									{
-										uae_u8 *addr = uae_mem2;
-										addr[bits] ^= rgbmask & Mask;
-									}
-									break;
-								case 2:
-									{
-										uae_u16 *addr = (uae_u16 *)uae_mem2;
-										addr[bits] ^= rgbmask;
-									}
-									break;
-								case 3:
-									{
-										uae_u32 *addr = (uae_u32 *)(uae_mem2 + bits * 3);
-										do_put_mem_long(addr, do_get_mem_long(addr) ^ 0xffffff);
-									}
-									break;
-								case 4:
-									{
-										uae_u32 *addr = (uae_u32 *)uae_mem2;
-										addr[bits] ^= rgbmask;
-									}
-									break;
-								}
-							}
-						}
-						break;
-					}
-				}
+				PixelExpand(uae_mem2, (byte & 0xff) << 24, max, tmp.DrawMode, inversion, fgpen, bgpen, Bpp, Mask, rgbmask);
 			}
 		}
 		xfree(tmpl_buffer);
@@ -6136,6 +6293,93 @@ addrbank gfxmem4_bank = {
 #endif
 addrbank *gfxmem_banks[MAX_RTG_BOARDS];
 
+#ifdef P96_SIMD
+#define P96_SIMD_TEST_W 61
+#define P96_SIMD_TEST_H 5
+#define P96_SIMD_TEST_BPR 320
+#define P96_SIMD_TEST_SIZE (P96_SIMD_TEST_BPR * 16)
+
+static const RGBFTYPE p96_simd_formats[] = { RGBFB_CLUT, RGBFB_R5G6B5PC, RGBFB_B8G8R8, RGBFB_B8G8R8A8 };
+
+/*
+* Run self-test operation n on buf with the current p96_simd setting.
+* Returns false when there are no more tests.
+*/
+static bool p96_simd_test(uae_u8 *buf, int n)
+{
+	/* separate, overlapping with src before dst, overlapping with src after dst */
+	static const int geometry[3][4] = { { 0, 8, 2, 0 }, { 1, 0, 4, 2 }, { 5, 3, 2, 1 } };
+	struct RenderInfo ri = { 0 };
+
+	ri.Memory = buf;
+	ri.BytesPerRow = P96_SIMD_TEST_BPR;
+	if (n < 4 * 16 * 3 * 2) {
+		RGBFTYPE fmt = p96_simd_formats[n & 3];
+		int op = (n >> 2) & 15;
+		const int *g = geometry[(n >> 6) % 3];
+		uae_u8 mask = n >= 4 * 16 * 3 ? 0x5a : 0xff;
+		do_blitrect_frame_buffer(&ri, &ri, g[0], g[1], g[2], g[3], P96_SIMD_TEST_W, P96_SIMD_TEST_H, mask, fmt, (BLIT_OPCODE)op);
+		return true;
+	}
+	n -= 4 * 16 * 3 * 2;
+	if (n < 4 * 2) {
+		uae_u32 pen = (n & 4) ? 0x11111111 : 0x00c0ffee;
+		do_fillrect_frame_buffer(&ri, 3, 1, P96_SIMD_TEST_W, P96_SIMD_TEST_H, pen, GetBytesPerPixel(p96_simd_formats[n & 3]));
+		return true;
+	}
+	n -= 4 * 2;
+	if (n < 2) {
+		do_fillrect_mask_frame_buffer(&ri, 3, 1, P96_SIMD_TEST_W, P96_SIMD_TEST_H, n ? 0xa5 : 0x3c, n ? 0x0f : 0xd2);
+		return true;
+	}
+	n -= 2;
+	if (n < 4 * 2 * 3) {
+		/* pattern (16), template (8) and partial (12) pixel runs */
+		static const int counts[3] = { 16, 8, 12 };
+		int drawmode = n & 3, inversion = (n >> 2) & 1;
+		PixelExpand(buf + 4, 0x9c3a5f01, counts[n >> 3], drawmode, inversion, 0x00123456, 0x00abcdef, 4, 0xff, 0x00ffffff);
+		return true;
+	}
+	return false;
+}
+#endif
+
+/* Use the vector RTG paths only if they match the scalar code bit for bit */
+static void p96_simd_select(void)
+{
+	static bool selected;
+
+	if (selected)
+		return;
+	selected = true;
+#ifdef P96_SIMD
+	uae_u8 *ref = xmalloc(uae_u8, P96_SIMD_TEST_SIZE);
+	uae_u8 *vec = xmalloc(uae_u8, P96_SIMD_TEST_SIZE);
+	bool ok = true;
+
+	for (int n = 0; ok; n++) {
+		uae_u32 seed = 0x9e3779b9 + n;
+		for (int i = 0; i < P96_SIMD_TEST_SIZE; i++) {
+			seed = seed * 1103515245 + 12345;
+			ref[i] = seed >> 24;
+		}
+		memcpy(vec, ref, P96_SIMD_TEST_SIZE);
+		p96_simd = false;
+		if (!p96_simd_test(ref, n))
+			break;
+		p96_simd = true;
+		p96_simd_test(vec, n);
+		if (memcmp(ref, vec, P96_SIMD_TEST_SIZE)) {
+			write_log(_T("P96: SIMD self-test %d failed, using scalar blitter\n"), n);
+			ok = false;
+		}
+	}
+	p96_simd = ok;
+	xfree(vec);
+	xfree(ref);
+#endif
+}
+
 /* Call this function first, near the beginning of code flow
 * Place in InitGraphics() which seems reasonable...
 * Also put it in reset_drawing() for safe-keeping.  */
@@ -6153,6 +6397,7 @@ void InitPicasso96(int monid)
 	oldscr = 0;
 	//fastscreen
 	memset (state, 0, sizeof (struct picasso96_state_struct));
+	p96_simd_select();
 
 	for (int i = 0; i < 256; i++) {
 		p2ctab[i][0] = (((i & 128) ? 0x01000000 : 0)
@@ -7269,6 +7514,72 @@ uae_u8 *save_p96 (size_t *len, uae_u8 *dstptr)
 	return dstbak;
 }
 
+#ifdef AMIBERRY_BENCH
+#include "bench.h"
+
+#define BENCH_P96_WIDTH 1024
+#define BENCH_P96_HEIGHT 16
+
+static uae_u8 *bench_p96_buffer(int idx)
+{
+	static uae_u8 *bufs[2];
+
+	if (!bufs[idx]) {
+		uae_u32 seed = 0x5eed0000 + idx;
+		bufs[idx] = xmalloc(uae_u8, BENCH_P96_WIDTH * 4 * BENCH_P96_HEIGHT);
+		for (int i = 0; i < BENCH_P96_WIDTH * 4 * BENCH_P96_HEIGHT; i++) {
+			seed = seed * 1103515245 + 12345;
+			bufs[idx][i] = seed >> 24;
+		}
+	}
+	return bufs[idx];
+}
+
+/* One row of RTG source format converted to a 32-bit host surface */
+uae_u64 bench_p96_copyrow(int srcpixbytes, int iterations)
+{
+	static const RGBFTYPE formats[] = { RGBFB_CLUT, RGBFB_CLUT, RGBFB_R5G6B5PC, RGBFB_B8G8R8, RGBFB_A8R8G8B8 };
+	struct picasso_vidbuf_description *vidinfo = &picasso_vidinfo[0];
+	uae_u8 *src = bench_p96_buffer(0);
+	uae_u8 *dst = bench_p96_buffer(1);
+	int convert[2];
+
+	vidinfo->splitypos = -1;
+	picasso96_state[0].Height = BENCH_P96_HEIGHT;
+	for (int i = 0; i < 256; i++)
+		vidinfo->clut[i] = i * 0x010101;
+	for (int i = 0; i < 65536; i++)
+		p96_rgbx16[i] = i * 0x0101;
+	convert[0] = convert[1] = getconvert(formats[srcpixbytes], 4);
+	for (int i = 0; i < iterations; i++) {
+		int y = i % BENCH_P96_HEIGHT;
+		copyrow(0, src, dst, 0, y, BENCH_P96_WIDTH, BENCH_P96_WIDTH * srcpixbytes, srcpixbytes,
+			0, y, BENCH_P96_WIDTH * 4, 4, convert, p96_rgbx16);
+	}
+	return (uae_u64)iterations * BENCH_P96_WIDTH * srcpixbytes;
+}
+
+/* BlitPlanar2Direct with a plain copy minterm, color map at chip RAM 0x1000 */
+uae_u64 bench_p96_planartodirect(int depth, int iterations)
+{
+	uae_u8 *planes = bench_p96_buffer(0);
+	struct RenderInfo ri = { 0 };
+	struct BitMap bm = { 0 };
+
+	ri.Memory = bench_p96_buffer(1);
+	ri.BytesPerRow = BENCH_P96_WIDTH * 4;
+	ri.RGBFormat = RGBFB_B8G8R8A8;
+	bm.BytesPerRow = BENCH_P96_WIDTH / 8;
+	bm.Rows = BENCH_P96_HEIGHT;
+	bm.Depth = depth;
+	for (int i = 0; i < depth; i++)
+		bm.Planes[i] = planes + i * bm.BytesPerRow * BENCH_P96_HEIGHT;
+	for (int i = 0; i < iterations; i++)
+		PlanarToDirect(NULL, &ri, &bm, 0, 0, 0, 0, BENCH_P96_WIDTH, BENCH_P96_HEIGHT, BLIT_SRC, 0xff, 0x1000);
+	return (uae_u64)iterations * BENCH_P96_WIDTH * BENCH_P96_HEIGHT * 4;
+}
+#endif
+
 #endif
 
 
@@ -53,7 +53,10 @@ extern void enablecapture(int monid);
 extern void disablecapture();
 extern void activationtoggle(int monid, bool inactiveonly);
 extern bool create_screenshot();
-extern int save_thumb(const std::string& path);
+typedef void (*screenshot_done_func)(void* data, bool ok);
+extern int save_thumb(const std::string& path, bool notify = false, screenshot_done_func done = nullptr, void* done_data = nullptr);
+extern bool screenshot_flush();
+extern void screenshot_poll();
 
 extern amiberry_hotkey enter_gui_key;
 extern SDL_GameControllerButton enter_gui_button;
@@ -0,0 +1,264 @@
+/*
+* UAE - The Un*x Amiga Emulator
+*
+* Guest PC sampling profiler
+*
+* Every pcprofile_interval scanlines the current 68k PC, whether it was
+* executing translated (JIT) code and, when stack frame tracking is active,
+* the debugger branch stack are pushed to a single producer/single consumer
+* ring. A worker thread drains the ring into per-address and per-call-stack
+* counters. When emulation stops the counters are symbolized and reported
+* to the log, and optionally written out as folded stacks that flamegraph.pl
+* and compatible tools read directly.
+*
+*/
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "options.h"
+#include "memory.h"
+#include "newcpu.h"
+#include "devices.h"
+#include "debugmem.h"
+#include "threaddep/thread.h"
+#include "zfile.h"
+#include "pcprofile.h"
+
+#define PCPROFILE_RING 4096
+#define PCPROFILE_DEPTH 16
+#define PCPROFILE_TOP 40
+
+#define PCPF_JIT 1
+#define PCPF_SUPER 2
+
+struct pcsample
+{
+	uaecptr pc;
+	uae_u8 flags;
+	uae_u8 depth;
+	uaecptr stack[PCPROFILE_DEPTH];
+};
+
+struct pccount
+{
+	uae_u32 interp;
+	uae_u32 jit;
+};
+
+static struct pcsample *ring;
+static volatile uae_atomic ring_head, ring_tail;
+static uae_u32 samples_dropped;
+
+static uae_thread_id prof_tid;
+static uae_sem_t prof_sem;
+static volatile int prof_quit;
+static int prof_interval, prof_counter;
+
+static std::unordered_map<uaecptr, struct pccount> *prof_pcs;
+static std::map<std::vector<uaecptr>, uae_u32> *prof_stacks;
+static uae_u32 prof_total, prof_total_jit;
+
+static void pcprofile_drain(void)
+{
+	uae_u32 tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+	uae_u32 head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+	std::vector<uaecptr> key;
+
+	while (tail != head) {
+		const struct pcsample *s = &ring[tail & (PCPROFILE_RING - 1)];
+		struct pccount &c = (*prof_pcs)[s->pc];
+		if (s->flags & PCPF_JIT) {
+			c.jit++;
+			prof_total_jit++;
+		} else {
+			c.interp++;
+		}
+		prof_total++;
+		key.assign(s->stack, s->stack + s->depth);
+		key.push_back(s->pc);
+		(*prof_stacks)[key]++;
+		tail++;
+		__atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+static int pcprofile_thread(void *arg)
+{
+	while (!prof_quit) {
+		uae_sem_trywait_delay(&prof_sem, 100);
+		pcprofile_drain();
+	}
+	pcprofile_drain();
+	return 0;
+}
+
+void pcprofile_hsync(void)
+{
+	if (--prof_counter > 0)
+		return;
+	prof_counter = prof_interval;
+
+	uae_u32 head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+	uae_u32 tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= PCPROFILE_RING) {
+		samples_dropped++;
+		return;
+	}
+	struct pcsample *s = &ring[head & (PCPROFILE_RING - 1)];
+	s->pc = m68k_getpc();
+	s->flags = regs.s ? PCPF_SUPER : 0;
+#ifdef JIT
+	if (currprefs.cachesize && compemu_pc_translated())
+		s->flags |= PCPF_JIT;
+#endif
+#ifdef DEBUGGER
+	s->depth = debugmem_get_branch_stack(s->stack, PCPROFILE_DEPTH);
+#else
+	s->depth = 0;
+#endif
+	__atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+	// wake up the aggregator when the ring is a quarter full
+	if (((head + 1) & (PCPROFILE_RING / 4 - 1)) == 0)
+		uae_sem_post(&prof_sem);
+}
+
+/* Routine name for addr, falls back to the memory bank name */
+static std::string pcprofile_symbol(uaecptr addr, std::string *segment)
+{
+	TCHAR txt[256];
+
+#ifdef DEBUGGER
+	TCHAR seg[256], segname[256];
+	uae_u32 offset;
+	if (debugmem_get_segment(addr, NULL, NULL, seg, segname)) {
+		if (segment)
+			*segment = segname;
+		if (debugmem_get_symbol_near(addr, txt, sizeof txt / sizeof(TCHAR), &offset))
+			return txt;
+		_stprintf(txt, _T("%s"), seg);
+		return txt;
+	}
+#endif
+	addrbank *ab = &get_mem_bank(addr);
+	if (segment)
+		*segment = ab->name ? ab->name : _T("<none>");
+	_stprintf(txt, _T("%08x"), addr);
+	return txt;
+}
+
+static void pcprofile_report(void)
+{
+	if (!prof_total)
+		return;
+
+	std::vector<std::pair<uaecptr, struct pccount>> pcs(prof_pcs->begin(), prof_pcs->end());
+	std::sort(pcs.begin(), pcs.end(), [](const auto &a, const auto &b) {
+		return a.second.interp + a.second.jit > b.second.interp + b.second.jit;
+	});
+	std::map<std::string, uae_u32> segs;
+	std::map<uaecptr, std::string> names;
+	for (const auto &p : pcs) {
+		std::string seg;
+		names[p.first] = pcprofile_symbol(p.first, &seg);
+		segs[seg] += p.second.interp + p.second.jit;
+	}
+
+	write_log(_T("PCPROFILE: %u samples every %d lines, %u%% in translated code, %u dropped\n"),
+		prof_total, prof_interval, (uae_u32)((uae_u64)prof_total_jit * 100 / prof_total), samples_dropped);
+	write_log(_T("PCPROFILE: hottest addresses\n"));
+	for (int i = 0; i < (int)pcs.size() && i < PCPROFILE_TOP; i++) {
+		const auto &p = pcs[i];
+		uae_u32 cnt = p.second.interp + p.second.jit;
+		write_log(_T("%6.2f%% %08x %8u (JIT %8u) %s\n"),
+			cnt * 100.0 / prof_total, p.first, cnt, p.second.jit, names[p.first].c_str());
+	}
+	std::vector<std::pair<std::string, uae_u32>> segv(segs.begin(), segs.end());
+	std::sort(segv.begin(), segv.end(), [](const auto &a, const auto &b) {
+		return a.second > b.second;
+	});
+	write_log(_T("PCPROFILE: by segment\n"));
+	for (const auto &s : segv)
+		write_log(_T("%6.2f%% %8u %s\n"), s.second * 100.0 / prof_total, s.second, s.first.c_str());
+
+	if (!currprefs.pcprofile_file[0])
+		return;
+	struct zfile *f = zfile_fopen(currprefs.pcprofile_file, _T("w"), 0);
+	if (!f) {
+		write_log(_T("PCPROFILE: can't create '%s'\n"), currprefs.pcprofile_file);
+		return;
+	}
+	for (const auto &st : *prof_stacks) {
+		std::string line;
+		for (uaecptr pc : st.first) {
+			auto it = names.find(pc);
+			std::string n = it != names.end() ? it->second : pcprofile_symbol(pc, NULL);
+			// frame separator and count delimiter must not appear in names
+			std::replace(n.begin(), n.end(), ';', ':');
+			std::replace(n.begin(), n.end(), ' ', '_');
+			if (!line.empty())
+				line += ';';
+			line += n;
+		}
+		TCHAR cnt[32];
+		_stprintf(cnt, _T(" %u\n"), st.second);
+		line += cnt;
+		zfile_fwrite(line.c_str(), line.size(), 1, f);
+	}
+	zfile_fclose(f);
+	write_log(_T("PCPROFILE: folded stacks written to '%s'\n"), currprefs.pcprofile_file);
+}
+
+static void pcprofile_free(void)
+{
+	if (!ring)
+		return;
+	prof_quit = 1;
+	uae_sem_post(&prof_sem);
+	uae_wait_thread(&prof_tid);
+	prof_tid = 0;
+	uae_sem_destroy(&prof_sem);
+	pcprofile_report();
+	delete prof_pcs;
+	delete prof_stacks;
+	prof_pcs = NULL;
+	prof_stacks = NULL;
+	xfree(ring);
+	ring = NULL;
+}
+
+void pcprofile_install(void)
+{
+	pcprofile_free();
+	if (currprefs.pcprofile_interval <= 0)
+		return;
+	ring = xcalloc(struct pcsample, PCPROFILE_RING);
+	ring_head = ring_tail = 0;
+	samples_dropped = 0;
+	prof_total = prof_total_jit = 0;
+	prof_pcs = new std::unordered_map<uaecptr, struct pccount>();
+	prof_stacks = new std::map<std::vector<uaecptr>, uae_u32>();
+	prof_interval = prof_counter = currprefs.pcprofile_interval;
+	prof_quit = 0;
+	uae_sem_init(&prof_sem, 0, 0);
+	if (!uae_start_thread(_T("pcprofile"), pcprofile_thread, NULL, &prof_tid)) {
+		write_log(_T("PCPROFILE: failed to start thread\n"));
+		uae_sem_destroy(&prof_sem);
+		delete prof_pcs;
+		delete prof_stacks;
+		prof_pcs = NULL;
+		prof_stacks = NULL;
+		xfree(ring);
+		ring = NULL;
+		return;
+	}
+	device_add_hsync(pcprofile_hsync);
+	device_add_exit(pcprofile_free, NULL);
+	write_log(_T("PCPROFILE: sampling every %d lines\n"), prof_interval);
+}
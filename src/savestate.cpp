@@ -68,9 +68,11 @@
 #include "devices.h"
 #include "fsdb.h"
 #include "gfxboard.h"
+#include "rommgr.h"
 
 int savestate_state = 0;
 static int savestate_first_capture;
+static bool runahead_restoring;
 
 static bool new_blitter = false;
 
@@ -385,6 +387,8 @@ TCHAR *restore_path_full_func(uae_u8 **dstp)
 
 /* read and write IFF-style hunks */
 
+#define SAVESTATE_BLOCKSIZE (1024 * 1024)
+
 static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, const TCHAR *name, int compress)
 {
 	uae_u8 tmp[8], *dst;
@@ -424,7 +428,21 @@ static void save_chunk (struct zfile *f, uae_u8 *chunk, size_t len, const TCHAR
 		save_u32t(len);
 		opos = zfile_ftell32(f);
 		zfile_fwrite(&tmp[0], 1, 4, f);
-		len = zfile_zcompress(f, chunk, len);
+		size_t packed = 0;
+		if (len > SAVESTATE_BLOCKSIZE) {
+			/* large RAM chunks are packed in blocks on several threads */
+			packed = zfile_zcompress_blocks(f, chunk, len, SAVESTATE_BLOCKSIZE);
+			if (packed > 0) {
+				zfile_fseek (f, pos + 4, SEEK_SET);
+				dst = &tmp[0];
+				save_u32(flags | compress | 2);
+				zfile_fwrite (&tmp[0], 1, 4, f);
+				zfile_fseek (f, 0, SEEK_END);
+			}
+		}
+		if (!packed)
+			packed = zfile_zcompress(f, chunk, len);
+		len = packed;
 		if (len > 0) {
 			zfile_fseek (f, pos, SEEK_SET);
 			dst = &tmp[0];
@@ -521,7 +539,9 @@ static uae_u8 *restore_chunk (struct zfile *f, TCHAR *name, unsigned int *len, u
 		mem = xcalloc (uae_u8, *totallen + 100);
 		if (!mem)
 			return NULL;
-		if (flags & 1) {
+		if (flags & 2) {
+			zfile_zuncompress_blocks (mem, *totallen, f, len2);
+		} else if (flags & 1) {
 			zfile_zuncompress (mem, *totallen, f, len2);
 		} else {
 			zfile_fread (mem, 1, len2, f);
@@ -557,7 +577,10 @@ void restore_ram (size_t filepos, uae_u8 *memory)
 		src = tmp;
 		fullsize = restore_u32 ();
 		size -= 4;
-		zfile_zuncompress (memory, fullsize, savestate_file, size);
+		if (flags & 2)
+			zfile_zuncompress_blocks (memory, fullsize, savestate_file, size);
+		else
+			zfile_zuncompress (memory, fullsize, savestate_file, size);
 	} else {
 		zfile_fread (memory, 1, size, savestate_file);
 	}
@@ -885,6 +908,7 @@ bool savestate_restore_finish(void)
 	restore_debug_memwatch_finish();
 #endif
 	savestate_state = 0;
+	runahead_restoring = false;
 	init_hz_normal();
 	audio_activate();
 	return true;
@@ -1347,6 +1371,8 @@ bool savestate_check(void)
 }
 
 static int rewindmode;
+static struct staterecord *runahead_record;
+static bool runahead_pending;
 
 
 static struct staterecord *canrewind (int pos)
@@ -1401,32 +1427,15 @@ void savestate_listrewind (void)
 }
 #endif
 
-void savestate_rewind (void)
+/* Load a record made by savestate_capture_record back into the machine */
+static bool savestate_restore_record (struct staterecord *st)
 {
 	int len, i;
 	uae_u8 *p, *p2;
-	struct staterecord *st;
-	int pos;
-	bool rewind = false;
 	size_t dummy;
 
-	if (hsync_counter % currprefs.statecapturerate <= 25 && rewindmode <= -2) {
-		pos = replaycounter - 2;
-		rewind = true;
-	} else {
-		pos = replaycounter - 1;
-	}
-	st = canrewind (pos);
-	if (!st) {
-		rewind = false;
-		pos = replaycounter - 1;
-		st = canrewind (pos);
-		if (!st)
-			return;
-	}
 	p = st->data;
 	p2 = st->end;
-	write_log (_T("rewinding %d -> %d\n"), replaycounter - 1, pos);
 	hsync_counter = restore_u32_func (&p);
 	vsync_counter = restore_u32_func (&p);
 	p = restore_cpu (p);
@@ -1513,8 +1522,41 @@ void savestate_rewind (void)
 	if (p != p2) {
 		gui_message (_T("reload failure, address mismatch %p != %p"), p, p2);
 		uae_reset (0, 0);
+		return false;
+	}
+	return true;
+}
+
+void savestate_rewind (void)
+{
+	struct staterecord *st;
+	int pos;
+	bool rewind = false;
+
+	if (runahead_pending) {
+		runahead_pending = false;
+		runahead_restoring = true;
+		if (!savestate_restore_record (runahead_record))
+			runahead_restoring = false;
 		return;
 	}
+	if (hsync_counter % currprefs.statecapturerate <= 25 && rewindmode <= -2) {
+		pos = replaycounter - 2;
+		rewind = true;
+	} else {
+		pos = replaycounter - 1;
+	}
+	st = canrewind (pos);
+	if (!st) {
+		rewind = false;
+		pos = replaycounter - 1;
+		st = canrewind (pos);
+		if (!st)
+			return;
+	}
+	write_log (_T("rewinding %d -> %d\n"), replaycounter - 1, pos);
+	if (!savestate_restore_record (st))
+		return;
 	inprec_setposition (st->inprecoffset, pos);
 	write_log (_T("state %d restored.  (%010ld/%03ld)\n"), pos, hsync_counter, vsync_counter);
 	if (rewind) {
@@ -1546,41 +1588,16 @@ void savestate_memorysave (void)
 		save_state_internal (staterecord_statefile, _T("rerecording"), 1, false);
 }
 
-void savestate_capture (int force)
+/* Serialize the machine into st, growing it when needed. Returns the
+ * (possibly reallocated) record, inuse is set only if capture succeeded. */
+static struct staterecord *savestate_capture_record (struct staterecord *st)
 {
 	uae_u8 *p, *p2, *p3, *dst;
 	size_t len, tlen;
 	int i, retrycnt;
-	struct staterecord *st;
-	bool firstcapture = false;
-
-	if (!staterecords)
-		return;
-	if (!input_record)
-		return;
-#ifdef FILESYS
-	if (nr_units())
-		return;
-#endif
-	if (currprefs.statecapturerate && hsync_counter == 0 && input_record == INPREC_RECORD_START && savestate_first_capture > 0) {
-		// first capture
-		force = true;
-		firstcapture = true;
-	} else if (savestate_first_capture < 0) {
-		force = true;
-		firstcapture = false;
-	}
-	if (!force) {
-		if (currprefs.statecapturerate <= 0)
-			return;
-		if (hsync_counter % currprefs.statecapturerate)
-			return;
-	}
-	savestate_first_capture = false;
 
 	retrycnt = 0;
 retry2:
-	st = staterecords[replaycounter];
 	if (st == NULL) {
 		st = (struct staterecord*)xmalloc (uae_u8, statefile_alloc);
 		st->len = statefile_alloc;
@@ -1593,7 +1610,6 @@ retry2:
 		statefile_alloc = st->len;
 	st->inuse = 0;
 	st->data = (uae_u8*)(st + 1);
-	staterecords[replaycounter] = st;
 	retrycnt++;
 	p = p2 = st->data;
 	tlen = 0;
@@ -1893,6 +1909,48 @@ retry2:
 	save_u32t_func(&p, tlen);
 	st->end = p;
 	st->inuse = 1;
+	return st;
+retry:
+	if (retrycnt < 10)
+		goto retry2;
+	write_log (_T("can't save, too small capture buffer or out of memory\n"));
+	return st;
+}
+
+void savestate_capture (int force)
+{
+	int i;
+	struct staterecord *st;
+	bool firstcapture = false;
+
+	if (!staterecords)
+		return;
+	if (!input_record)
+		return;
+#ifdef FILESYS
+	if (nr_units())
+		return;
+#endif
+	if (currprefs.statecapturerate && hsync_counter == 0 && input_record == INPREC_RECORD_START && savestate_first_capture > 0) {
+		// first capture
+		force = true;
+		firstcapture = true;
+	} else if (savestate_first_capture < 0) {
+		force = true;
+		firstcapture = false;
+	}
+	if (!force) {
+		if (currprefs.statecapturerate <= 0)
+			return;
+		if (hsync_counter % currprefs.statecapturerate)
+			return;
+	}
+	savestate_first_capture = false;
+
+	st = savestate_capture_record (staterecords[replaycounter]);
+	staterecords[replaycounter] = st;
+	if (!st || !st->inuse)
+		return;
 	st->inprecoffset = inprec_getposition ();
 
 	replaycounter++;
@@ -1919,20 +1977,92 @@ retry2:
 		}
 		input_record--;
 	}
+}
+
+/* Run-ahead keeps a single record that is captured after every real
+ * frame and restored once the frames run ahead have been shown. It is
+ * allocated once for the configured RAM sizes and reused, so steady
+ * state capture and restore do not allocate. */
+bool savestate_runahead_possible (void)
+{
+	if (input_record || input_play)
+		return false;
+	if (currprefs.mountitems)
+		return false;
+#ifdef FILESYS
+	if (nr_units())
+		return false;
+#endif
+	// only chip, slow and the first Zorro fast RAM boards are part of the record
+	if (currprefs.fastmem[1].size || currprefs.z3fastmem[1].size)
+		return false;
+	if (currprefs.mbresmem_low.size || currprefs.mbresmem_high.size)
+		return false;
+	if (currprefs.cpuboardmem1.size || currprefs.cpuboardmem2.size)
+		return false;
+	if (currprefs.z3chipmem.size)
+		return false;
+	if (currprefs.rtgboards[0].rtgmem_size)
+		return false;
+	// devices that talk to the host would repeat their I/O in every hidden frame
+	if (currprefs.socket_emu || currprefs.uaeserial)
+		return false;
+	if (currprefs.prtname[0] || currprefs.samplersoundcard >= 0)
+		return false;
+	for (int i = 0; expansionroms[i].name; i++) {
+		if (!(expansionroms[i].deviceflags & EXPANSIONTYPE_NET))
+			continue;
+		for (int j = 0; j < MAX_DUPLICATE_EXPANSION_BOARDS; j++) {
+			if (is_board_enabled (&currprefs, expansionroms[i].romtype, j))
+				return false;
+		}
+	}
+	if (currprefs.cachesize)
+		return false;
+	// cycles per frame follow host timing in fastest possible mode
+	if (currprefs.m68k_speed < 0)
+		return false;
+	return true;
+}
 
+bool savestate_runahead_capture (void)
+{
+	int size = sizeof (struct staterecord) + STATEFILE_ALLOC_SIZE + currprefs.chipmem.size + currprefs.bogomem.size +
+		currprefs.fastmem[0].size + currprefs.z3fastmem[0].size;
+	if (!runahead_record || runahead_record->len < size) {
+		xfree (runahead_record);
+		runahead_record = (struct staterecord*)xmalloc (uae_u8, size);
+		if (!runahead_record)
+			return false;
+		runahead_record->len = size;
+	}
+	runahead_record = savestate_capture_record (runahead_record);
+	return runahead_record && runahead_record->inuse;
+}
 
-	return;
-retry:
-	if (retrycnt < 10)
-		goto retry2;
-	write_log (_T("can't save, too small capture buffer or out of memory\n"));
-	return;
+bool savestate_runahead_rewind (void)
+{
+	if (!runahead_record || !runahead_record->inuse || savestate_state)
+		return false;
+	runahead_pending = true;
+	savestate_state = STATE_DOREWIND;
+	return true;
+}
+
+/* True while a run-ahead rollback goes through the m68k_go reset path.
+ * Host side output such as the sound buffers must be left alone. */
+bool savestate_runahead_restoring (void)
+{
+	return runahead_restoring;
 }
 
 void savestate_free (void)
 {
 	xfree (staterecords);
 	staterecords = NULL;
+	xfree (runahead_record);
+	runahead_record = NULL;
+	runahead_pending = false;
 }
 
 void savestate_capture_request (void)
@@ -1993,6 +2123,7 @@ hunk size (including header)
 hunk flags
 
 bit 0 = chunk contents are compressed with zlib (maybe RAM chunks only?)
+bit 1 = compressed contents are split in independently compressed blocks
 
 HEADER
 
@@ -2211,7 +2342,7 @@ RAM SPACE
 start address           4 ("bank"=chip/slow/fast etc..)
 of RAM "bank"
 RAM "bank" size         4
-RAM flags               4 (bit 0 = zlib compressed)
+RAM flags               4 (bit 0 = zlib compressed, bit 1 = zlib blocks)
 RAM "bank" contents
 
 ROM SPACE
@@ -15,6 +15,7 @@
 #include "zfile.h"
 #include "gui.h"
 #include "uae.h"
+#include "threaddep/thread.h"
 //#include "uae/endian.h"
 
 #include <stdint.h>
@@ -37,6 +38,11 @@
 
 #define MAX_REVS 5
 
+/* Background decoding of whole images. Revolutions longer than the MFM
+ * buffer in disk.cpp are left to the on-demand decoder. */
+#define SCP_CACHE_MAXBITS (0x8000 * 16)
+#define SCP_CACHE_MEMORY (96 * 1024 * 1024)
+
 enum pll_mode {
     PLL_fixed_clock, /* Fixed clock, snap phase to flux transitions. */
     PLL_variable_clock, /* Variable clock, snap phase to flux transitions. */
@@ -73,9 +79,41 @@ struct scpdrive {
     int flux;                /* Nanoseconds to next flux reversal */
     int clock, clock_centre; /* Clock base value in nanoseconds */
     unsigned int clocked_zeros;
+
+    /* dat[] belongs to the track cache. */
+    bool dat_shared;
+
+    /* Track currently served from the cache and its next revolution. */
+    struct scpcache *cache;
+    struct scptrack *cached;
+    unsigned int cached_rev;
 };
 static struct scpdrive drive[4];
 
+struct scprev {
+    uae_u16 *mfm;
+    uae_u16 *timing;
+    int tracklength;
+};
+
+struct scptrack {
+    int ready;               /* 0 = pending, 1 = decoded, -1 = not cached */
+    uint16_t *dat;
+    struct scprev rev[MAX_REVS];
+    struct scpdrive resume;  /* decoder state after the cached revolutions */
+};
+
+struct scpcache {
+    struct zfile *zf;
+    unsigned int revs;
+    int num_tracks;
+    struct scptrack *tracks;
+    uae_sem_t sem;
+    uae_thread_id tid;
+    volatile bool abort;
+    size_t memory;
+};
+
 #define CLOCK_CENTRE  2000   /* 2000ns = 2us */
 #define CLOCK_MAX_ADJ 10     /* +/- 10% adjustment */
 #define CLOCK_MIN(_c) (((_c) * (100 - CLOCK_MAX_ADJ)) / 100)
@@ -83,6 +121,9 @@ static struct scpdrive drive[4];
 
 #define SCK_NS_PER_TICK (25u)
 
+static void scp_cache_start(struct scpdrive *d, int num_tracks);
+static void scp_cache_stop(struct scpdrive *d);
+
 int scp_open(struct zfile *zf, int drv, int *num_tracks)
 {
     struct scpdrive *d = &drive[drv];
@@ -112,6 +153,8 @@ int scp_open(struct zfile *zf, int drv, int *num_tracks)
     d->revs = min((int)header[5], MAX_REVS);
 	*num_tracks = header[7] + 1;
 
+    scp_cache_start(d, *num_tracks);
+
     return 1;
 }
 
@@ -120,38 +163,41 @@ void scp_close(int drv)
     struct scpdrive *d = &drive[drv];
     if (!d->revs)
         return;
-    xfree(d->dat);
+    scp_cache_stop(d);
+    if (!d->dat_shared)
+        xfree(d->dat);
     memset(d, 0, sizeof(*d));
 }
 
-int scp_loadtrack(
-    uae_u16 *mfmbuf, uae_u16 *tracktiming, int drv,
-    int track, int *tracklength, int *multirev,
-    int *gapoffset, int *nextrev, bool setrev)
+static void scp_freedat(struct scpdrive *d)
+{
+    if (!d->dat_shared)
+        xfree(d->dat);
+    d->dat = NULL;
+    d->dat_shared = false;
+    d->cached = NULL;
+}
+
+/* Read the raw flux of a track and reset the decoder to its start. */
+static int scp_readtrack(struct scpdrive *d, struct zfile *zf, int track)
 {
-    struct scpdrive *d = &drive[drv];
     uint8_t trk_header[4];
     uint32_t longwords[3];
     unsigned int rev, trkoffset[MAX_REVS];
     uint32_t hdr_offset, tdh_offset;
 
-    *multirev = 1;
-    *gapoffset = -1;
-
-    xfree(d->dat);
-    d->dat = NULL;
     d->datsz = 0;
     
     hdr_offset = 0x10 + track*sizeof(uint32_t);
 
-    zfile_fseek(d->zf, hdr_offset, SEEK_SET);
+    zfile_fseek(zf, hdr_offset, SEEK_SET);
 
-    zfile_fread(longwords, sizeof(uint32_t), 1, d->zf);
+    zfile_fread(longwords, sizeof(uint32_t), 1, zf);
     tdh_offset = le32toh(longwords[0]);
 
-    zfile_fseek(d->zf, tdh_offset, SEEK_SET);
+    zfile_fseek(zf, tdh_offset, SEEK_SET);
 
-    zfile_fread(trk_header, sizeof(trk_header), 1, d->zf);
+    zfile_fread(trk_header, sizeof(trk_header), 1, zf);
     if (memcmp(trk_header, "TRK", 3) != 0)
         return 0;
 
@@ -160,7 +206,7 @@ int scp_loadtrack(
 
     d->total_ticks = 0;
     for (rev = 0 ; rev < d->revs ; rev++) {
-        zfile_fread(longwords, sizeof(longwords), 1, d->zf);
+        zfile_fread(longwords, sizeof(longwords), 1, zf);
         trkoffset[rev] = tdh_offset + le32toh(longwords[2]);
         d->index_off[rev] = le32toh(longwords[1]);
         d->total_ticks += le32toh(longwords[0]);
@@ -171,10 +217,10 @@ int scp_loadtrack(
     d->datsz = 0;
 
     for (rev = 0 ; rev < d->revs ; rev++) {
-        zfile_fseek(d->zf, trkoffset[rev], SEEK_SET);
+        zfile_fseek(zf, trkoffset[rev], SEEK_SET);
         zfile_fread(&d->dat[d->datsz],
                     d->index_off[rev] * sizeof(d->dat[0]), 1,
-                    d->zf);
+                    zf);
         d->datsz += d->index_off[rev];
         d->index_off[rev] = d->datsz;
     }
@@ -188,6 +234,44 @@ int scp_loadtrack(
     d->flux = 0;
     d->clocked_zeros = 0;
     d->acc_ticks = 0;
+    return 1;
+}
+
+static struct scptrack *scp_cache_get(struct scpdrive *d, int track)
+{
+    struct scpcache *c = d->cache;
+    struct scptrack *t = NULL;
+
+    if (!c || track < 0 || track >= c->num_tracks)
+        return NULL;
+    uae_sem_wait(&c->sem);
+    if (c->tracks[track].ready > 0)
+        t = &c->tracks[track];
+    uae_sem_post(&c->sem);
+    return t;
+}
+
+int scp_loadtrack(
+    uae_u16 *mfmbuf, uae_u16 *tracktiming, int drv,
+    int track, int *tracklength, int *multirev,
+    int *gapoffset, int *nextrev, bool setrev)
+{
+    struct scpdrive *d = &drive[drv];
+    struct scptrack *t;
+
+    *multirev = 1;
+    *gapoffset = -1;
+
+    scp_freedat(d);
+
+    t = scp_cache_get(d, track);
+    if (t) {
+        d->track = track;
+        d->cached = t;
+        d->cached_rev = 0;
+    } else if (!scp_readtrack(d, d->zf, track)) {
+        return 0;
+    }
 
     scp_loadrevolution(mfmbuf, drv, tracktiming, tracklength);
     return 1;
@@ -274,11 +358,11 @@ static int flux_next_bit(struct scpdrive *d)
     return 1;
 }
 
-void scp_loadrevolution(
-    uae_u16 *mfmbuf, int drv, uae_u16 *tracktiming,
-    int *tracklength)
+/* Decode the next revolution. Returns 0 if it did not fit in maxbits. */
+static int scp_decode_revolution(
+    struct scpdrive *d, uae_u16 *mfmbuf, uae_u16 *tracktiming,
+    int *tracklength, unsigned int maxbits)
 {
-    struct scpdrive *d = &drive[drv];
     uint64_t prev_latency;
     uint32_t av_latency;
     unsigned int i, j;
@@ -286,6 +370,8 @@ void scp_loadrevolution(
 
     d->latency = prev_latency = 0;
     for (i = 0; (b = flux_next_bit(d)) != -1; i++) {
+        if (i >= maxbits)
+            return 0;
         if ((i & 15) == 0)
             mfmbuf[i>>4] = 0;
         if (b)
@@ -299,9 +385,151 @@ void scp_loadrevolution(
     if (i & 7)
         tracktiming[i>>3] = (uae_u16)(((d->latency - prev_latency) * 8) / (i & 7));
 
-    av_latency = (uint32_t)(prev_latency / (i>>3));
-    for (j = 0; j < (i+7)>>3; j++)
-        tracktiming[j] = ((uint32_t)tracktiming[j] * 1000u) / av_latency;
+    if (i >> 3) {
+        av_latency = (uint32_t)(prev_latency / (i>>3));
+        for (j = 0; j < (i+7)>>3; j++)
+            tracktiming[j] = ((uint32_t)tracktiming[j] * 1000u) / av_latency;
+    }
 
     *tracklength = i;
+    return 1;
+}
+
+void scp_loadrevolution(
+    uae_u16 *mfmbuf, int drv, uae_u16 *tracktiming,
+    int *tracklength)
+{
+    struct scpdrive *d = &drive[drv];
+    struct scptrack *t = d->cached;
+
+    if (t) {
+        if (d->cached_rev < d->revs) {
+            struct scprev *r = &t->rev[d->cached_rev++];
+            memcpy(mfmbuf, r->mfm, ((r->tracklength + 15) >> 4) * sizeof(uae_u16));
+            memcpy(tracktiming, r->timing, ((r->tracklength + 7) >> 3) * sizeof(uae_u16));
+            *tracklength = r->tracklength;
+            return;
+        }
+        /* All cached revolutions used, continue decoding from where the
+         * background decoder stopped. */
+        struct zfile *zf = d->zf;
+        struct scpcache *c = d->cache;
+        *d = t->resume;
+        d->zf = zf;
+        d->cache = c;
+        d->cached = NULL;
+        d->dat_shared = true;
+    }
+
+    scp_decode_revolution(d, mfmbuf, tracktiming, tracklength, UINT_MAX);
+}
+
+static void scp_cache_freetrack(struct scptrack *t)
+{
+    xfree(t->dat);
+    for (int rev = 0; rev < MAX_REVS; rev++) {
+        xfree(t->rev[rev].mfm);
+        xfree(t->rev[rev].timing);
+    }
+    memset(t, 0, sizeof(*t));
+}
+
+/* Decode all revolutions of every track, in the same order and with the
+ * same decoder state as on-demand loading would, so the output matches. */
+static int scp_cache_thread(void *v)
+{
+    struct scpcache *c = (struct scpcache*)v;
+    uae_u16 *mfm = xmalloc(uae_u16, SCP_CACHE_MAXBITS / 16 + 1);
+    uae_u16 *timing = xmalloc(uae_u16, SCP_CACHE_MAXBITS / 8 + 1);
+    int decoded = 0;
+
+    for (int track = 0; track < c->num_tracks && !c->abort; track++) {
+        struct scptrack t = { 0 };
+        struct scpdrive w = { 0 };
+        bool ok = mfm && timing && c->memory < SCP_CACHE_MEMORY;
+
+        w.revs = c->revs;
+        if (ok) {
+            ok = scp_readtrack(&w, c->zf, track) != 0;
+            t.dat = w.dat;
+            c->memory += w.datsz * sizeof(w.dat[0]);
+        }
+        for (unsigned int rev = 0; ok && rev < c->revs && !c->abort; rev++) {
+            struct scprev *r = &t.rev[rev];
+            if (!scp_decode_revolution(&w, mfm, timing, &r->tracklength, SCP_CACHE_MAXBITS)) {
+                ok = false;
+                break;
+            }
+            int words = (r->tracklength + 15) >> 4;
+            int timings = (r->tracklength + 7) >> 3;
+            r->mfm = xmalloc(uae_u16, words);
+            r->timing = xmalloc(uae_u16, timings);
+            memcpy(r->mfm, mfm, words * sizeof(uae_u16));
+            memcpy(r->timing, timing, timings * sizeof(uae_u16));
+            c->memory += (words + timings) * sizeof(uae_u16);
+        }
+        if (c->abort)
+            ok = false;
+        if (ok) {
+            t.resume = w;
+            t.resume.cached = NULL;
+            t.ready = 1;
+            decoded++;
+        } else {
+            scp_cache_freetrack(&t);
+            t.ready = -1;
+        }
+        uae_sem_wait(&c->sem);
+        c->tracks[track] = t;
+        uae_sem_post(&c->sem);
+    }
+    xfree(mfm);
+    xfree(timing);
+    write_log(_T("SCP: %d/%d tracks pre-decoded, %uk\n"), decoded, c->num_tracks, (unsigned int)(c->memory / 1024));
+    return 0;
+}
+
+static void scp_cache_start(struct scpdrive *d, int num_tracks)
+{
+    struct scpcache *c;
+    struct zfile *zf;
+
+    zf = zfile_dup(d->zf);
+    if (!zf)
+        return;
+    c = xcalloc(struct scpcache, 1);
+    c->zf = zf;
+    c->revs = d->revs;
+    c->num_tracks = num_tracks;
+    c->tracks = xcalloc(struct scptrack, num_tracks);
+    uae_sem_init(&c->sem, 0, 1);
+    if (!uae_start_thread(_T("scp_decode"), scp_cache_thread, c, &c->tid)) {
+        uae_sem_destroy(&c->sem);
+        xfree(c->tracks);
+        xfree(c);
+        zfile_fclose(zf);
+        return;
+    }
+    d->cache = c;
+}
+
+static void scp_cache_stop(struct scpdrive *d)
+{
+    struct scpcache *c = d->cache;
+
+    if (!c)
+        return;
+    c->abort = true;
+    uae_wait_thread(&c->tid);
+    for (int track = 0; track < c->num_tracks; track++)
+        scp_cache_freetrack(&c->tracks[track]);
+    uae_sem_destroy(&c->sem);
+    xfree(c->tracks);
+    zfile_fclose(c->zf);
+    xfree(c);
+    if (d->dat_shared)
+        d->dat = NULL;
+    d->dat_shared = false;
+    d->cached = NULL;
+    d->cache = NULL;
 }
@@ -174,8 +174,14 @@ static uae_u32 REGPARAM2 dev_close_2(TrapContext *ctx)
 	if (!dev)
 		return 0;
 	dev_close_3 (dev, pdev);
-	trap_put_long(ctx, request + 24, 0);
-	trap_put_word(ctx, trap_get_areg(ctx, 6) + 32, trap_get_word(ctx, trap_get_areg(ctx, 6) + 32) - 1);
+	uaecptr base = trap_get_areg(ctx, 6);
+	struct trap_batch tb;
+	uae_u16 opencnt;
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_long(&tb, request + 24, 0);
+	trap_batch_get_word(&tb, &opencnt, base + 32);
+	trap_batch_run(&tb);
+	trap_put_word(ctx, base + 32, opencnt - 1);
 	return 0;
 }
 
@@ -190,8 +196,11 @@ static uae_u32 REGPARAM2 diskdev_close(TrapContext *context)
 
 static int openfail(TrapContext *ctx, uaecptr ioreq, int error)
 {
-	trap_put_long(ctx, ioreq + 20, -1);
-	trap_put_byte(ctx, ioreq + 31, error);
+	struct trap_batch tb;
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_long(&tb, ioreq + 20, -1);
+	trap_batch_put_byte(&tb, ioreq + 31, error);
+	trap_batch_run(&tb);
 	return (uae_u32)-1;
 }
 
@@ -228,7 +237,6 @@ static uae_u32 REGPARAM2 dev_open_2(TrapContext *ctx, int type)
 		pdev->unit = unit;
 		pdev->flags = flags;
 		pdev->inuse = 1;
-		trap_put_longt(ctx, ioreq + 24, pdev - pdevst);
 		start_thread (dev);
 	} else {
 		for (i = 0; i < MAX_OPEN_DEVICES; i++) {
@@ -237,13 +245,19 @@ static uae_u32 REGPARAM2 dev_open_2(TrapContext *ctx, int type)
 		}
 		if (i == MAX_OPEN_DEVICES)
 			return openfail(ctx, ioreq, IOERR_OPENFAIL);
-		trap_put_longt(ctx, ioreq + 24, pdev - pdevst);
 	}
 	dev->opencnt++;
 
-	trap_put_word(ctx, trap_get_areg(ctx, 6) + 32, trap_get_word(ctx, trap_get_areg(ctx, 6) + 32) + 1);
-	trap_put_byte(ctx, ioreq + 31, 0);
-	trap_put_byte(ctx, ioreq + 8, 7);
+	uaecptr base = trap_get_areg(ctx, 6);
+	struct trap_batch tb;
+	uae_u16 opencnt;
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_long(&tb, ioreq + 24, (uae_u32)(pdev - pdevst));
+	trap_batch_put_byte(&tb, ioreq + 31, 0);
+	trap_batch_put_byte(&tb, ioreq + 8, 7);
+	trap_batch_get_word(&tb, &opencnt, base + 32);
+	trap_batch_run(&tb);
+	trap_put_word(ctx, base + 32, opencnt + 1);
 	return 0;
 }
 
@@ -493,7 +507,7 @@ static int command_cd_read(TrapContext *ctx, struct devstruct *dev, uaecptr data
 			if (!sys_command_cd_rawread (dev->unitnum, temp, sector, 1, blocksize))
 				return 20;
 		} else {
-			if (!sys_command_cd_read (dev->unitnum, temp, sector, 1))
+			if (!sys_command_cd_read_cached (dev->unitnum, temp, sector, 1))
 				return 20;
 		}
 		if (startoffset > 0) {
@@ -796,32 +810,36 @@ static int dev_do_io_cd (TrapContext *ctx, struct devstruct *dev, uae_u8 *iobuf,
 		int msf = command == CD_TOCMSF;
 		struct cd_toc_head toc;
 		if (sys_command_cd_toc (dev->di.unitnum, &toc)) {
+			/* build the 6 byte CDTOC entries here, then copy them in one go */
+			uae_u8 tocdata[(1 + MAX_TOC_ENTRIES) * 6];
+			uae_u8 *p = tocdata;
 			if (io_offset == 0 && io_length > 0) {
 				int pos = toc.lastaddress;
-				trap_put_byte(ctx, io_data, toc.first_track);
-				trap_put_byte(ctx, io_data + 1, toc.last_track);
+				put_byte_host(p + 0, toc.first_track);
+				put_byte_host(p + 1, toc.last_track);
 				if (msf)
 					pos = lsn2msf (pos);
-				trap_put_long(ctx, io_data + 2, pos);
+				put_long_host(p + 2, pos);
 				io_offset++;
 				io_length--;
-				io_data += 6;
+				p += 6;
 				io_actual++;
 			}
 			for (int i = toc.first_track_offset; i < toc.last_track_offset && io_length > 0; i++) {
 				if (io_offset == toc.toc[i].point) {
 					int pos = toc.toc[i].paddress;
-					trap_put_byte(ctx, io_data, (toc.toc[i].control << 4) | toc.toc[i].adr);
-					trap_put_byte(ctx, io_data + 1, toc.toc[i].point);
+					put_byte_host(p + 0, (toc.toc[i].control << 4) | toc.toc[i].adr);
+					put_byte_host(p + 1, toc.toc[i].point);
 					if (msf)
 						pos = lsn2msf (pos);
-					trap_put_long(ctx, io_data + 2, pos);
+					put_long_host(p + 2, pos);
 					io_offset++;
 					io_length--;
-					io_data += 6;
+					p += 6;
 					io_actual++;
 				}
 			}
+			trap_put_bytes(ctx, tocdata, io_data, addrdiff(p, tocdata));
 		} else {
 			io_error = IOERR_NotSpecified;
 		}
@@ -888,9 +906,15 @@ static int dev_do_io_cd (TrapContext *ctx, struct devstruct *dev, uae_u8 *iobuf,
 	break;
 	case CD_CONFIG:
 	{
-		while (trap_get_long(ctx, io_data) != TAG_DONE) {
-			uae_u32 tag = trap_get_long(ctx, io_data);
-			uae_u32 data = trap_get_long(ctx, io_data + 4);
+		for (;;) {
+			struct trap_batch tb;
+			uae_u32 tag, data;
+			trap_batch_init(ctx, &tb);
+			trap_batch_get_long(&tb, &tag, io_data);
+			trap_batch_get_long(&tb, &data, io_data + 4);
+			trap_batch_run(&tb);
+			if (tag == TAG_DONE)
+				break;
 			if (tag == 4) {
 				// TAGCD_SECTORSIZE
 				if (data == 2048 || data == 2336 || data == 2352)
@@ -984,13 +1008,17 @@ static int dev_do_io_cd (TrapContext *ctx, struct devstruct *dev, uae_u8 *iobuf,
 		}
 		break;
 	case NSCMD_DEVICEQUERY:
-		trap_put_long(ctx, io_data + 0, 0);
-		trap_put_long(ctx, io_data + 4, 16); /* size */
-		trap_put_word(ctx, io_data + 8, NSDEVTYPE_TRACKDISK);
-		trap_put_word(ctx, io_data + 10, 0);
-		trap_put_long(ctx, io_data + 12, nscmd_cmd);
+	{
+		uae_u8 query[16];
+		put_long_host(query + 0, 0);
+		put_long_host(query + 4, 16); /* size */
+		put_word_host(query + 8, NSDEVTYPE_TRACKDISK);
+		put_word_host(query + 10, 0);
+		put_long_host(query + 12, nscmd_cmd);
+		trap_put_bytes(ctx, query, io_data, sizeof query);
 		io_actual = 16;
 		break;
+	}
 	default:
 		io_error = IOERR_NOCMD;
 		break;
@@ -1301,14 +1329,17 @@ static uaecptr diskdev_startup (TrapContext *ctx, uaecptr resaddr)
 	* the cd.device */
 	if (log_scsi)
 		write_log (_T("diskdev_startup(0x%x)\n"), resaddr);
-	trap_put_word(ctx, resaddr + 0x0, 0x4AFC);
-	trap_put_long(ctx, resaddr + 0x2, resaddr);
-	trap_put_long(ctx, resaddr + 0x6, resaddr + 0x1A); /* Continue scan here */
-	trap_put_word(ctx, resaddr + 0xA, 0x8101); /* RTF_AUTOINIT|RTF_COLDSTART; Version 1 */
-	trap_put_word(ctx, resaddr + 0xC, 0x0305); /* NT_DEVICE; pri 05 */
-	trap_put_long(ctx, resaddr + 0xE, ROM_diskdev_resname);
-	trap_put_long(ctx, resaddr + 0x12, ROM_diskdev_resid);
-	trap_put_long(ctx, resaddr + 0x16, ROM_diskdev_init);
+	struct trap_batch tb;
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_word(&tb, resaddr + 0x0, 0x4AFC);
+	trap_batch_put_long(&tb, resaddr + 0x2, resaddr);
+	trap_batch_put_long(&tb, resaddr + 0x6, resaddr + 0x1A); /* Continue scan here */
+	trap_batch_put_word(&tb, resaddr + 0xA, 0x8101); /* RTF_AUTOINIT|RTF_COLDSTART; Version 1 */
+	trap_batch_put_word(&tb, resaddr + 0xC, 0x0305); /* NT_DEVICE; pri 05 */
+	trap_batch_put_long(&tb, resaddr + 0xE, ROM_diskdev_resname);
+	trap_batch_put_long(&tb, resaddr + 0x12, ROM_diskdev_resid);
+	trap_batch_put_long(&tb, resaddr + 0x16, ROM_diskdev_init);
+	trap_batch_run(&tb);
 	resaddr += 0x1A;
 	return resaddr;
 }
@@ -1321,14 +1352,17 @@ uaecptr scsidev_startup(TrapContext *ctx, uaecptr resaddr)
 		write_log (_T("scsidev_startup(0x%x)\n"), resaddr);
 	/* Build a struct Resident. This will set up and initialize
 	* the uaescsi.device */
-	trap_put_word(ctx, resaddr + 0x0, 0x4AFC);
-	trap_put_long(ctx, resaddr + 0x2, resaddr);
-	trap_put_long(ctx, resaddr + 0x6, resaddr + 0x1A); /* Continue scan here */
-	trap_put_word(ctx, resaddr + 0xA, 0x8101); /* RTF_AUTOINIT|RTF_COLDSTART; Version 1 */
-	trap_put_word(ctx, resaddr + 0xC, 0x0305); /* NT_DEVICE; pri 05 */
-	trap_put_long(ctx, resaddr + 0xE, ROM_scsidev_resname);
-	trap_put_long(ctx, resaddr + 0x12, ROM_scsidev_resid);
-	trap_put_long(ctx, resaddr + 0x16, ROM_scsidev_init); /* calls scsidev_init */
+	struct trap_batch tb;
+	trap_batch_init(ctx, &tb);
+	trap_batch_put_word(&tb, resaddr + 0x0, 0x4AFC);
+	trap_batch_put_long(&tb, resaddr + 0x2, resaddr);
+	trap_batch_put_long(&tb, resaddr + 0x6, resaddr + 0x1A); /* Continue scan here */
+	trap_batch_put_word(&tb, resaddr + 0xA, 0x8101); /* RTF_AUTOINIT|RTF_COLDSTART; Version 1 */
+	trap_batch_put_word(&tb, resaddr + 0xC, 0x0305); /* NT_DEVICE; pri 05 */
+	trap_batch_put_long(&tb, resaddr + 0xE, ROM_scsidev_resname);
+	trap_batch_put_long(&tb, resaddr + 0x12, ROM_scsidev_resid);
+	trap_batch_put_long(&tb, resaddr + 0x16, ROM_scsidev_init); /* calls scsidev_init */
+	trap_batch_run(&tb);
 	resaddr += 0x1A;
 	return resaddr;
 	//return diskdev_startup(ctx, resaddr);
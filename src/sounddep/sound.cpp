@@ -59,6 +59,7 @@ static int statuscnt;
 
 uae_u16 paula_sndbuffer[SND_MAX_BUFFER];
 uae_u16* paula_sndbufpt;
+static uae_u16* runahead_sndbufpt = paula_sndbuffer;
 int paula_sndbufsize;
 int active_sound_stereo;
 
@@ -725,6 +726,18 @@ static void handle_reset()
 	}
 }
 
+// Samples below this point were produced by the real frame before the
+// run-ahead capture and must survive the muted frames and the rollback.
+void sound_runahead_capture()
+{
+	runahead_sndbufpt = paula_sndbufpt;
+}
+
+void sound_runahead_rewind()
+{
+	paula_sndbufpt = runahead_sndbufpt;
+}
+
 void finish_sound_buffer()
 {
 	static unsigned long tframe;
@@ -740,6 +753,11 @@ void finish_sound_buffer()
 		paula_sndbufpt = paula_sndbuffer;
 		return;
 	}
+	if (runahead_muted) {
+		// keep the real frame's samples, drop the ones run ahead
+		paula_sndbufpt = runahead_sndbufpt;
+		return;
+	}
 	if (currprefs.sound_stereo_swap_paula) {
 		if (get_audio_nativechannels(active_sound_stereo) == 2 || get_audio_nativechannels(active_sound_stereo) == 4)
 			channelswap(reinterpret_cast<uae_s16*>(paula_sndbuffer), bufsize / 2);
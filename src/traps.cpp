@@ -1481,6 +1481,158 @@ void trap_multi(TrapContext *ctx, struct trapmd *data, int items)
 	}
 }
 
+#if TRAP_BATCH_ITEMS * 5 * 4 + TRAP_BATCH_DATA != RTAREA_TRAP_DATA_EXTRA_SIZE
+#error TRAP_BATCH_DATA does not match RTAREA_TRAP_DATA_EXTRA_SIZE
+#endif
+
+void trap_batch_init(TrapContext *ctx, struct trap_batch *tb)
+{
+	tb->ctx = ctx;
+	tb->indirect = trap_is_indirect_null(ctx);
+	tb->items = 0;
+	tb->datasize = 0;
+}
+
+void trap_batch_run(struct trap_batch *tb)
+{
+	TrapContext *ctx = tb->ctx;
+	if (!tb->items)
+		return;
+	uae_u8 *p = ctx->host_trap_data + RTAREA_TRAP_DATA_EXTRA;
+	uae_u8 *data = p + TRAP_BATCH_ITEMS * 5 * 4;
+	for (int i = 0; i < tb->items; i++) {
+		struct trapmd *md = &tb->md[i];
+		put_word_host(p + 0, md->cmd);
+		put_word_host(p + 2, 0);
+		put_long_host(p + 4, md->params[0]);
+		put_long_host(p + 8, md->params[1]);
+		put_long_host(p + 12, md->params[2]);
+		put_long_host(p + 16, 0);
+		p += 5 * 4;
+	}
+	memcpy(data, tb->data, tb->datasize);
+	call_hardware_trap_back(ctx, TRAPCMD_MULTI, ctx->amiga_trap_data + RTAREA_TRAP_DATA_EXTRA, tb->items, 0, 0);
+	p = ctx->host_trap_data + RTAREA_TRAP_DATA_EXTRA;
+	for (int i = 0; i < tb->items; i++, p += 5 * 4) {
+		struct trapmd *md = &tb->md[i];
+		switch (md->cmd)
+		{
+			case TRAPCMD_GET_LONG:
+			*(uae_u32*)md->haddr = get_long_host(p + 4);
+			break;
+			case TRAPCMD_GET_WORD:
+			*(uae_u16*)md->haddr = (uae_u16)get_long_host(p + 4);
+			break;
+			case TRAPCMD_GET_BYTES:
+			memcpy(md->haddr, data + tb->offset[i], md->params[2]);
+			break;
+		}
+	}
+	tb->items = 0;
+	tb->datasize = 0;
+}
+
+static struct trapmd *trap_batch_add(struct trap_batch *tb, uae_u16 cmd, int datasize)
+{
+	if (tb->items >= TRAP_BATCH_ITEMS || tb->datasize + datasize > TRAP_BATCH_DATA)
+		trap_batch_run(tb);
+	int i = tb->items++;
+	struct trapmd *md = &tb->md[i];
+	md->cmd = cmd;
+	md->haddr = NULL;
+	tb->offset[i] = tb->datasize;
+	if (datasize) {
+		md->params[0] = md->params[1] = tb->ctx->amiga_trap_data + RTAREA_TRAP_DATA_EXTRA + TRAP_BATCH_ITEMS * 5 * 4 + tb->datasize;
+		tb->datasize += (datasize + 3) & ~3;
+	}
+	return md;
+}
+
+void trap_batch_put_long(struct trap_batch *tb, uaecptr addr, uae_u32 v)
+{
+	if (!tb->indirect) {
+		trap_put_long(tb->ctx, addr, v);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_PUT_LONG, 0);
+	md->params[0] = addr;
+	md->params[1] = v;
+}
+
+void trap_batch_put_word(struct trap_batch *tb, uaecptr addr, uae_u16 v)
+{
+	if (!tb->indirect) {
+		trap_put_word(tb->ctx, addr, v);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_PUT_WORD, 0);
+	md->params[0] = addr;
+	md->params[1] = v;
+}
+
+void trap_batch_put_byte(struct trap_batch *tb, uaecptr addr, uae_u8 v)
+{
+	if (!tb->indirect) {
+		trap_put_byte(tb->ctx, addr, v);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_PUT_BYTE, 0);
+	md->params[0] = addr;
+	md->params[1] = v;
+}
+
+void trap_batch_put_bytes(struct trap_batch *tb, const void *haddr, uaecptr addr, int cnt)
+{
+	if (cnt <= 0)
+		return;
+	if (!tb->indirect || cnt > TRAP_BATCH_DATA) {
+		trap_batch_run(tb);
+		trap_put_bytes(tb->ctx, haddr, addr, cnt);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_PUT_BYTES, cnt);
+	memcpy(tb->data + tb->offset[tb->items - 1], haddr, cnt);
+	md->params[1] = addr;
+	md->params[2] = cnt;
+}
+
+void trap_batch_get_long(struct trap_batch *tb, uae_u32 *haddr, uaecptr addr)
+{
+	if (!tb->indirect) {
+		*haddr = trap_get_long(tb->ctx, addr);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_GET_LONG, 0);
+	md->params[0] = addr;
+	md->haddr = (uae_u8*)haddr;
+}
+
+void trap_batch_get_word(struct trap_batch *tb, uae_u16 *haddr, uaecptr addr)
+{
+	if (!tb->indirect) {
+		*haddr = trap_get_word(tb->ctx, addr);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_GET_WORD, 0);
+	md->params[0] = addr;
+	md->haddr = (uae_u8*)haddr;
+}
+
+void trap_batch_get_bytes(struct trap_batch *tb, void *haddr, uaecptr addr, int cnt)
+{
+	if (cnt <= 0)
+		return;
+	if (!tb->indirect || cnt > TRAP_BATCH_DATA) {
+		trap_batch_run(tb);
+		trap_get_bytes(tb->ctx, haddr, addr, cnt);
+		return;
+	}
+	struct trapmd *md = trap_batch_add(tb, TRAPCMD_GET_BYTES, cnt);
+	md->params[0] = addr;
+	md->params[2] = cnt;
+	md->haddr = (uae_u8*)haddr;
+}
+
 void trap_memcpyha_safe(TrapContext *ctx, uaecptr dst, const uae_u8 *src, int size)
 {
 	if (size <= 0)
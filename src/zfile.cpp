@@ -24,6 +24,7 @@
 #include "diskutil.h"
 #include "fdi2raw.h"
 #include "uae.h"
+#include "threaddep/thread.h"
 // OS X does not have off64_t, fopen64, fseeko64 or ftello64, the functions are already 64bit
 #ifdef __MACH__
 #  define off64_t off_t
@@ -37,6 +38,8 @@
 #include "archivers/wrp/warp.h"
 
 static struct zfile *zlist = 0;
+/* guards zlist once archive prefetch threads create and close zfiles */
+static uae_sem_t zlist_sem;
 
 const TCHAR *uae_archive_extensions[] = { _T("zip"), _T("rar"), _T("7z"), _T("lha"), _T("lzh"), _T("lzx"), _T("tar"), NULL };
 
@@ -186,8 +189,10 @@ static struct zfile *zfile_create (struct zfile *prev, const TCHAR *originalname
 	if (!z)
 		return 0;
 	memset (z, 0, sizeof *z);
+	uae_sem_wait (&zlist_sem);
 	z->next = zlist;
 	zlist = z;
+	uae_sem_post (&zlist_sem);
 	z->opencnt = 1;
 	if (prev && prev->originalname)
 		z->originalname = my_strdup(prev->originalname);
@@ -215,9 +220,19 @@ static void zfile_free (struct zfile *f)
 	xfree (f);
 }
 
+static void zfile_prefetch_exit (void);
+
+/* zlist is shared with the archive prefetch threads, must run before any zfile is opened */
+void zfile_init (void)
+{
+	if (!zlist_sem)
+		uae_sem_init (&zlist_sem, 0, 1);
+}
+
 void zfile_exit (void)
 {
 	struct zfile *l;
+	zfile_prefetch_exit ();
 	while ((l = zlist)) {
 		zlist = l->next;
 		zfile_free (l);
@@ -248,9 +263,11 @@ void zfile_fclose (struct zfile *f)
 	}
 	struct zfile *pl = NULL;
 	struct zfile *nxt;
+	uae_sem_wait (&zlist_sem);
 	struct zfile *l  = zlist;
 	while (l != f) {
 		if (l == 0) {
+			uae_sem_post (&zlist_sem);
 			write_log (_T("zfile: tried to free already freed or nonexisting filehandle!\n"));
 			return;
 		}
@@ -259,13 +276,14 @@ void zfile_fclose (struct zfile *f)
 	}
 	if (l)
 		nxt = l->next;
+	if (l) {
+		if(!pl)
+			zlist = nxt;
+		else
+			pl->next = nxt;
+	}
+	uae_sem_post (&zlist_sem);
 	zfile_free (f);
-	if (l == 0)
-		return;
-	if(!pl)
-		zlist = nxt;
-	else
-		pl->next = nxt;
 }
 
 static void removeext (TCHAR *s, const TCHAR *ext)
@@ -2574,6 +2592,175 @@ int zfile_zcompress(struct zfile *f, void *src, size_t size)
 	return zs.total_out;
 }
 
+/* Large buffers (savestate RAM chunks) are split into independently deflated
+ * blocks that are packed and unpacked on several threads. Layout:
+ * block size (4), block count (4), compressed size of each block (4 * count),
+ * compressed blocks.
+ */
+
+#define ZBLOCK_MAX_THREADS 4
+
+struct zblock_job
+{
+	bool compress;
+	uae_u8 *data;
+	size_t size;
+	int blocksize;
+	int blocks;
+	uae_u8 **packed;
+	uae_u32 *packedsize;
+	volatile uae_atomic next;
+	volatile uae_atomic failed;
+};
+
+static void zblock_put32 (struct zfile *f, uae_u32 v)
+{
+	uae_u8 tmp[4] = { (uae_u8)(v >> 24), (uae_u8)(v >> 16), (uae_u8)(v >> 8), (uae_u8)v };
+	zfile_fwrite (tmp, 1, 4, f);
+}
+
+static uae_u32 zblock_get32 (const uae_u8 *p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void zblock_run (struct zblock_job *j)
+{
+	for (;;) {
+		int i = atomic_inc (&j->next) - 1;
+		if (i >= j->blocks || j->failed)
+			break;
+		size_t offset = (size_t)i * j->blocksize;
+		if (offset >= j->size) {
+			atomic_inc (&j->failed);
+			break;
+		}
+		uLong len = (uLong)(j->size - offset < (size_t)j->blocksize ? j->size - offset : j->blocksize);
+		if (j->compress) {
+			uLongf outlen = compressBound (len);
+			j->packed[i] = xmalloc (uae_u8, outlen);
+			if (!j->packed[i] || compress2 (j->packed[i], &outlen, j->data + offset, len, Z_BEST_SPEED) != Z_OK) {
+				atomic_inc (&j->failed);
+				break;
+			}
+			j->packedsize[i] = (uae_u32)outlen;
+		} else {
+			uLongf outlen = len;
+			if (uncompress (j->data + offset, &outlen, j->packed[i], j->packedsize[i]) != Z_OK || outlen != len) {
+				atomic_inc (&j->failed);
+				break;
+			}
+		}
+	}
+}
+
+static int zblock_thread (void *v)
+{
+	zblock_run ((struct zblock_job*)v);
+	return 0;
+}
+
+static void zblock_dispatch (struct zblock_job *j)
+{
+	uae_thread_id tid[ZBLOCK_MAX_THREADS];
+	int threads = 0;
+	int want = j->blocks - 1;
+
+	if (want > ZBLOCK_MAX_THREADS)
+		want = ZBLOCK_MAX_THREADS;
+	while (threads < want) {
+		if (!uae_start_thread (_T("zblock"), zblock_thread, j, &tid[threads]))
+			break;
+		threads++;
+	}
+	zblock_run (j);
+	for (int i = 0; i < threads; i++)
+		uae_wait_thread (&tid[i]);
+}
+
+/* returns number of bytes written or 0 if nothing was written */
+int zfile_zcompress_blocks (struct zfile *f, void *src, size_t size, int blocksize)
+{
+	struct zblock_job j = { 0 };
+	int total = 0;
+
+	if (blocksize <= 0 || size == 0)
+		return 0;
+	j.compress = true;
+	j.data = (uae_u8*)src;
+	j.size = size;
+	j.blocksize = blocksize;
+	j.blocks = (int)((size + blocksize - 1) / blocksize);
+	j.packed = xcalloc (uae_u8*, j.blocks);
+	j.packedsize = xcalloc (uae_u32, j.blocks);
+	if (j.packed && j.packedsize) {
+		zblock_dispatch (&j);
+		if (!j.failed) {
+			total = 4 + 4 + 4 * j.blocks;
+			for (int i = 0; i < j.blocks; i++)
+				total += j.packedsize[i];
+			zblock_put32 (f, blocksize);
+			zblock_put32 (f, j.blocks);
+			for (int i = 0; i < j.blocks; i++)
+				zblock_put32 (f, j.packedsize[i]);
+			for (int i = 0; i < j.blocks; i++)
+				zfile_fwrite (j.packed[i], 1, j.packedsize[i], f);
+		}
+	}
+	if (j.packed) {
+		for (int i = 0; i < j.blocks; i++)
+			xfree (j.packed[i]);
+	}
+	xfree (j.packed);
+	xfree (j.packedsize);
+	return total;
+}
+
+int zfile_zuncompress_blocks (void *dst, int dstsize, struct zfile *src, int srcsize)
+{
+	struct zblock_job j = { 0 };
+	uae_u8 *buf, *p;
+	int ok = 0;
+
+	if (srcsize < 8)
+		return 0;
+	buf = xmalloc (uae_u8, srcsize);
+	if (!buf)
+		return 0;
+	if (zfile_fread (buf, 1, srcsize, src) != srcsize)
+		goto end;
+	j.blocksize = zblock_get32 (buf);
+	j.blocks = zblock_get32 (buf + 4);
+	if (j.blocksize <= 0 || j.blocks <= 0 || j.blocks > (srcsize - 8) / 4)
+		goto end;
+	j.data = (uae_u8*)dst;
+	j.size = dstsize;
+	/* block count must match the destination exactly */
+	if (dstsize <= 0 || (size_t)j.blocks != (j.size + j.blocksize - 1) / j.blocksize)
+		goto end;
+	j.packed = xcalloc (uae_u8*, j.blocks);
+	j.packedsize = xcalloc (uae_u32, j.blocks);
+	if (!j.packed || !j.packedsize)
+		goto end;
+	p = buf + 8 + 4 * j.blocks;
+	for (int i = 0; i < j.blocks; i++) {
+		j.packedsize[i] = zblock_get32 (buf + 8 + 4 * i);
+		if (j.packedsize[i] > (uae_u32)(buf + srcsize - p))
+			goto end;
+		j.packed[i] = p;
+		p += j.packedsize[i];
+	}
+	zblock_dispatch (&j);
+	ok = !j.failed;
+	if (!ok)
+		write_log (_T("zfile: corrupted compressed block data\n"));
+end:
+	xfree (j.packed);
+	xfree (j.packedsize);
+	xfree (buf);
+	return ok;
+}
+
 TCHAR *zfile_getname (struct zfile *f)
 {
 	return f ? f->name : NULL;
@@ -2642,34 +2829,85 @@ end:
 	_tcscat (newpath, zn->name);
 }
 
+#define ZNODE_HASH_MIN 64
+
+static uae_u32 znode_hash (struct znode *parent, const TCHAR *name, int len)
+{
+	uae_u32 h = (uae_u32)((uintptr_t)parent >> 4) * 0x9e3779b1;
+	for (int i = 0; i < len; i++)
+		h = (h ^ (uae_u32)_totlower (name[i])) * 0x01000193;
+	return h;
+}
+
+/* next child of 'parent' named 'name' (case insensitive) after 'prev', in sibling order */
+static struct znode *znode_hash_find (struct znode *parent, const TCHAR *name, int len, struct znode *prev, bool exact)
+{
+	struct zvolume *zv = parent->volume;
+	struct znode *zn;
+
+	if (prev) {
+		zn = prev->hashnext;
+	} else {
+		if (!zv->hash)
+			return NULL;
+		zn = zv->hash[znode_hash (parent, name, len) & (zv->hashsize - 1)];
+	}
+	for (; zn; zn = zn->hashnext) {
+		if (zn->parent != parent || _tcslen (zn->name) != len)
+			continue;
+		if (exact ? !_tcsncmp (zn->name, name, len) : !_tcsnicmp (zn->name, name, len))
+			return zn;
+	}
+	return NULL;
+}
+
+static void znode_hash_add (struct zvolume *zv, struct znode *zn)
+{
+	struct znode **pp = &zv->hash[znode_hash (zn->parent, zn->name, _tcslen (zn->name)) & (zv->hashsize - 1)];
+	/* keep buckets in allocation order so duplicate names resolve like a sibling scan */
+	while (*pp)
+		pp = &(*pp)->hashnext;
+	zn->hashnext = NULL;
+	*pp = zn;
+}
+
+static void znode_hash_insert (struct znode *zn)
+{
+	struct zvolume *zv = zn->volume;
+
+	zv->hashcount++;
+	if (zv->hashcount <= zv->hashsize) {
+		znode_hash_add (zv, zn);
+		return;
+	}
+	xfree (zv->hash);
+	zv->hashsize = zv->hashsize ? zv->hashsize * 4 : ZNODE_HASH_MIN;
+	zv->hash = xcalloc (struct znode*, zv->hashsize);
+	for (struct znode *zn2 = zv->root.next; zn2; zn2 = zn2->next)
+		znode_hash_add (zv, zn2);
+}
+
 static struct znode *znode_alloc (struct znode *parent, const TCHAR *name)
 {
 	TCHAR fullpath[MAX_DPATH];
 	TCHAR tmpname[MAX_DPATH];
 	struct znode *zn = xcalloc (struct znode, 1);
-	struct znode *zn2;
 
 	_tcscpy (tmpname, name);
-	zn2 = parent->child;
-	while (zn2) {
-		if (!_tcscmp (zn2->name, tmpname)) {
-			TCHAR *ext = _tcsrchr (tmpname, '.');
-			if (ext && ext > tmpname + 2 && ext[-2] == '.') {
-				ext[-1]++;
-			} else if (ext) {
-				memmove (ext + 2, ext, (_tcslen (ext) + 1) * sizeof (TCHAR));
-				ext[0] = '.';
-				ext[1] = '1';
-			} else {
-				int len = _tcslen (tmpname);
-				tmpname[len] = '.';
-				tmpname[len + 1] = '1';
-				tmpname[len + 2] = 0;
-			}
-			zn2 = parent->child;
-			continue;
+	while (znode_hash_find (parent, tmpname, _tcslen (tmpname), NULL, true)) {
+		TCHAR *ext = _tcsrchr (tmpname, '.');
+		if (ext && ext > tmpname + 2 && ext[-2] == '.') {
+			ext[-1]++;
+		} else if (ext) {
+			memmove (ext + 2, ext, (_tcslen (ext) + 1) * sizeof (TCHAR));
+			ext[0] = '.';
+			ext[1] = '1';
+		} else {
+			int len = _tcslen (tmpname);
+			tmpname[len] = '.';
+			tmpname[len + 1] = '1';
+			tmpname[len + 2] = 0;
 		}
-		zn2 = zn2->sibling;
 	}
 
 	fullpath[0] = 0;
@@ -2688,19 +2926,24 @@ static struct znode *znode_alloc (struct znode *parent, const TCHAR *name)
 	return zn;
 }
 
+static void znode_link (struct znode *parent, struct znode *zn)
+{
+	if (!parent->child)
+		parent->child = zn;
+	else
+		parent->lastchild->sibling = zn;
+	parent->lastchild = zn;
+	zn->parent = parent;
+	xfree (parent->sorted);
+	parent->sorted = NULL;
+	znode_hash_insert (zn);
+}
+
 static struct znode *znode_alloc_child (struct znode *parent, const TCHAR *name)
 {
 	struct znode *zn = znode_alloc (parent, name);
 
-	if (!parent->child) {
-		parent->child = zn;
-	} else {
-		struct znode *pn = parent->child;
-		while (pn->sibling)
-			pn = pn->sibling;
-		pn->sibling = zn;
-	}
-	zn->parent = parent;
+	znode_link (parent, zn);
 	return zn;
 }
 
@@ -2708,18 +2951,33 @@ static struct znode *znode_alloc_sibling (struct znode *sibling, const TCHAR *na
 {
 	struct znode *zn = znode_alloc (sibling->parent, name);
 
-	if (!sibling->sibling) {
-		sibling->sibling = zn;
-	} else {
-		struct znode *pn = sibling->sibling;
-		while (pn->sibling)
-			pn = pn->sibling;
-		pn->sibling = zn;
-	}
-	zn->parent = sibling->parent;
+	znode_link (sibling->parent, zn);
 	return zn;
 }
 
+static int znode_sort_name (const void *a, const void *b)
+{
+	return _tcscmp ((*(struct znode**)a)->name, (*(struct znode**)b)->name);
+}
+
+/* children of 'parent' ordered by name, cached until the next child is added */
+static struct znode **znode_sorted_children (struct znode *parent, int *cnt)
+{
+	if (!parent->sorted) {
+		int n = 0;
+		for (struct znode *zn = parent->child; zn; zn = zn->sibling)
+			n++;
+		parent->sorted = xmalloc (struct znode*, n + 1);
+		n = 0;
+		for (struct znode *zn = parent->child; zn; zn = zn->sibling)
+			parent->sorted[n++] = zn;
+		qsort (parent->sorted, n, sizeof (struct znode*), znode_sort_name);
+		parent->sortedcnt = n;
+	}
+	*cnt = parent->sortedcnt;
+	return parent->sorted;
+}
+
 static void zvolume_addtolist (struct zvolume *zv)
 {
 	if (!zv)
@@ -3003,15 +3261,33 @@ end:
 	return NULL;
 }
 
-static struct znode *get_znode (struct zvolume *zv, const TCHAR *ppath, int recurse)
+/* jump to separate tree, recursive archives */
+static struct zvolume *get_znode_vchild (struct znode *zn, int recurse)
 {
-	struct znode *zn;
-	TCHAR path[MAX_DPATH], zpath[MAX_DPATH];
+	struct zvolume *zvdeep = zn->vchild;
+	if (zvdeep->archive == NULL) {
+		TCHAR newpath[MAX_DPATH];
+		newpath[0] = 0;
+		recurparent (newpath, zn, recurse);
+#ifdef ZFILE_DEBUG
+		write_log (_T("'%s'\n"), newpath);
+#endif
+		zvdeep = prepare_recursive_volume (zvdeep, newpath, ZFD_ALL);
+		if (!zvdeep) {
+			write_log (_T("failed to unpack '%s'\n"), newpath);
+			return NULL;
+		}
+		/* replace dummy empty volume with real volume */
+		zn->vchild = zvdeep;
+		zvdeep->parentz = zn;
+	}
+	return zvdeep;
+}
+
+static struct znode *get_znode_walk (struct znode *zn, const TCHAR *path, int recurse)
+{
+	TCHAR zpath[MAX_DPATH];
 
-	if (!zv)
-		return NULL;
-	_tcscpy (path, ppath);
-	zn = &zv->root;
 	while (zn) {
 		zpath[0] = 0;
 		recurparent (zpath, zn, recurse);
@@ -3024,24 +3300,9 @@ static struct znode *get_znode (struct zvolume *zv, const TCHAR *ppath, int recu
 				if (path[len] == 0)
 					return zn;
 				if (zn->vchild) {
-					/* jump to separate tree, recursive archives */
-					struct zvolume *zvdeep = zn->vchild;
-					if (zvdeep->archive == NULL) {
-						TCHAR newpath[MAX_DPATH];
-						newpath[0] = 0;
-						recurparent (newpath, zn, recurse);
-#ifdef ZFILE_DEBUG
-						write_log (_T("'%s'\n"), newpath);
-#endif
-						zvdeep = prepare_recursive_volume (zvdeep, newpath, ZFD_ALL);
-						if (!zvdeep) {
-							write_log (_T("failed to unpack '%s'\n"), newpath);
-							return NULL;
-						}
-						/* replace dummy empty volume with real volume */
-						zn->vchild = zvdeep;
-						zvdeep->parentz = zn;
-					}
+					struct zvolume *zvdeep = get_znode_vchild (zn, recurse);
+					if (!zvdeep)
+						return NULL;
 					zn = zvdeep->root.child;
 				} else {
 					zn = zn->child;
@@ -3054,6 +3315,63 @@ static struct znode *get_znode (struct zvolume *zv, const TCHAR *ppath, int recu
 	return NULL;
 }
 
+static struct znode *get_znode (struct zvolume *zv, const TCHAR *ppath, int recurse)
+{
+	struct znode *zn;
+	TCHAR path[MAX_DPATH], zpath[MAX_DPATH];
+	int len;
+
+	if (!zv)
+		return NULL;
+	_tcscpy (path, ppath);
+	zn = &zv->root;
+	/* Hashed lookup matches one path component per level, which requires every
+	 * child path to be its parent's path plus its own name. recurparent() drops
+	 * the root name in a few corner cases, those still use the plain tree walk.
+	 */
+	if (!zv->hash || zv->parentz || zn->vchild || znode_hash_find (zn, zn->name, _tcslen (zn->name), NULL, true))
+		return get_znode_walk (zn, path, recurse);
+	zpath[0] = 0;
+	recurparent (zpath, zn, recurse);
+	len = _tcslen (zpath);
+	if (_tcslen (path) < len || (path[len] != 0 && path[len] != FSDB_DIR_SEPARATOR) || _tcsnicmp (zpath, path, len))
+		return NULL;
+	while (path[len]) {
+		const TCHAR *name = &path[len + 1];
+		struct znode *zn2, *dir = NULL;
+		int namelen = 0;
+
+		while (name[namelen] && name[namelen] != FSDB_DIR_SEPARATOR)
+			namelen++;
+		if (namelen == 0)
+			return get_znode_walk (zn->child, path, recurse);
+		for (zn2 = znode_hash_find (zn, name, namelen, NULL, false); zn2; zn2 = znode_hash_find (zn, name, namelen, zn2, false)) {
+			if (zn2->type != ZNODE_FILE) {
+				dir = zn2;
+				break;
+			}
+			if (name[namelen] == 0)
+				return zn2;
+		}
+		if (!dir)
+			return NULL;
+		len += 1 + namelen;
+		if (path[len] == 0)
+			return dir;
+		if (dir->vchild) {
+			struct zvolume *zvdeep = get_znode_vchild (dir, recurse);
+			if (!zvdeep)
+				return NULL;
+			if (!recurse || !zvdeep->hash || zvdeep->parentz != dir)
+				return get_znode_walk (zvdeep->root.child, path, recurse);
+			zn = &zvdeep->root;
+		} else {
+			zn = dir;
+		}
+	}
+	return zn;
+}
+
 static void addvolumesize (struct zvolume *zv, uae_s64 size)
 {
 //	unsigned int blocks = (size + 511) / 512;
@@ -3288,6 +3606,229 @@ struct zvolume *zfile_fopen_archive_root (const TCHAR *filename, int flags)
 #endif
 }
 
+/* Background extraction of mounted archive volumes.
+ *
+ * Worker threads unpack the files of every volume passed to
+ * zfile_prefetch_archive() in archive directory order and leave them in
+ * znode->f, where zfile_open_archive() finds them. The archive handlers
+ * share the archive zfile and decoder handle of a volume, so each volume
+ * has a lock that is held while one of its files is unpacked. A guest open
+ * takes the same lock and workers leave the volume alone while one waits.
+ * Unpacked files that do not fit in the memory budget are moved to host
+ * temporary files.
+ */
+
+#define ZPREFETCH_MAX_THREADS 8
+
+struct zprefetch {
+	struct zprefetch *next;
+	struct zvolume *zv;
+	uae_sem_t lock;
+	struct znode *pos;
+	volatile uae_atomic waiting;
+	int busy;
+	bool abort;
+	int files, spilled;
+	uae_s64 memory;
+};
+
+static uae_sem_t zprefetch_sem;
+static uae_sem_t zprefetch_wake;
+static struct zprefetch *zprefetch_list;
+static uae_thread_id zprefetch_tid[ZPREFETCH_MAX_THREADS];
+static int zprefetch_threads;
+static volatile bool zprefetch_quit;
+static uae_s64 zprefetch_memory, zprefetch_budget;
+
+static void zfile_prefetch_lock (struct zvolume *zv)
+{
+	struct zprefetch *zp = zv->prefetch;
+	if (!zp)
+		return;
+	atomic_inc (&zp->waiting);
+	uae_sem_wait (&zp->lock);
+	atomic_dec (&zp->waiting);
+}
+
+static void zfile_prefetch_unlock (struct zvolume *zv)
+{
+	if (zv->prefetch)
+		uae_sem_post (&zv->prefetch->lock);
+}
+
+static struct zfile *zfile_prefetch_spill (struct zfile *z)
+{
+	FILE *f = tmpfile ();
+	if (!f)
+		return NULL;
+	if (fwrite (z->data, 1, (size_t)z->size, f) != (size_t)z->size) {
+		fclose (f);
+		return NULL;
+	}
+	_fseeki64 (f, 0, SEEK_SET);
+	struct zfile *l = zfile_create (z, NULL);
+	l->name = my_strdup (z->name);
+	l->f = f;
+	l->size = z->size;
+	l->archiveid = z->archiveid;
+	return l;
+}
+
+static struct zfile *zfile_prefetch_store (struct zprefetch *zp, struct zfile *z)
+{
+	bool spill;
+
+	if (!z->data || z->size <= 0)
+		return z;
+	uae_sem_wait (&zprefetch_sem);
+	spill = zprefetch_memory + z->size > zprefetch_budget;
+	if (!spill) {
+		zprefetch_memory += z->size;
+		zp->memory += z->size;
+	}
+	uae_sem_post (&zprefetch_sem);
+	if (spill) {
+		struct zfile *zs = zfile_prefetch_spill (z);
+		if (zs) {
+			zfile_fclose (z);
+			zp->spilled++;
+			return zs;
+		}
+	}
+	return z;
+}
+
+/* unpack the next file of some volume, returns false when there is nothing left to do */
+static bool zfile_prefetch_one (void)
+{
+	struct zprefetch *zp;
+	struct znode *zn = NULL;
+	bool deferred = false;
+
+	uae_sem_wait (&zprefetch_sem);
+	for (zp = zprefetch_list; zp; zp = zp->next) {
+		if (zp->waiting) {
+			deferred = true;
+			continue;
+		}
+		while (zp->pos && (zp->pos->type != ZNODE_FILE || zp->pos->f))
+			zp->pos = zp->pos->next;
+		if (zp->pos) {
+			zn = zp->pos;
+			zp->pos = zn->next;
+			zp->busy++;
+			break;
+		}
+	}
+	uae_sem_post (&zprefetch_sem);
+	if (!zn) {
+		if (deferred)
+			sleep_millis (1);
+		return deferred;
+	}
+
+	uae_sem_wait (&zp->lock);
+	if (!zn->f && !zp->abort) {
+		struct zfile *z = archive_getzfile (zn, zp->zv->id, 0);
+		if (z) {
+			zn->f = zfile_prefetch_store (zp, z);
+			zp->files++;
+		}
+	}
+	uae_sem_post (&zp->lock);
+
+	uae_sem_wait (&zprefetch_sem);
+	zp->busy--;
+	if (!zp->pos && !zp->busy && !zp->abort)
+		write_log (_T("zfile: prefetched %d files of '%s', %d in host cache\n"), zp->files, zp->zv->root.name, zp->spilled);
+	uae_sem_post (&zprefetch_sem);
+	return true;
+}
+
+static int zfile_prefetch_thread (void *v)
+{
+	for (;;) {
+		uae_sem_wait (&zprefetch_wake);
+		if (zprefetch_quit)
+			break;
+		while (!zprefetch_quit && zfile_prefetch_one ());
+	}
+	return 0;
+}
+
+void zfile_prefetch_archive (struct zvolume *zv, int threads, int cachemb)
+{
+	struct zprefetch *zp;
+
+	if (!zv || zv->prefetch || threads <= 0)
+		return;
+	if (threads > ZPREFETCH_MAX_THREADS)
+		threads = ZPREFETCH_MAX_THREADS;
+	if (!zprefetch_sem) {
+		uae_sem_init (&zprefetch_sem, 0, 1);
+		uae_sem_init (&zprefetch_wake, 0, 0);
+		archive_decoder_init ();
+	}
+	zp = xcalloc (struct zprefetch, 1);
+	zp->zv = zv;
+	zp->pos = zv->root.next;
+	uae_sem_init (&zp->lock, 0, 1);
+	zv->prefetch = zp;
+
+	uae_sem_wait (&zprefetch_sem);
+	zprefetch_budget = (uae_s64)cachemb * 1024 * 1024;
+	zp->next = zprefetch_list;
+	zprefetch_list = zp;
+	uae_sem_post (&zprefetch_sem);
+
+	zprefetch_quit = false;
+	while (zprefetch_threads < threads) {
+		if (!uae_start_thread (_T("zfile_prefetch"), zfile_prefetch_thread, NULL, &zprefetch_tid[zprefetch_threads]))
+			break;
+		zprefetch_threads++;
+	}
+	for (int i = 0; i < zprefetch_threads; i++)
+		uae_sem_post (&zprefetch_wake);
+	write_log (_T("zfile: prefetching '%s' with %d threads, %dM memory budget\n"), zv->root.name, zprefetch_threads, cachemb);
+}
+
+static void zfile_prefetch_remove (struct zvolume *zv)
+{
+	struct zprefetch *zp = zv->prefetch;
+	struct zprefetch **pp;
+
+	uae_sem_wait (&zprefetch_sem);
+	zp->abort = true;
+	for (pp = &zprefetch_list; *pp; pp = &(*pp)->next) {
+		if (*pp == zp) {
+			*pp = zp->next;
+			break;
+		}
+	}
+	while (zp->busy) {
+		uae_sem_post (&zprefetch_sem);
+		sleep_millis (1);
+		uae_sem_wait (&zprefetch_sem);
+	}
+	zprefetch_memory -= zp->memory;
+	uae_sem_post (&zprefetch_sem);
+	uae_sem_destroy (&zp->lock);
+	xfree (zp);
+	zv->prefetch = NULL;
+}
+
+static void zfile_prefetch_exit (void)
+{
+	if (!zprefetch_threads)
+		return;
+	zprefetch_quit = true;
+	for (int i = 0; i < zprefetch_threads; i++)
+		uae_sem_post (&zprefetch_wake);
+	for (int i = 0; i < zprefetch_threads; i++)
+		uae_wait_thread (&zprefetch_tid[i]);
+	zprefetch_threads = 0;
+}
+
 void zfile_fclose_archive (struct zvolume *zv)
 {
 	struct znode *zn;
@@ -3295,6 +3836,8 @@ void zfile_fclose_archive (struct zvolume *zv)
 
 	if (!zv)
 		return;
+	if (zv->prefetch)
+		zfile_prefetch_remove (zv);
 	zn = &zv->root;
 	while (zn) {
 		struct znode *zn2 = zn->next;
@@ -3303,6 +3846,7 @@ void zfile_fclose_archive (struct zvolume *zv)
 		xfree (zn->comment);
 		xfree (zn->fullname);
 		xfree (zn->name);
+		xfree (zn->sorted);
 		zfile_fclose (zn->f);
 		memset (zn, 0, sizeof (struct znode));
 		if (zn != &zv->root)
@@ -3325,6 +3869,7 @@ void zfile_fclose_archive (struct zvolume *zv)
 			v = v->next;
 		}
 	}
+	xfree(zv->hash);
 	xfree(zv->volumename);
 	xfree(zv);
 }
@@ -3394,29 +3939,11 @@ int zfile_readdir_archive (struct zdirectory *zd, TCHAR *out, bool fullpath)
 	if (!zd->n || (zd->filenames != NULL && zd->offset >= zd->cnt))
 		return 0;
 	if (zd->filenames == NULL) {
-		struct znode *n = zd->first;
-		int cnt = 0;
-		while (n) {
-			cnt++;
-			n = n->sibling;
-		}
-		n = zd->first;
-		uae_u8 *buf = xmalloc (uae_u8, cnt * sizeof (TCHAR*));
-		zd->filenames = (TCHAR**)buf;
-		buf += cnt * sizeof (TCHAR*);
-		for (int i = 0; i < cnt; i++) {
-			zd->filenames[i] = n->name;
-			n = n->sibling;
-		}
-		for (int i = 0; i < cnt; i++) {
-			for (int j = i + 1; j < cnt; j++) {
-				if (_tcscmp (zd->filenames[i], zd->filenames[j]) > 0) {
-					TCHAR *tmp = zd->filenames[i];
-					zd->filenames[i] = zd->filenames[j];
-					zd->filenames[j] = tmp;
-				}
-			}
-		}
+		int cnt;
+		struct znode **sorted = znode_sorted_children (zd->first->parent, &cnt);
+		zd->filenames = xmalloc (TCHAR*, cnt + 1);
+		for (int i = 0; i < cnt; i++)
+			zd->filenames[i] = sorted[i]->name;
 		zd->cnt = cnt;
 	}
 	if (out == NULL)
@@ -3521,12 +4048,16 @@ struct zfile *zfile_open_archive (const TCHAR *path, int flags)
 {
 	struct zvolume *zv = get_zvolume (path);
 	struct znode *zn = get_znode (zv, path, TRUE);
+	struct zvolume *znv;
 	struct zfile *z;
 
 	if (!zn)
 		return 0;
+	znv = zn->volume;
+	zfile_prefetch_lock (znv);
 	if (zn->f) {
 		zfile_fseek (zn->f, 0, SEEK_SET);
+		zfile_prefetch_unlock (znv);
 		return zn->f;
 	}
 	if (zn->vfile)
@@ -3535,6 +4066,7 @@ struct zfile *zfile_open_archive (const TCHAR *path, int flags)
 	if (z)
 		zfile_fseek (z, 0, SEEK_SET);
 	zn->f = z;
+	zfile_prefetch_unlock (znv);
 	return zn->f;
 }
 
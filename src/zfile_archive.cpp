@@ -26,6 +26,7 @@
 
 #include "fsdb_host.h"
 #include "7z/7zBuf.h"
+#include "threaddep/thread.h"
 
 #define unpack_log write_log
 #undef unpack_log
@@ -2262,6 +2263,30 @@ static struct zfile *archive_access_dir (struct znode *zn)
 }
 
 
+/* The LHA and LZX decoders keep their state in globals. Once background
+ * extraction threads exist, every directory scan and unpack of those formats
+ * is serialized through this lock.
+ */
+static uae_sem_t archive_decoder_sem;
+
+void archive_decoder_init (void)
+{
+	if (!archive_decoder_sem)
+		uae_sem_init (&archive_decoder_sem, 0, 1);
+}
+
+void archive_decoder_lock (void)
+{
+	if (archive_decoder_sem)
+		uae_sem_wait (&archive_decoder_sem);
+}
+
+void archive_decoder_unlock (void)
+{
+	if (archive_decoder_sem)
+		uae_sem_post (&archive_decoder_sem);
+}
+
 struct zfile *archive_unpackzfile (struct zfile *zf)
 {
 	struct zfile *zout = NULL;